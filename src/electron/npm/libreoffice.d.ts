@@ -48,6 +48,32 @@ interface HTMLLibreOfficeEmbed<Client = LibreOffice.DocumentClient>
    * @param interval in ms to debounce
    **/
   debounceUpdates(interval: number): void;
+
+  /** Latency from a key press to the predicted caret and to the updated tiles
+   * being painted, in ms
+   **/
+  getInputLatency(): {
+    keyToCaret: LibreOffice.LatencyStats;
+    keyToPixel: LibreOffice.LatencyStats;
+  };
+  /** Resets the latency returned by getInputLatency **/
+  resetInputLatency(): void;
+  /** Starts recording input, scrolls, zooms, document callbacks and paints
+   * with their timing, replacing any previous recording
+   **/
+  startRecording(): void;
+  /** Stops recording
+   * @returns the recorded session in a compact binary trace
+   **/
+  stopRecording(): ArrayBuffer;
+  /** Switches the slide shown for a presentation. The current slide and its
+   * neighbours are rendered in the background, so switching to them is
+   * immediate.
+   * @param part the zero-based index of the slide
+   * @returns false if the document isn't a presentation or there is no such
+   * slide
+   **/
+  setPart(part: number): boolean;
 }
 
 declare namespace LibreOffice {
@@ -61,6 +87,16 @@ declare namespace LibreOffice {
         buffer: ArrayBuffer;
       };
 
+  type LatencyStats = {
+    count: number;
+    /** in ms */
+    mean: number;
+    /** in ms */
+    max: number;
+    /** in ms */
+    last: number;
+  };
+
   /** Size in CSS pixels */
   type Size = {
     width: number;
@@ -92,6 +128,74 @@ declare namespace LibreOffice {
     payload: T;
   };
 
+  type BinaryEventBatch = {
+    /** the numbers from every payload in the batch */
+    payload: Int32Array;
+    /** the index in payload where the numbers of each event start, an event
+     * without numbers (like an EMPTY invalidate_tiles) starts where the next
+     * one does
+     */
+    offsets: Int32Array;
+    /** events whose payload was in the JSON form used with multiple views,
+     * which have no numbers in payload
+     */
+    json?: { index: number; payload: any }[];
+  };
+
+  type SearchResult = {
+    /** the page containing the match, or the part for documents without pages */
+    page: number;
+    /** the part (sheet or slide) containing the match */
+    part: number;
+    /** the rects of the match, in twips */
+    rects: TwipsRect[];
+  };
+
+  type SearchOptions = {
+    /** find every match instead of the next one, defaults to true */
+    all?: boolean;
+    /** defaults to false */
+    caseSensitive?: boolean;
+    /** search towards the start of the document, defaults to false */
+    backward?: boolean;
+  };
+
+  type TextParagraph = {
+    /** the index of the paragraph in the document */
+    index: number;
+    text: string;
+    /** a stable hash of the text */
+    hash: number;
+    /** the page containing the paragraph, -1 unless positions were requested */
+    page: number;
+    /** the rects of the start of the paragraph, in twips */
+    rects: TwipsRect[];
+  };
+
+  type TextExtractionOptions = {
+    /** the first and last page to extract, inclusive, implies withPositions.
+     * The revision isn't advanced, so the paragraphs changed on other pages
+     * are still yielded for the same since */
+    pages?: [number, number];
+    /** locate each paragraph, from the same pass that reads the text */
+    withPositions?: boolean;
+    /** only extract the paragraphs changed since this revision */
+    since?: number;
+  };
+
+  type TextExtractionSummary = {
+    /** the revision of the extracted text, to pass as since */
+    revision: number;
+    /** the index of the first changed paragraph */
+    start: number;
+    /** the number of paragraphs from since that were replaced at start */
+    removed: number;
+    /** the number of paragraphs yielded in their place */
+    inserted: number;
+    /** since was not the latest revision, so every paragraph was yielded */
+    full: boolean;
+  };
+
   type StateChangedValue =
     | string
     | { commandId: string; value: any; viewId?: number };
@@ -159,6 +263,15 @@ declare namespace LibreOffice {
     '.uno:Highlight': { BackColor: UnoLong };
   }
 
+  type UnoCommandResult<Command = string> = {
+    commandName: Command;
+    success: boolean;
+    result?: any;
+    cancelled?: boolean;
+    /** LOK didn't answer within a minute */
+    timedOut?: boolean;
+  };
+
   type CommandValueResult<R = { [name: string]: any }> = {
     commandValues: R;
   };
@@ -189,6 +302,21 @@ declare namespace LibreOffice {
       callback: DocumentEventHandler<Events, K>
     ): void;
 
+    /**
+     * add an event listener that receives the numbers in the payloads as typed
+     * arrays, for high-frequency events like invalidate_tiles, text_selection
+     * and cell_cursor. Payloads of the same event received before the listener
+     * is called are delivered together in one batch.
+     * @param eventName - the name of the event
+     * @param callback - the callback function
+     * @param options - binary must be true
+     */
+    on<K extends keyof Events = keyof Events>(
+      eventName: K,
+      callback: (batch: BinaryEventBatch) => void,
+      options: { binary: true }
+    ): void;
+
     /**
      * turn off an event listener
      * @param eventName - the name of the event
@@ -219,7 +347,7 @@ declare namespace LibreOffice {
      * posts a UNO command to the document
      * @param command - the uno command to be posted
      * @param args - arguments for the uno command
-     * @param notifyWhenFinished - whether an UNO command result event should be sent for the result
+     * @param notifyWhenFinished - whether an UNO command result event should be sent for the result; the command is still sent immediately
      */
     postUnoCommand<K extends Commands>(
       command: K,
@@ -229,6 +357,26 @@ declare namespace LibreOffice {
       notifyWhenFinished?: boolean
     ): void;
 
+    /**
+     * posts a UNO command to the document off of the renderer thread, commands posted in the same task are sent together
+     * @param command - the uno command to be posted
+     * @param args - arguments for the uno command
+     * @returns the result of the command, or `{ cancelled: true }` if it was cancelled before it ran
+     */
+    postUnoCommandAsync<K extends Commands>(
+      command: K,
+      args?: K extends keyof NonNullable<CommandMap>
+        ? NonNullable<CommandMap>[K]
+        : never
+    ): Promise<UnoCommandResult<K> | undefined>;
+
+    /**
+     * cancels pending commands from postUnoCommandAsync
+     * @param command - the uno command to cancel, all pending commands are cancelled when omitted
+     * @returns the number of cancelled commands
+     */
+    cancelUnoCommand(command?: Commands): number;
+
     /**
      * sets the start or end of a text selection
      * @param type - the text selection type
@@ -237,15 +385,26 @@ declare namespace LibreOffice {
      */
     setTextSelection(type: number, x: number, y: number): void;
 
+    /** same as setTextSelection, but does not block the renderer thread */
+    setTextSelectionAsync(type: number, x: number, y: number): Promise<void>;
+
     /**
      * gets the content of the clipboard for the current view
      * @param mimeTypes - desired MIME types from the clipboard
+     * @param options.lazy - each item's text or buffer is only generated when
+     * it is first read, from the clipboard at that time. Requires mimeTypes.
      * @returns an array of clipboard items
      */
     getClipboard(
-      mimeTypes?: Array<ClipboardItem['mimeType']>
+      mimeTypes?: Array<ClipboardItem['mimeType']>,
+      options?: { lazy?: boolean }
     ): Array<ClipboardItem | undefined>;
 
+    /** same as getClipboard, but does not block the renderer thread */
+    getClipboardAsync(
+      mimeTypes?: Array<ClipboardItem['mimeType']>
+    ): Promise<Array<ClipboardItem | undefined>>;
+
     /**
      * populates the clipboard for the current view with multiple types of content
      * @param clipboardData - array of clipboard items used to populate the clipboard
@@ -253,6 +412,9 @@ declare namespace LibreOffice {
      */
     setClipboard(clipboardData: ClipboardItem[]): boolean;
 
+    /** same as setClipboard, but does not block the renderer thread */
+    setClipboardAsync(clipboardData: ClipboardItem[]): Promise<boolean>;
+
     /**
      * pastes content at the current cursor position
      * @param mimeType - the mime type of the data to paste
@@ -261,6 +423,9 @@ declare namespace LibreOffice {
      */
     paste(mimeType: string, data: string): boolean;
 
+    /** same as paste, but does not block the renderer thread */
+    pasteAsync(mimeType: string, data: string): Promise<boolean>;
+
     /**
      * adjusts the graphic selection
      * @param type - the graphical selection type
@@ -274,6 +439,30 @@ declare namespace LibreOffice {
      */
     resetSelection(): void;
 
+    /**
+     * searches the document for text, a single find selects the match while
+     * a find-all leaves the selection as it was
+     * find-all results are cached until the document is edited, and a search
+     * LOK doesn't answer within a minute resolves with no matches
+     * @param query - the text to search for
+     * @param options - how to search
+     * @returns the matches, empty if there are none
+     */
+    search(query: string, options?: SearchOptions): Promise<SearchResult[]>;
+
+    /**
+     * extracts the text of the document off of the renderer thread, yielding
+     * paragraphs in batches as they are ready. Paragraphs without text have
+     * no position, and the selection is the same after as before
+     * @param onParagraphs - called with each batch of paragraphs, in order
+     * @param options - what to extract
+     * @returns what changed, resolves after the last batch
+     */
+    extractText(
+      onParagraphs: (paragraphs: TextParagraph[]) => void,
+      options?: TextExtractionOptions
+    ): Promise<TextExtractionSummary>;
+
     /**
      * returns a json mapping of the possible values for the given command
      * e.g. {commandName: ".uno:StyleApply", commandValues: {"familyName1" :
@@ -296,6 +485,14 @@ declare namespace LibreOffice {
         }
       | undefined;
 
+    /** same as gotoOutline, but does not block the renderer thread */
+    gotoOutlineAsync(id: number): Promise<
+      | {
+          destRect: string;
+        }
+      | undefined
+    >;
+
     /**
      * saves the document to memory
      * @param [format] - the optional format the document saves to, when omitted docx is used
@@ -327,6 +524,45 @@ declare namespace LibreOffice {
       filter?: string
     ): Promise<boolean>;
 
+    /**
+     * exports the document in the background, unlike saveAs the export can
+     * report its progress and be cancelled. Cancelling deletes the exported
+     * file, even one that was completely written, see ExportJob.cancel
+     * @param url the location where to store the export
+     * @param [options.format] the format to export, deduced from the URL's file extension when omitted
+     * @param [options.filter] options for the export filter, JSON when combined with pageRange
+     * @param [options.pageRange] the 1-based pages to export, ex: '1-3,5', for PDF exports
+     * @param [options.onProgress] called as the export progresses
+     * @returns a handle to the export job
+     */
+    exportAs(
+      url: string,
+      options?: {
+        format?: string;
+        filter?: string;
+        pageRange?: string;
+        onProgress?: (progress: ExportProgress) => void;
+      }
+    ): ExportJob;
+
+    /**
+     * saves the document to a file after a pause in editing, and at most every
+     * `interval` ms while editing never pauses. Edits made after the last
+     * save are lost in a crash.
+     * @param path the file system path of the journal
+     * @param [options.interval] the longest an edit goes unsaved, 30000 by default
+     * @param [options.idle] the pause in editing before a save, 2000 by default
+     * @param [options.format] the format of the saves, as in saveToMemory
+     * @returns false if the options were invalid
+     */
+    startAutosave(
+      path: string,
+      options?: { interval?: number; idle?: number; format?: string }
+    ): boolean;
+
+    /** stops saving, the last save is left in place for recovery */
+    stopAutosave(): void;
+
     /**
      * if the document is ready
      * @returns {boolean}
@@ -343,9 +579,101 @@ declare namespace LibreOffice {
      **/
     newView(): DocumentClient<Events, Commands, CommandMap, GCV>;
 
+    /**
+     * the number of times LOK switched between the views of the document
+     * @returns the total, and the rate since the previous call
+     **/
+    getViewSwitches(): { total: number; perSecond: number };
+
+    /**
+     * the memory held to render the document, in bytes. LOK's own model is
+     * not included.
+     **/
+    getMemoryStats(): MemoryStats;
+    /**
+     * trims the document whenever it holds more than `bytes`, checked every
+     * couple of seconds. The tile pools are not counted, a hidden document
+     * releases its pool when trimmed.
+     * @param bytes 0 removes the limit
+     **/
+    setMemoryLimit(bytes: number): void;
+    /** releases the tiles that aren't visible */
+    trimMemory(): void;
+
     as: import('./lok_api').text.GenericTextDocument['as'];
   }
 
+  type MemoryStats = {
+    /** the tile pools, allocated whether or not tiles are painted */
+    tilePool: number;
+    /** the painted tiles */
+    tiles: number;
+    /** snapshots that no longer share their tiles with a pool */
+    snapshots: number;
+    /** whole-slide surfaces of presentations */
+    slides: number;
+    /** saves and clipboard contents on their way between LOK and JS */
+    pendingBuffers: number;
+    total: number;
+  };
+
+  type ExportProgress = {
+    /** the pages exported so far, estimated from LOK's progress */
+    pages: number;
+    /** the pages being exported, 0 when unknown (spreadsheets) */
+    total: number;
+    percent: number;
+  };
+
+  interface ExportJob {
+    /** resolves to true if the export succeeded, false if it failed or was cancelled */
+    readonly done: Promise<boolean>;
+    readonly progress: ExportProgress;
+    /**
+     * stops the export if it hasn't started, otherwise deletes the file once
+     * LOK finishes writing, even if the export had already completed. Don't
+     * cancel an export whose file should be kept.
+     */
+    cancel(): void;
+  }
+
+  type BlockingStats = {
+    count: number;
+    /** calls that took longer than a frame (16ms) */
+    stalls: number;
+    /** ms */
+    total: number;
+    /** ms */
+    max: number;
+  };
+
+  type EventQueueStats = {
+    events: number;
+    /** tasks that dispatched the queued events */
+    drains: number;
+    /** the most events dispatched by one drain */
+    maxDepth: number;
+    /** ms from LOK emitting an event until it is dispatched */
+    meanLatency: number;
+    /** ms */
+    maxLatency: number;
+  };
+
+  type StartupTimings = {
+    /** waiting for a thread to start initializing */
+    queued: number;
+    /** LOK init, including the configuration registry and user profile */
+    lokInit: number;
+    optionalFeatures: number;
+    total: number;
+    /** whether the LIBREOFFICEKIT_USER_PROFILE directory was used */
+    persistentProfile: boolean;
+    /** whether LOK was preloaded in the zygote, see LIBREOFFICEKIT_PREFORK */
+    preinitialized: boolean;
+    /** creating the UNO bridge, only present after the first call to `as` */
+    unoBridge?: number;
+  };
+
   interface OfficeClient {
     /**
      * set password required for loading or editing a document
@@ -381,7 +709,64 @@ declare namespace LibreOffice {
       buffer: ArrayBuffer
     ): Promise<C | undefined>;
 
+    /**
+     * reads an autosave journal written by DocumentClient.startAutosave
+     * @param path the file system path of the journal
+     * @returns the last save, which can be passed to
+     * loadDocumentFromArrayBuffer, or undefined if there is no complete save
+     */
+    readAutosave(path: string): Promise<{ snapshot: ArrayBuffer } | undefined>;
+
+    /**
+     * reads properties from many UNO objects in one call, much faster than
+     * calling getPropertyValue on each object
+     * @param objects UNO objects from the bridge, ex: paragraphs or cells
+     * @param names the property names to read from every object
+     * @returns a column per name: a Float64Array for numbers, fields
+     * interleaved in a Float64Array for structs of numbers, an Array
+     * otherwise. Properties that can't be read are undefined.
+     */
+    getPropertyValues(
+      objects: any[],
+      names: string[]
+    ):
+      | {
+          [name: string]:
+            | Float64Array
+            | { fields: string[]; values: Float64Array }
+            | any[];
+        }
+      | undefined;
+
+    /**
+     * the memory of every document in the renderer, including stored
+     * snapshots, and the heap of the process, which includes LOK
+     */
+    getMemoryStats(): MemoryStats & { heap: number };
+    /** trims every document in the renderer */
+    trimMemory(): void;
+
     /** gets the last error thrown by LOK */
     getLastError(): string;
+
+    /**
+     * breakdown of the LOK startup in this process, in ms
+     * @returns the timings, or null if LOK has not finished initializing
+     */
+    getStartupTimings(): StartupTimings | null;
+
+    /**
+     * how long synchronous LOK calls have blocked the renderer thread, keyed by method name
+     */
+    getBlockingStats(): { [method: string]: BlockingStats };
+
+    /** clears the stats returned by getBlockingStats */
+    resetBlockingStats(): void;
+
+    /** how document events were batched on their way to the renderer thread */
+    getEventQueueStats(): EventQueueStats;
+
+    /** clears the stats returned by getEventQueueStats */
+    resetEventQueueStats(): void;
   }
 }
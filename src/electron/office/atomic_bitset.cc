@@ -3,46 +3,86 @@
 // found in the LICENSE file.
 
 #include "atomic_bitset.h"
+
+#include <algorithm>
+
 #include "base/check_op.h"
 
 
 namespace electron::office {
 
-AtomicBitset::AtomicBitset() : size_(0), container_count_(0) {}
+AtomicBitset::AtomicBitset() : size_(0), chunk_count_(0) {}
 AtomicBitset::AtomicBitset(size_t size)
     : size_(size),
-      container_count_((size + kBitsPerContainer - 1) / kBitsPerContainer),
-      data_(std::make_unique<AtomicContainer[]>(container_count_)){};
+      chunk_count_(chunk_count(size)),
+      chunks_(std::make_unique<AtomicChunk[]>(chunk_count_)){};
 
-AtomicBitset::~AtomicBitset() = default;
+AtomicBitset::~AtomicBitset() {
+  FreeChunks();
+}
 
 AtomicBitset::AtomicBitset(AtomicBitset&& other) noexcept : AtomicBitset() {
   *this = std::move(other);
 }
 
 AtomicBitset& AtomicBitset::operator=(AtomicBitset&& other) noexcept {
+  FreeChunks();
   size_ = other.size_;
-  container_count_ = other.container_count_;
-  data_ = std::move(other.data_);
+  chunk_count_ = other.chunk_count_;
+  chunks_ = std::move(other.chunks_);
   other.size_ = 0;
-  other.container_count_ = 0;
+  other.chunk_count_ = 0;
   return *this;
 }
 
+void AtomicBitset::FreeChunks() {
+  for (size_t i = 0; i < chunk_count_; i++) {
+    delete[] chunks_[i].load(std::memory_order_acquire);
+  }
+}
+
+AtomicBitset::AtomicContainer* AtomicBitset::FindContainer(
+    size_t container) const {
+  AtomicContainer* chunk = chunks_[container / kContainersPerChunk].load(
+      std::memory_order_acquire);
+  return chunk ? &chunk[container % kContainersPerChunk] : nullptr;
+}
+
+AtomicBitset::AtomicContainer* AtomicBitset::GetOrCreateContainer(
+    size_t container) {
+  AtomicChunk& slot = chunks_[container / kContainersPerChunk];
+  AtomicContainer* chunk = slot.load(std::memory_order_acquire);
+  if (!chunk) {
+    AtomicContainer* created = new AtomicContainer[kContainersPerChunk]();
+    // another thread may have allocated the chunk first
+    if (slot.compare_exchange_strong(chunk, created, std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      chunk = created;
+    } else {
+      delete[] created;
+    }
+  }
+  return &chunk[container % kContainersPerChunk];
+}
+
 bool AtomicBitset::Set(size_t index, std::memory_order order) {
   DCHECK_LT(index, size_);
   DCHECK_GE(index, 0ul);
-  DCHECK(data_);
+  DCHECK(chunks_);
   BitSetContainer mask = kSetBit << bit_index(index);
-  return data_[container_index(index)].fetch_or(mask, order) & mask;
+  return GetOrCreateContainer(container_index(index))->fetch_or(mask, order) &
+         mask;
 }
 
 bool AtomicBitset::Reset(size_t index, std::memory_order order) {
   DCHECK_LT(index, size_);
   DCHECK_GE(index, 0ul);
-  DCHECK(data_);
+  DCHECK(chunks_);
+  AtomicContainer* container = FindContainer(container_index(index));
+  if (!container)
+    return false;
   BitSetContainer mask = kSetBit << bit_index(index);
-  return data_[container_index(index)].fetch_and(~mask, order) & mask;
+  return container->fetch_and(~mask, order) & mask;
 }
 
 void AtomicBitset::ResetRange(size_t index_start,
@@ -53,45 +93,106 @@ void AtomicBitset::ResetRange(size_t index_start,
   DCHECK_GE(index_start, 0ul);
   DCHECK_GE(index_end, 0ul);
   DCHECK_LE(index_start, index_end);
-  DCHECK(data_);
+  DCHECK(chunks_);
 
   const size_t container_start = container_index(index_start);
   const size_t container_end = container_index(index_end);
+  AtomicContainer* container = FindContainer(container_start);
   // single container case
   if (container_end == container_start) {
-    BitSetContainer mask = (kAllBitsSet << index_start) ^
-                     (kAllBitsSet >> (kBitsPerContainer - index_end - 1));
-    data_[container_start].fetch_and(mask, order);
+    if (!container)
+      return;
+    BitSetContainer mask =
+        (kAllBitsSet << bit_index(index_start)) ^
+        (kAllBitsSet >> (kBitsPerContainer - bit_index(index_end) - 1));
+    container->fetch_and(mask, order);
     return;
   }
 
   // all bits at and left to the index are kept
   BitSetContainer mask = ~(kAllBitsSet << bit_index(index_start));
-  data_[container_start].fetch_and(mask, order);
-
-  // the middle containers will be cleared
-  for (size_t i = container_start + 1; i < container_end; i++) {
-    data_[i].store(0, order);
+  if (container)
+    container->fetch_and(mask, order);
+
+  // the middle containers will be cleared, skipping unallocated chunks
+  for (size_t i = container_start + 1; i < container_end;) {
+    const size_t chunk_index = i / kContainersPerChunk;
+    const size_t chunk_end =
+        std::min(container_end, (chunk_index + 1) * kContainersPerChunk);
+    AtomicContainer* chunk =
+        chunks_[chunk_index].load(std::memory_order_acquire);
+    if (!chunk) {
+      i = chunk_end;
+      continue;
+    }
+    for (; i < chunk_end; i++) {
+      chunk[i % kContainersPerChunk].store(0, order);
+    }
   }
 
   // all bits at and right to the index are kept
   mask = ~(kAllBitsSet >> (kBitsPerContainer - bit_index(index_end) - 1));
-  data_[container_end].fetch_and(mask, order);
+  if ((container = FindContainer(container_end)))
+    container->fetch_and(mask, order);
 }
 
 void AtomicBitset::Clear(std::memory_order order) {
-  DCHECK(data_);
-  for (size_t i = 0; i < container_count_; i++) {
-    data_[i].store(0, order);
+  DCHECK(chunks_);
+  for (size_t i = 0; i < chunk_count_; i++) {
+    AtomicContainer* chunk = chunks_[i].load(std::memory_order_acquire);
+    if (!chunk)
+      continue;
+    for (size_t j = 0; j < kContainersPerChunk; j++) {
+      chunk[j].store(0, order);
+    }
+  }
+}
+
+void AtomicBitset::Resize(size_t size) {
+  if (size == size_)
+    return;
+  if (!chunks_) {
+    *this = AtomicBitset(size);
+    return;
+  }
+
+  // bits past the new end must read as unset if the bitset grows again
+  if (size < size_)
+    ResetRange(size, size_ - 1);
+
+  const size_t count = chunk_count(size);
+  auto chunks = std::make_unique<AtomicChunk[]>(count);
+  for (size_t i = 0; i < chunk_count_; i++) {
+    AtomicContainer* chunk = chunks_[i].load(std::memory_order_acquire);
+    if (i < count)
+      chunks[i].store(chunk, std::memory_order_relaxed);
+    else
+      delete[] chunk;
+  }
+
+  size_ = size;
+  chunk_count_ = count;
+  chunks_ = std::move(chunks);
+}
+
+size_t AtomicBitset::AllocatedChunks() const {
+  size_t result = 0;
+  for (size_t i = 0; i < chunk_count_; i++) {
+    if (chunks_[i].load(std::memory_order_relaxed))
+      ++result;
   }
+  return result;
 }
 
 bool AtomicBitset::IsSet(size_t index, std::memory_order order) const {
   DCHECK_LT(index, size_);
   DCHECK_GE(index, 0ul);
-  DCHECK(data_);
+  DCHECK(chunks_);
+  AtomicContainer* container = FindContainer(container_index(index));
+  if (!container)
+    return false;
   BitSetContainer mask = kSetBit << bit_index(index);
-  return data_[container_index(index)].load(order) & mask;
+  return container->load(order) & mask;
 }
 
 bool AtomicBitset::operator[](size_t index) const {
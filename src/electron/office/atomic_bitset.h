@@ -13,6 +13,10 @@ namespace electron::office {
 
 // A mostly thread-safe bitset that initializes with all bits unset.
 // This bitset assumes that its lifetime will outlast the threads using it or that the threads will verify it exists first.
+//
+// Storage is sparse: bits are kept in fixed-size chunks that are only
+// allocated once a bit in them is set, so a bitset sized for a sheet with a
+// million rows costs little more than the regions that were actually touched.
 class AtomicBitset {
  public:
   AtomicBitset();
@@ -34,12 +38,21 @@ class AtomicBitset {
                   std::memory_order order = std::memory_order_seq_cst);
   void Clear(std::memory_order order = std::memory_order_seq_cst);
 
+  // Grows or shrinks the bitset, keeping the bits below the new size.
+  // Like a move, this is not safe while other threads use the bitset.
+  void Resize(size_t size);
+
   size_t Size() const { return size_; }
 
+  // the number of chunks holding bits, for tests and memory accounting
+  size_t AllocatedChunks() const;
+
   bool IsSet(size_t index,
              std::memory_order order = std::memory_order_seq_cst) const;
   bool operator[](size_t index) const;
 
+  static constexpr size_t kContainersPerChunk = 64;
+
  private:
 #if ATOMIC_LLONG_LOCK_FREE == 2
   typedef unsigned long long BitSetContainer;
@@ -50,6 +63,7 @@ class AtomicBitset {
   typedef unsigned int Container;
 #endif
   typedef std::atomic<BitSetContainer> AtomicContainer;
+  typedef std::atomic<AtomicContainer*> AtomicChunk;
 
   static constexpr size_t container_index(size_t index) {
     return index / kBitsPerContainer;
@@ -59,14 +73,24 @@ class AtomicBitset {
     return index % kBitsPerContainer;
   }
 
+  static constexpr size_t chunk_count(size_t size) {
+    return (size + kBitsPerChunk - 1) / kBitsPerChunk;
+  }
+
+  // nullptr if the chunk holding the container was never allocated
+  AtomicContainer* FindContainer(size_t container) const;
+  AtomicContainer* GetOrCreateContainer(size_t container);
+  void FreeChunks();
+
   static constexpr BitSetContainer kSetBit = 1;
   static constexpr BitSetContainer kAllBitsSet = ~0;
   static constexpr size_t kBitsPerContainer =
       std::numeric_limits<BitSetContainer>::digits;
+  static constexpr size_t kBitsPerChunk =
+      kBitsPerContainer * kContainersPerChunk;
   size_t size_;
-  size_t container_count_;
-  std::unique_ptr<AtomicContainer[]> data_;
+  size_t chunk_count_;
+  std::unique_ptr<AtomicChunk[]> chunks_;
 };
 
 }
-
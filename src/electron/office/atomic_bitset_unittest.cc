@@ -143,6 +143,70 @@ TEST(AtomicBitsetTest, ParallelSet) {
   }
 }
 
+TEST(AtomicBitsetTest, SparseSet) {
+  // a sheet with a million rows of tiles
+  constexpr size_t kSize(1024 * 1024 * 8);
+  AtomicBitset set(kSize);
+  EXPECT_EQ(set.AllocatedChunks(), size_t(0));
+
+  EXPECT_FALSE(set.IsSet(kSize - 1));
+  EXPECT_FALSE(set.Reset(kSize - 1));
+  set.ResetRange(0, kSize - 1);
+  set.Clear();
+  EXPECT_EQ(set.AllocatedChunks(), size_t(0));
+
+  set.Set(0);
+  set.Set(1);
+  set.Set(kSize - 1);
+  EXPECT_EQ(set.AllocatedChunks(), size_t(2));
+  EXPECT_TRUE(set[kSize - 1]);
+
+  set.ResetRange(1, kSize - 2);
+  EXPECT_TRUE(set[0]);
+  EXPECT_FALSE(set[1]);
+  EXPECT_TRUE(set[kSize - 1]);
+  EXPECT_EQ(set.AllocatedChunks(), size_t(2));
+}
+
+TEST(AtomicBitsetTest, ResetRangeInContainer) {
+  constexpr size_t kSize(256);
+  AtomicBitset set(kSize);
+  for (size_t i = 0; i < kSize; i++) {
+    set.Set(i);
+  }
+
+  // both ends in a container past the first
+  set.ResetRange(130, 140);
+  EXPECT_TRUE(set[129]);
+  for (size_t i = 130; i <= 140; i++) {
+    ASSERT_FALSE(set.IsSet(i));
+  }
+  EXPECT_TRUE(set[141]);
+}
+
+TEST(AtomicBitsetTest, Resize) {
+  constexpr size_t kSize(10000);
+  AtomicBitset set(kSize);
+  set.Set(10);
+  set.Set(kSize - 1);
+
+  set.Resize(kSize * 2);
+  EXPECT_EQ(set.Size(), kSize * 2);
+  EXPECT_TRUE(set[10]);
+  EXPECT_TRUE(set[kSize - 1]);
+  EXPECT_FALSE(set[kSize]);
+
+  set.Set(4000);
+  set.Resize(4000);
+  EXPECT_TRUE(set[10]);
+  EXPECT_EQ(set.AllocatedChunks(), size_t(1));
+
+  // bits beyond a shrink don't come back
+  set.Resize(kSize);
+  EXPECT_FALSE(set[4000]);
+  EXPECT_FALSE(set[kSize - 1]);
+}
+
 #if DCHECK_IS_ON()
 
 TEST(AtomicBitsetDeathTest, OutOfBounds) {
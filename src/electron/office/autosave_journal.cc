@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/autosave_journal.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/hash/hash.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace electron::office {
+
+namespace {
+// size and checksum, each a little-endian uint32
+constexpr size_t kHeaderSize = sizeof(uint32_t);
+constexpr size_t kTrailerSize = sizeof(uint32_t);
+
+void PutUint32(uint32_t value, uint8_t* out) {
+  for (size_t i = 0; i < sizeof(uint32_t); ++i)
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t GetUint32(const uint8_t* in) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < sizeof(uint32_t); ++i)
+    value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  return value;
+}
+
+std::vector<uint8_t> EncodeRecord(base::span<const uint8_t> data) {
+  std::vector<uint8_t> record(kHeaderSize + data.size() + kTrailerSize);
+  PutUint32(base::checked_cast<uint32_t>(data.size()), record.data());
+  std::copy(data.begin(), data.end(), record.begin() + kHeaderSize);
+  PutUint32(base::PersistentHash(data),
+            record.data() + kHeaderSize + data.size());
+  return record;
+}
+}  // namespace
+
+AutosaveJournal::AutosaveJournal(const base::FilePath& path) : path_(path) {}
+
+AutosaveJournal::~AutosaveJournal() = default;
+
+bool AutosaveJournal::Compact(base::span<const uint8_t> snapshot) {
+  const base::FilePath temp_path = path_.AddExtensionASCII("tmp");
+  if (!base::WriteFile(temp_path, EncodeRecord(snapshot)))
+    return false;
+
+  if (!base::ReplaceFile(temp_path, path_, nullptr)) {
+    base::DeleteFile(temp_path);
+    return false;
+  }
+  return true;
+}
+
+// static
+bool AutosaveJournal::Read(const base::FilePath& path, std::string* snapshot) {
+  std::string journal;
+  if (!base::ReadFileToString(path, &journal) ||
+      journal.size() < kHeaderSize + kTrailerSize)
+    return false;
+
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(journal.data());
+  const size_t size = GetUint32(data);
+  if (size != journal.size() - kHeaderSize - kTrailerSize)
+    return false;
+
+  base::span<const uint8_t> payload(data + kHeaderSize, size);
+  if (GetUint32(data + kHeaderSize + size) != base::PersistentHash(payload))
+    return false;
+
+  snapshot->assign(reinterpret_cast<const char*>(payload.data()), size);
+  return true;
+}
+
+}  // namespace electron::office
@@ -0,0 +1,44 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "base/containers/span.h"
+#include "base/files/file_path.h"
+
+namespace electron::office {
+
+// An autosave file: the last full save of a document.
+//
+// A save is written next to the file and swapped in once complete, so the
+// previous save is kept until the new one is, and the record carries a
+// checksum, so a save cut short by a crash is never read back.
+//
+// Blocking, so it belongs on a sequence that may block.
+class AutosaveJournal {
+ public:
+  explicit AutosaveJournal(const base::FilePath& path);
+  ~AutosaveJournal();
+
+  AutosaveJournal(const AutosaveJournal&) = delete;
+  AutosaveJournal& operator=(const AutosaveJournal&) = delete;
+
+  // Replaces the journal with a full save, the previous journal is kept
+  // until the new one is completely written
+  bool Compact(base::span<const uint8_t> snapshot);
+
+  const base::FilePath& path() const { return path_; }
+
+  // Reads the last full save of a journal, false if there is no journal or
+  // it was never completely written
+  static bool Read(const base::FilePath& path, std::string* snapshot);
+
+ private:
+  const base::FilePath path_;
+};
+
+}  // namespace electron::office
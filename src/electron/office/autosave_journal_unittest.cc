@@ -0,0 +1,57 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/autosave_journal.h"
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+namespace {
+base::span<const uint8_t> AsBytes(base::StringPiece str) {
+  return base::as_bytes(base::make_span(str));
+}
+}  // namespace
+
+TEST(AutosaveJournalTest, ReplacesSave) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.GetPath().AppendASCII("doc.journal");
+
+  std::string snapshot;
+  EXPECT_FALSE(AutosaveJournal::Read(path, &snapshot));
+
+  AutosaveJournal journal(path);
+  EXPECT_TRUE(journal.Compact(AsBytes("first save")));
+  ASSERT_TRUE(AutosaveJournal::Read(path, &snapshot));
+  EXPECT_EQ(snapshot, "first save");
+
+  EXPECT_TRUE(journal.Compact(AsBytes("second save")));
+  ASSERT_TRUE(AutosaveJournal::Read(path, &snapshot));
+  EXPECT_EQ(snapshot, "second save");
+  EXPECT_FALSE(base::PathExists(path.AddExtensionASCII("tmp")));
+}
+
+TEST(AutosaveJournalTest, IgnoresTruncatedSave) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.GetPath().AppendASCII("doc.journal");
+
+  {
+    AutosaveJournal journal(path);
+    EXPECT_TRUE(journal.Compact(AsBytes("full save")));
+  }
+
+  // a crash while writing
+  std::string bytes;
+  ASSERT_TRUE(base::ReadFileToString(path, &bytes));
+  ASSERT_TRUE(base::WriteFile(path, bytes.substr(0, bytes.size() - 1)));
+
+  std::string snapshot;
+  EXPECT_FALSE(AutosaveJournal::Read(path, &snapshot));
+}
+
+}  // namespace electron::office
@@ -0,0 +1,57 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/blocking_watchdog.h"
+
+#include "base/logging.h"
+#include "base/no_destructor.h"
+
+// Uncomment to log every call that stalls
+// #define DEBUG_BLOCKING
+
+namespace electron::office {
+
+BlockingWatchdog::Scope::Scope(const char* name)
+    : name_(name), start_(base::TimeTicks::Now()) {}
+
+BlockingWatchdog::Scope::~Scope() {
+  BlockingWatchdog::Get()->Record(name_, base::TimeTicks::Now() - start_);
+}
+
+// static
+BlockingWatchdog* BlockingWatchdog::Get() {
+  static base::NoDestructor<BlockingWatchdog> instance;
+  return instance.get();
+}
+
+BlockingWatchdog::BlockingWatchdog() = default;
+BlockingWatchdog::~BlockingWatchdog() = default;
+
+void BlockingWatchdog::Record(const char* name, base::TimeDelta elapsed) {
+  const bool stalled = elapsed > kStallThreshold;
+#ifdef DEBUG_BLOCKING
+  if (stalled)
+    LOG(ERROR) << name << " blocked for " << elapsed.InMillisecondsF() << "ms";
+#endif
+
+  base::AutoLock lock(lock_);
+  Stats& stats = stats_[name];
+  stats.count++;
+  stats.total += elapsed;
+  stats.max = std::max(stats.max, elapsed);
+  if (stalled)
+    stats.stalls++;
+}
+
+std::map<std::string, BlockingWatchdog::Stats> BlockingWatchdog::GetStats() {
+  base::AutoLock lock(lock_);
+  return stats_;
+}
+
+void BlockingWatchdog::Reset() {
+  base::AutoLock lock(lock_);
+  stats_.clear();
+}
+
+}  // namespace electron::office
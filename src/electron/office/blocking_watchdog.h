@@ -0,0 +1,64 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+
+namespace electron::office {
+
+// Records how long synchronous LOK calls block the thread that makes them, so
+// that the calls which still stall the renderer can be found and moved off of
+// it
+class BlockingWatchdog {
+ public:
+  // a call longer than a frame is counted as a stall
+  static constexpr base::TimeDelta kStallThreshold = base::Milliseconds(16);
+
+  struct Stats {
+    int count = 0;
+    int stalls = 0;
+    base::TimeDelta total;
+    base::TimeDelta max;
+  };
+
+  // Times the enclosing block under `name`, which must be a string literal
+  class Scope {
+   public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+    // disable copy
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const char* name_;
+    const base::TimeTicks start_;
+  };
+
+  static BlockingWatchdog* Get();
+
+  BlockingWatchdog();
+  ~BlockingWatchdog();
+
+  // disable copy
+  BlockingWatchdog(const BlockingWatchdog&) = delete;
+  BlockingWatchdog& operator=(const BlockingWatchdog&) = delete;
+
+  void Record(const char* name, base::TimeDelta elapsed);
+  std::map<std::string, Stats> GetStats();
+  void Reset();
+
+ private:
+  base::Lock lock_;
+  std::map<std::string, Stats> stats_ GUARDED_BY(lock_);
+};
+
+}  // namespace electron::office
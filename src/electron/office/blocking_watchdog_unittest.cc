@@ -0,0 +1,39 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/blocking_watchdog.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(BlockingWatchdogTest, RecordsCalls) {
+  BlockingWatchdog watchdog;
+  watchdog.Record("fast", base::Milliseconds(1));
+  watchdog.Record("fast", base::Milliseconds(3));
+  watchdog.Record("slow", BlockingWatchdog::kStallThreshold * 2);
+
+  auto stats = watchdog.GetStats();
+  ASSERT_EQ(stats.size(), size_t(2));
+  EXPECT_EQ(stats["fast"].count, 2);
+  EXPECT_EQ(stats["fast"].stalls, 0);
+  EXPECT_EQ(stats["fast"].total, base::Milliseconds(4));
+  EXPECT_EQ(stats["fast"].max, base::Milliseconds(3));
+  EXPECT_EQ(stats["slow"].count, 1);
+  EXPECT_EQ(stats["slow"].stalls, 1);
+}
+
+TEST(BlockingWatchdogTest, Reset) {
+  BlockingWatchdog watchdog;
+  watchdog.Record("call", base::Milliseconds(1));
+  watchdog.Reset();
+  EXPECT_TRUE(watchdog.GetStats().empty());
+}
+
+TEST(BlockingWatchdogTest, ScopeRecordsToSingleton) {
+  BlockingWatchdog::Get()->Reset();
+  { BlockingWatchdog::Scope scope("scoped"); }
+  EXPECT_EQ(BlockingWatchdog::Get()->GetStats()["scoped"].count, 1);
+}
+
+}  // namespace electron::office
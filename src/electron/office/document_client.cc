@@ -5,21 +5,33 @@
 #include "office/document_client.h"
 #include <sys/types.h>
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <string_view>
 #include <vector>
 #include "LibreOfficeKit/LibreOfficeKit.hxx"
 #include "base/bind.h"
+#include "base/json/json_reader.h"
+#include "base/files/file_path.h"
+#include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/memory/scoped_refptr.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/process/memory.h"
+#include "base/ranges/algorithm.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/task/thread_pool.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "gin/converter.h"
 #include "gin/dictionary.h"
 #include "gin/handle.h"
 #include "gin/object_template_builder.h"
 #include "gin/per_isolate_data.h"
+#include "office/blocking_watchdog.h"
 #include "office/document_holder.h"
+#include "office/export_job.h"
 #include "office/lok_callback.h"
 #include "office/office_client.h"
 #include "office/office_instance.h"
@@ -77,6 +89,79 @@ std::unique_ptr<char[]> jsonStringify(const v8::Local<v8::Context>& context,
   return v8_stringify(context, str_object);
 }
 
+// resolves with the parsed JSON result of a LOK call, or undefined
+void ResolveWithJSON(Promise<v8::Value> promise,
+                     LokStrPtr result,
+                     base::WeakPtr<OfficeClient> office) {
+  promise.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](Promise<v8::Value> promise, LokStrPtr result,
+             base::WeakPtr<OfficeClient> office) {
+            if (!office.MaybeValid())
+              return;
+            if (!result)
+              return promise.Resolve();
+            v8::Isolate* isolate = promise.isolate();
+            v8::HandleScope handle_scope(isolate);
+            v8::MicrotasksScope microtasks_scope(
+                isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+            v8::Context::Scope context_scope(promise.GetContext());
+
+            v8::Local<v8::String> json_str;
+            if (!v8::String::NewFromUtf8(isolate, result.get())
+                     .ToLocal(&json_str)) {
+              return promise.Resolve();
+            }
+            promise.Resolve(v8::JSON::Parse(promise.GetContext(), json_str)
+                                .FromMaybe(v8::Local<v8::Value>()));
+          },
+          std::move(promise), std::move(result), std::move(office)));
+}
+
+// how often a memory limit is checked
+constexpr base::TimeDelta kMemoryLimitInterval = base::Seconds(2);
+
+// how long a UNO command waits for its result, longer than any command that
+// doesn't block on a dialog
+constexpr base::TimeDelta kUnoCommandResultTimeout = base::Seconds(60);
+
+// how long a search waits for LOK to report its matches
+constexpr base::TimeDelta kSearchResultTimeout = base::Seconds(60);
+constexpr int kSearchResultEvents[] = {LOK_CALLBACK_SEARCH_RESULT_SELECTION,
+                                       LOK_CALLBACK_SEARCH_NOT_FOUND};
+
+// resolves a command that LOK never answered
+void ResolveUnanswered(Promise<v8::Value>& promise,
+                       const std::string& command,
+                       const char* reason) {
+  v8::Isolate* isolate = promise.isolate();
+  v8::HandleScope handle_scope(isolate);
+  v8::MicrotasksScope microtasks_scope(
+      isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+  v8::Context::Scope context_scope(promise.GetContext());
+  gin::Dictionary result = gin::Dictionary::CreateEmpty(isolate);
+  result.Set("commandName", command);
+  result.Set("success", false);
+  result.Set(reason, true);
+  promise.Resolve(gin::ConvertToV8(isolate, result));
+}
+
+// whether a UNO command can change the contents of the document, and so the
+// results of a search and the autosave. Moving the cursor or the selection,
+// zooming, copying and saving don't.
+bool MayEditDocument(const std::string& command) {
+  static constexpr std::string_view kReadOnlyPrefixes[] = {
+      ".uno:Go", ".uno:Select", ".uno:Zoom"};
+  static constexpr std::string_view kReadOnly[] = {
+      ".uno:ExecuteSearch", ".uno:Copy", ".uno:Save", ".uno:Print"};
+  return base::ranges::none_of(kReadOnlyPrefixes,
+                               [&](std::string_view prefix) {
+                                 return base::StartsWith(command, prefix);
+                               }) &&
+         base::ranges::find(kReadOnly, command) == std::end(kReadOnly);
+}
+
 }  // namespace
 
 DocumentClient::DocumentClient() = default;
@@ -96,9 +181,11 @@ DocumentClient::DocumentClient(DocumentHolderWithView holder)
     event_types_registered_.emplace(event_type);
   }
   OfficeInstance::Get()->AddDestroyedObserver(this);
+  AddDocumentMemoryConsumer(this);
 }
 
 DocumentClient::~DocumentClient() {
+  RemoveDocumentMemoryConsumer(this);
   if (document_holder_) {
     document_holder_.RemoveDocumentObservers();
   }
@@ -123,19 +210,36 @@ gin::ObjectTemplateBuilder DocumentClient::GetObjectTemplateBuilder(
       .SetMethod("off", &DocumentClient::Off)
       .SetMethod("emit", &DocumentClient::Emit)
       .SetMethod("postUnoCommand", &DocumentClient::PostUnoCommand)
+      .SetMethod("postUnoCommandAsync", &DocumentClient::PostUnoCommandAsync)
+      .SetMethod("cancelUnoCommand", &DocumentClient::CancelUnoCommand)
       .SetMethod("setAuthor", &DocumentClient::SetAuthor)
       .SetMethod("gotoOutline", &DocumentClient::GotoOutline)
+      .SetMethod("gotoOutlineAsync", &DocumentClient::GotoOutlineAsync)
       .SetMethod("saveToMemory", &DocumentClient::SaveToMemory)
       .SetMethod("saveAs", &DocumentClient::SaveAs)
+      .SetMethod("exportAs", &DocumentClient::ExportAs)
+      .SetMethod("startAutosave", &DocumentClient::StartAutosave)
+      .SetMethod("stopAutosave", &DocumentClient::StopAutosave)
       .SetMethod("setTextSelection", &DocumentClient::SetTextSelection)
+      .SetMethod("setTextSelectionAsync",
+                 &DocumentClient::SetTextSelectionAsync)
       .SetMethod("getClipboard", &DocumentClient::GetClipboard)
+      .SetMethod("getClipboardAsync", &DocumentClient::GetClipboardAsync)
       .SetMethod("setClipboard", &DocumentClient::SetClipboard)
+      .SetMethod("setClipboardAsync", &DocumentClient::SetClipboardAsync)
       .SetMethod("paste", &DocumentClient::Paste)
+      .SetMethod("pasteAsync", &DocumentClient::PasteAsync)
       .SetMethod("setGraphicSelection", &DocumentClient::SetGraphicSelection)
       .SetMethod("resetSelection", &DocumentClient::ResetSelection)
       .SetMethod("getCommandValues", &DocumentClient::GetCommandValues)
       .SetMethod("as", &DocumentClient::As)
+      .SetMethod("search", &DocumentClient::Search)
+      .SetMethod("extractText", &DocumentClient::ExtractText)
       .SetMethod("newView", &DocumentClient::NewView)
+      .SetMethod("getViewSwitches", &DocumentClient::GetViewSwitches)
+      .SetMethod("getMemoryStats", &DocumentClient::GetMemoryStats)
+      .SetMethod("setMemoryLimit", &DocumentClient::SetMemoryLimit)
+      .SetMethod("trimMemory", &DocumentClient::TrimMemory)
       .SetProperty("isReady", &DocumentClient::IsReady)
       .SetMethod("initializeForRendering",
                  &DocumentClient::InitializeForRendering);
@@ -149,8 +253,12 @@ bool DocumentClient::IsReady() const {
   return is_ready_;
 }
 
-std::vector<gfx::Rect> DocumentClient::PageRects() const {
-  return page_rects_;
+const std::vector<gfx::Rect>& DocumentClient::PageRects() const {
+  return page_geometry_.Rects();
+}
+
+const PageGeometry& DocumentClient::Geometry() const {
+  return page_geometry_;
 }
 
 gfx::Size DocumentClient::DocumentSizeTwips() {
@@ -239,9 +347,13 @@ void DocumentClient::HandleStateChange(const std::string& payload) {
 	std::string_view sv = payload;
   if (sv.substr(0, uno_undo.length()) == uno_undo) {
 		can_undo_ = sv.substr(uno_undo.length()) == "enabled";
+    // the undo stack changing means that the document was edited
+    InvalidateSearchCache();
+    MarkAutosaveDirty();
   }
   if (sv.substr(0, uno_redo.length()) == uno_redo) {
 		can_redo_ = sv.substr(uno_redo.length()) == "enabled";
+    InvalidateSearchCache();
   }
 
   if (!is_ready_) {
@@ -249,34 +361,101 @@ void DocumentClient::HandleStateChange(const std::string& payload) {
   }
 }
 
-void DocumentClient::HandleDocSizeChanged() {
-  RefreshSize();
+namespace {
+
+struct DocumentGeometry {
+  long width_twips = 0;
+  long height_twips = 0;
+  // unparsed, so that only the pages after the first change are parsed again
+  std::string page_rects;
+};
+
+DocumentGeometry QueryDocumentGeometry(const DocumentHolderWithView& holder) {
+  DocumentGeometry result;
+  holder->getDocumentSize(&result.width_twips, &result.height_twips);
+
+  LokStrPtr page_rect(holder->getPartPageRectangles());
+  if (page_rect)
+    result.page_rects = page_rect.get();
+  return result;
+}
+
+}  // namespace
+
+// getPartPageRectangles is slow on large documents, so the refresh happens off
+// of the renderer thread and the event is only forwarded once it is applied
+void DocumentClient::HandleDocSizeChanged(std::string payload) {
+  const uint64_t generation = ++size_refresh_generation_;
+  document_holder_.PostBlocking(base::BindOnce(
+      [](scoped_refptr<base::SequencedTaskRunner> reply_runner,
+         base::WeakPtr<DocumentClient> client, uint64_t generation,
+         std::string payload, DocumentHolderWithView holder) {
+        DocumentGeometry geometry = QueryDocumentGeometry(holder);
+        reply_runner->PostTask(
+            FROM_HERE,
+            base::BindOnce(&DocumentClient::OnSizeRefreshed, client,
+                           generation, geometry.width_twips,
+                           geometry.height_twips, std::move(geometry.page_rects),
+                           std::move(payload)));
+      },
+      base::SequencedTaskRunnerHandle::Get(), GetWeakPtr(), generation,
+      std::move(payload)));
+}
+
+void DocumentClient::OnSizeRefreshed(uint64_t generation,
+                                     long width_twips,
+                                     long height_twips,
+                                     std::string page_rects,
+                                     std::string payload) {
+  // a newer refresh is in flight
+  if (generation != size_refresh_generation_)
+    return;
+
+  document_width_in_twips_ = width_twips;
+  document_height_in_twips_ = height_twips;
+  page_geometry_.Update(page_rects);
+  ForwardEmit(LOK_CALLBACK_DOCUMENT_SIZE_CHANGED, payload);
 }
 
 void DocumentClient::HandleInvalidate() {
   is_ready_ = true;
+  // typed input and mouse edits don't go through UNO commands, but do
+  // invalidate what they changed
+  MarkAutosaveDirty();
 }
 
 void DocumentClient::RefreshSize() {
-  document_holder_->getDocumentSize(&document_width_in_twips_,
-                                    &document_height_in_twips_);
-
-  LokStrPtr page_rect(document_holder_->getPartPageRectangles());
-  std::string_view page_rect_sv(page_rect.get());
-  std::string_view::const_iterator start = page_rect_sv.begin();
-  int new_size = GetNumberOfPages();
-  page_rects_ =
-      lok_callback::ParseMultipleRects(start, page_rect_sv.end(), new_size);
+  BlockingWatchdog::Scope watchdog("refreshSize");
+  DocumentGeometry geometry = QueryDocumentGeometry(document_holder_);
+  document_width_in_twips_ = geometry.width_twips;
+  document_height_in_twips_ = geometry.height_twips;
+  page_geometry_.Update(geometry.page_rects);
 }
 
 void DocumentClient::On(v8::Isolate* isolate,
                         const std::u16string& event_name,
-                        v8::Local<v8::Function> listener_callback) {
+                        v8::Local<v8::Function> listener_callback,
+                        gin::Arguments* args) {
   int type = lok_callback::EventStringToType(event_name);
   if (type < 0) {
     LOG(ERROR) << "on, unknown event: " << event_name;
   }
-  event_listeners_[type].emplace_back(isolate, listener_callback);
+
+  bool binary = false;
+  gin::Dictionary options(isolate);
+  if (args->GetNext(&options))
+    options.Get("binary", &binary);
+  if (binary && !lok_callback::IsTypeCSV(type) &&
+      !lok_callback::IsTypeMultipleCSV(type)) {
+    LOG(ERROR) << "on, binary payloads are unsupported for: " << event_name;
+    binary = false;
+  }
+
+  if (binary) {
+    binary_event_listeners_[type].emplace_back(isolate, listener_callback);
+  } else {
+    event_listeners_[type].emplace_back(isolate, listener_callback);
+  }
   if (event_types_registered_.emplace(type).second) {
     document_holder_.AddDocumentObserver(type, this);
   }
@@ -295,6 +474,13 @@ void DocumentClient::Off(const std::u16string& event_name,
   if (type < 0) {
     LOG(ERROR) << "off, unknown event: " << event_name;
   }
+  auto binary_itr = binary_event_listeners_.find(type);
+  if (binary_itr != binary_event_listeners_.end()) {
+    auto& vec = binary_itr->second;
+    vec.erase(std::remove(vec.begin(), vec.end(), listener_callback),
+              vec.end());
+  }
+
   auto itr = event_listeners_.find(type);
   if (itr == event_listeners_.end())
     return;
@@ -327,6 +513,7 @@ void DocumentClient::Emit(v8::Isolate* isolate,
 
 v8::Local<v8::Value> DocumentClient::GotoOutline(int idx,
                                                  gin::Arguments* args) {
+  BlockingWatchdog::Scope watchdog("gotoOutline");
   LokStrPtr result(document_holder_->gotoOutline(idx));
   v8::Isolate* isolate = args->isolate();
 
@@ -344,6 +531,26 @@ v8::Local<v8::Value> DocumentClient::GotoOutline(int idx,
       .FromMaybe(v8::Local<v8::Value>());
 }
 
+v8::Local<v8::Promise> DocumentClient::GotoOutlineAsync(int idx,
+                                                        gin::Arguments* args) {
+  Promise<v8::Value> promise(args->isolate());
+  auto handle = promise.GetHandle();
+
+  document_holder_.PostBlocking(
+      UnoCommandTaskRunner(),
+      base::BindOnce(
+          [](Promise<v8::Value> promise, int idx,
+             base::WeakPtr<OfficeClient> office,
+             DocumentHolderWithView holder) {
+            LokStrPtr result(holder->gotoOutline(idx));
+            ResolveWithJSON(std::move(promise), std::move(result),
+                            std::move(office));
+          },
+          std::move(promise), idx, OfficeClient::GetWeakPtr()));
+
+  return handle;
+}
+
 namespace {
 #if BUILDFLAG(IS_WIN)
 extern "C" void* (*const malloc_unchecked)(size_t);
@@ -373,6 +580,7 @@ v8::Local<v8::Promise> DocumentClient::SaveToMemory(v8::Isolate* isolate,
 
   document_holder_.PostBlocking(base::BindOnce(
       [](Promise<v8::Value> promise, std::unique_ptr<char[]> format,
+         PendingBuffer::Counter pending_buffer_bytes,
          base::WeakPtr<OfficeClient> office, DocumentHolderWithView holder) {
         if (!office.MaybeValid())
           return;
@@ -389,7 +597,7 @@ v8::Local<v8::Promise> DocumentClient::SaveToMemory(v8::Isolate* isolate,
             FROM_HERE,
             base::BindOnce(
                 [](Promise<v8::Value> promise, char* data, size_t size,
-                   base::WeakPtr<OfficeClient> office) {
+                   PendingBuffer pending, base::WeakPtr<OfficeClient> office) {
                   if (!office.MaybeValid())
                     return;
                   v8::Isolate* isolate = promise.isolate();
@@ -408,15 +616,19 @@ v8::Local<v8::Promise> DocumentClient::SaveToMemory(v8::Isolate* isolate,
                       v8::ArrayBuffer::New(isolate, std::move(backing_store));
                   promise.Resolve(std::move(array_buffer));
                 },
-                std::move(promise), pOutput, size, std::move(office)));
+                std::move(promise), pOutput, size,
+                PendingBuffer(std::move(pending_buffer_bytes), size),
+                std::move(office)));
       },
-      std::move(promise), std::move(format), OfficeClient::GetWeakPtr()));
+      std::move(promise), std::move(format), pending_buffer_bytes_,
+      OfficeClient::GetWeakPtr()));
 
   return handle;
 }
 
 void DocumentClient::SetAuthor(const std::string& author,
                                gin::Arguments* args) {
+  BlockingWatchdog::Scope watchdog("setAuthor");
   document_holder_->setAuthor(author.c_str());
 }
 
@@ -440,24 +652,307 @@ void DocumentClient::PostUnoCommand(const std::string& command,
 void DocumentClient::PostUnoCommandInternal(const std::string& command,
                                             std::unique_ptr<char[]> json_buffer,
                                             bool notifyWhenFinished) {
+  BlockingWatchdog::Scope watchdog("postUnoCommand");
+  if (notifyWhenFinished) {
+    // the result can't be told apart from those of postUnoCommandAsync, so
+    // it is registered before LOK can answer, ahead of the async commands
+    // that haven't been flushed to the UNO sequence yet
+    ObserveUnoCommandResults();
+    auto& pending = pending_uno_results_[command];
+    auto position = pending.end();
+    if (!queued_uno_commands_.empty()) {
+      const uint64_t first_unsent = queued_uno_commands_.front().id;
+      position = base::ranges::find_if(
+          pending, [first_unsent](const PendingUnoResult& entry) {
+            return entry.id >= first_unsent;
+          });
+    }
+    pending.emplace(position, next_uno_command_id_++, nullptr, absl::nullopt,
+                    base::TimeTicks::Now() + kUnoCommandResultTimeout);
+  }
+
+  if (MayEditDocument(command)) {
+    InvalidateSearchCache();
+    MarkAutosaveDirty();
+  }
   document_holder_->postUnoCommand(command.c_str(), json_buffer.get(),
                                    notifyWhenFinished);
 }
 
+DocumentClient::UnoCommandRequest::UnoCommandRequest(
+    uint64_t id,
+    std::string command,
+    std::unique_ptr<char[]> args,
+    CancelFlagPtr cancel_flag)
+    : id(id),
+      command(std::move(command)),
+      args(std::move(args)),
+      cancel_flag(std::move(cancel_flag)) {}
+DocumentClient::UnoCommandRequest::~UnoCommandRequest() = default;
+DocumentClient::UnoCommandRequest::UnoCommandRequest(UnoCommandRequest&&) =
+    default;
+DocumentClient::UnoCommandRequest&
+DocumentClient::UnoCommandRequest::operator=(UnoCommandRequest&&) = default;
+
+DocumentClient::PendingUnoResult::PendingUnoResult(
+    uint64_t id,
+    CancelFlagPtr cancel_flag,
+    absl::optional<Promise<v8::Value>> promise,
+    base::TimeTicks deadline)
+    : id(id),
+      cancel_flag(std::move(cancel_flag)),
+      promise(std::move(promise)),
+      deadline(deadline),
+      settled(!this->promise) {}
+DocumentClient::PendingUnoResult::~PendingUnoResult() = default;
+DocumentClient::PendingUnoResult::PendingUnoResult(PendingUnoResult&&) =
+    default;
+DocumentClient::PendingUnoResult& DocumentClient::PendingUnoResult::operator=(
+    PendingUnoResult&&) = default;
+
+v8::Local<v8::Promise> DocumentClient::PostUnoCommandAsync(
+    const std::string& command,
+    gin::Arguments* args) {
+  Promise<v8::Value> promise(args->isolate());
+  auto handle = promise.GetHandle();
+
+  v8::Local<v8::Value> arguments;
+  std::unique_ptr<char[]> json_buffer;
+  if (args->GetNext(&arguments) && !arguments->IsUndefined()) {
+    json_buffer = jsonStringify(args->GetHolderCreationContext(), arguments);
+    if (!json_buffer) {
+      promise.Resolve();
+      return handle;
+    }
+  }
+
+  if (!isolate_)
+    isolate_ = args->isolate();
+
+  QueueUnoCommand(command, std::move(json_buffer), std::move(promise));
+  return handle;
+}
+
+void DocumentClient::QueueUnoCommand(
+    const std::string& command,
+    std::unique_ptr<char[]> json_buffer,
+    absl::optional<Promise<v8::Value>> promise) {
+  ObserveUnoCommandResults();
+
+  const uint64_t id = next_uno_command_id_++;
+  CancelFlagPtr cancel_flag = CancelFlag::Create();
+  pending_uno_results_[command].emplace_back(
+      id, cancel_flag, std::move(promise),
+      base::TimeTicks::Now() + kUnoCommandResultTimeout);
+  queued_uno_commands_.emplace_back(id, command, std::move(json_buffer),
+                                    std::move(cancel_flag));
+
+  if (!uno_flush_scheduled_) {
+    uno_flush_scheduled_ = true;
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&DocumentClient::FlushUnoCommands, GetWeakPtr()));
+  }
+}
+
+void DocumentClient::ObserveUnoCommandResults() {
+  if (event_types_registered_.emplace(LOK_CALLBACK_UNO_COMMAND_RESULT)
+          .second) {
+    document_holder_.AddDocumentObserver(LOK_CALLBACK_UNO_COMMAND_RESULT,
+                                         this);
+  }
+  if (!uno_result_timer_.IsRunning()) {
+    uno_result_timer_.Start(FROM_HERE, kUnoCommandResultTimeout, this,
+                            &DocumentClient::ExpireUnoResults);
+  }
+}
+
+void DocumentClient::FlushUnoCommands() {
+  uno_flush_scheduled_ = false;
+  if (queued_uno_commands_.empty())
+    return;
+
+  if (base::ranges::any_of(queued_uno_commands_,
+                           [](const UnoCommandRequest& request) {
+                             return MayEditDocument(request.command);
+                           })) {
+    InvalidateSearchCache();
+    MarkAutosaveDirty();
+  }
+  UnoCommandTaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](std::vector<UnoCommandRequest> batch,
+             scoped_refptr<base::SequencedTaskRunner> reply_runner,
+             base::WeakPtr<DocumentClient> client,
+             DocumentHolderWithView holder) {
+            // the whole batch is sent from the document's view
+            DocumentHolderWithView::ViewSession session(holder);
+            for (UnoCommandRequest& request : batch) {
+              if (CancelFlag::IsCancelled(request.cancel_flag)) {
+                // posted before any later result can arrive, which keeps the
+                // FIFO matching of results intact
+                reply_runner->PostTask(
+                    FROM_HERE,
+                    base::BindOnce(&DocumentClient::OnUnoCommandSkipped, client,
+                                   std::move(request.command), request.id));
+                continue;
+              }
+              session->postUnoCommand(request.command.c_str(),
+                                      request.args.get(), true);
+            }
+          },
+          std::move(queued_uno_commands_),
+          base::SequencedTaskRunnerHandle::Get(), GetWeakPtr(),
+          document_holder_));
+  queued_uno_commands_.clear();
+}
+
+// a sequence, so that batches, searches and the other async calls that act on
+// the selection or clipboard reach LOK in the order they were posted
+scoped_refptr<base::SequencedTaskRunner>
+DocumentClient::UnoCommandTaskRunner() {
+  if (!uno_command_task_runner_) {
+    uno_command_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner(
+        {base::TaskPriority::USER_VISIBLE, base::MayBlock()});
+  }
+  return uno_command_task_runner_;
+}
+
+int DocumentClient::CancelUnoCommand(gin::Arguments* args) {
+  std::string command;
+  const bool all = !args->GetNext(&command);
+
+  int cancelled = 0;
+  for (auto& [name, pending] : pending_uno_results_) {
+    if (!all && name != command)
+      continue;
+
+    for (PendingUnoResult& entry : pending) {
+      if (entry.settled)
+        continue;
+      CancelFlag::Set(entry.cancel_flag);
+      entry.settled = true;
+      ++cancelled;
+      ResolveUnanswered(*entry.promise, name, "cancelled");
+    }
+  }
+
+  return cancelled;
+}
+
+void DocumentClient::OnUnoCommandSkipped(const std::string& command,
+                                         uint64_t id) {
+  auto it = pending_uno_results_.find(command);
+  if (it == pending_uno_results_.end())
+    return;
+
+  auto& pending = it->second;
+  for (auto entry = pending.begin(); entry != pending.end(); ++entry) {
+    if (entry->id == id) {
+      pending.erase(entry);
+      break;
+    }
+  }
+}
+
+void DocumentClient::HandleUnoCommandResult(const std::string& payload) {
+  absl::optional<base::Value> json = base::JSONReader::Read(payload);
+  if (!json || !json->is_dict())
+    return;
+  const std::string* command = json->GetDict().FindString("commandName");
+  if (!command)
+    return;
+
+  auto it = pending_uno_results_.find(*command);
+  if (it == pending_uno_results_.end() || it->second.empty())
+    return;
+
+  PendingUnoResult entry = std::move(it->second.front());
+  it->second.pop_front();
+  if (it->second.empty())
+    pending_uno_results_.erase(it);
+
+  // already resolved by CancelUnoCommand, or only emitted as an event
+  if (entry.settled)
+    return;
+
+  v8::Isolate* isolate = entry.promise->isolate();
+  v8::HandleScope handle_scope(isolate);
+  v8::MicrotasksScope microtasks_scope(
+      isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+  v8::Context::Scope context_scope(entry.promise->GetContext());
+  entry.promise->Resolve(lok_callback::PayloadToLocalValue(
+      isolate, LOK_CALLBACK_UNO_COMMAND_RESULT, payload.c_str()));
+}
+
+void DocumentClient::ExpireUnoResults() {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeTicks next_deadline;
+  for (auto& [name, pending] : pending_uno_results_) {
+    // the entry stays queued, settled, so that the result LOK may still send
+    // is consumed by it instead of resolving a later command of the same name
+    for (PendingUnoResult& entry : pending) {
+      if (entry.settled)
+        continue;
+      if (entry.deadline <= now) {
+        LOG(WARNING) << "No result for " << name << " after "
+                     << kUnoCommandResultTimeout;
+        entry.settled = true;
+        ResolveUnanswered(*entry.promise, name, "timedOut");
+        continue;
+      }
+      if (next_deadline.is_null() || entry.deadline < next_deadline)
+        next_deadline = entry.deadline;
+    }
+  }
+
+  if (!next_deadline.is_null()) {
+    uno_result_timer_.Start(FROM_HERE, next_deadline - now, this,
+                            &DocumentClient::ExpireUnoResults);
+  }
+}
+
 void DocumentClient::SetTextSelection(int n_type, int n_x, int n_y) {
+  BlockingWatchdog::Scope watchdog("setTextSelection");
   document_holder_->setTextSelection(n_type, n_x, n_y);
 }
 
+v8::Local<v8::Promise> DocumentClient::SetTextSelectionAsync(
+    int n_type,
+    int n_x,
+    int n_y,
+    gin::Arguments* args) {
+  Promise<void> promise(args->isolate());
+  auto handle = promise.GetHandle();
+
+  document_holder_.PostBlocking(
+      UnoCommandTaskRunner(),
+      base::BindOnce(
+          [](Promise<void> promise, int n_type, int n_x, int n_y,
+             DocumentHolderWithView holder) {
+            holder->setTextSelection(n_type, n_x, n_y);
+            Promise<void>::ResolvePromise(std::move(promise));
+          },
+          std::move(promise), n_type, n_x, n_y));
+
+  return handle;
+}
+
 namespace {
 
+// takes ownership of the stream allocated by LOK
 v8::Local<v8::Value> lok_clipboard_to_buffer(v8::Isolate* isolate,
                                              const char* mime_type,
-                                             const char* stream,
+                                             char* stream,
                                              size_t size) {
-  // allocate a new ArrayBuffer and copy the stream to the backing
-  // store
-  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
-  std::memcpy(buffer->GetBackingStore()->Data(), stream, size);
+  // the stream becomes the backing store, like saveToMemory, instead of being
+  // copied into a new ArrayBuffer
+  auto backing_store = v8::ArrayBuffer::NewBackingStore(
+      stream, size, [](void* data, size_t, void*) { lok_safe_free(data); },
+      nullptr);
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, std::move(backing_store));
 
   v8::Local<v8::Name> names[2] = {gin::StringToV8(isolate, "mimeType"),
                                   gin::StringToV8(isolate, "buffer")};
@@ -480,98 +975,295 @@ v8::Local<v8::Value> lok_clipboard_to_string(v8::Isolate* isolate,
 
 }  // namespace
 
-v8::Local<v8::Value> DocumentClient::GetClipboard(gin::Arguments* args) {
-  std::vector<std::string> mime_types;
+namespace {
+
+// the clipboard contents as allocated by LOK, freed on destruction
+struct LokClipboard {
+  LokClipboard() = default;
+  ~LokClipboard() {
+    for (size_t i = 0; i < count; ++i) {
+      lok_safe_free(streams[i]);
+      lok_safe_free(mime_types[i]);
+    }
+    lok_safe_free(sizes);
+    lok_safe_free(streams);
+    lok_safe_free(mime_types);
+  }
+
+  // disable copy
+  LokClipboard(const LokClipboard&) = delete;
+  LokClipboard& operator=(const LokClipboard&) = delete;
+
+  size_t count = 0;
+  // these are arrays of count size, variable size arrays in C are simply
+  // pointers to the first element
+  char** mime_types = nullptr;
+  size_t* sizes = nullptr;
+  char** streams = nullptr;
+};
+
+std::unique_ptr<LokClipboard> GetLokClipboard(
+    const DocumentHolderWithView& holder,
+    const std::vector<std::string>& mime_types) {
   std::vector<const char*> mime_c_str;
   static constexpr std::string_view text_plain = "text/plain";
 
-  if (args->GetNext(&mime_types)) {
-    for (const std::string& mime_type : mime_types) {
-      // LOK explicitly converts all UTF-16 strings to UTF-8, however it still
-      // requests an encoding
-      if (mime_type == text_plain) {
-        mime_c_str.push_back("text/plain;charset=utf-8");
-        continue;
-      }
-      // c_str() gaurantees that the string is null-terminated, data()
-      // does not, don't use data() or bad things will happen
-      mime_c_str.push_back(mime_type.c_str());
+  for (const std::string& mime_type : mime_types) {
+    // LOK explicitly converts all UTF-16 strings to UTF-8, however it still
+    // requests an encoding
+    if (mime_type == text_plain) {
+      mime_c_str.push_back("text/plain;charset=utf-8");
+      continue;
     }
-
-    // add the nullptr terminator to the list of null-terminated strings
-    mime_c_str.push_back(nullptr);
+    // c_str() gaurantees that the string is null-terminated, data()
+    // does not, don't use data() or bad things will happen
+    mime_c_str.push_back(mime_type.c_str());
   }
 
-  size_t out_count;
+  // add the nullptr terminator to the list of null-terminated strings
+  mime_c_str.push_back(nullptr);
 
-  // these are arrays of out_count size, variable size arrays in C are
-  // simply pointers to the first element
-  char** out_mime_types = nullptr;
-  size_t* out_sizes = nullptr;
-  char** out_streams = nullptr;
+  auto clipboard = std::make_unique<LokClipboard>();
+  bool success = holder->getClipboard(
+      mime_types.size() ? mime_c_str.data() : nullptr, &clipboard->count,
+      &clipboard->mime_types, &clipboard->sizes, &clipboard->streams);
 
-  bool success = document_holder_->getClipboard(
-      mime_types.size() ? mime_c_str.data() : nullptr, &out_count,
-      &out_mime_types, &out_sizes, &out_streams);
+  if (!success)
+    return {};
+  return clipboard;
+}
 
-  // we'll be refrencing this and the context frequently inside of the
-  // loop
-  v8::Isolate* isolate = args->isolate();
+size_t LokClipboardBytes(const LokClipboard* clipboard) {
+  if (!clipboard)
+    return 0;
+  size_t bytes = 0;
+  for (size_t i = 0; i < clipboard->count; ++i)
+    bytes += clipboard->sizes[i];
+  return bytes;
+}
 
+// binary streams are moved out of the clipboard into the returned buffers
+v8::Local<v8::Array> LokClipboardToV8(v8::Isolate* isolate,
+                                      v8::Local<v8::Context> context,
+                                      LokClipboard* clipboard) {
   // return an empty array if we failed
-  if (!success)
+  if (!clipboard)
     return v8::Array::New(isolate, 0);
 
-  // an array of n=out_count array buffers
-  v8::Local<v8::Array> result = v8::Array::New(isolate, out_count);
-  // we pull out the context once outside of the array
-  v8::Local<v8::Context> context = args->GetHolderCreationContext();
+  static constexpr std::string_view text_plain = "text/plain";
+  static constexpr std::string_view text_prefix = "text/";
 
-  for (size_t i = 0; i < out_count; ++i) {
-    size_t buffer_size = out_sizes[i];
+  // an array of n=count array buffers
+  v8::Local<v8::Array> result = v8::Array::New(isolate, clipboard->count);
+
+  for (size_t i = 0; i < clipboard->count; ++i) {
+    size_t buffer_size = clipboard->sizes[i];
     if (buffer_size <= 0) {
-      std::ignore = result->Set(context, i, v8::Undefined(isolate_));
+      std::ignore = result->Set(context, i, v8::Undefined(isolate));
       continue;
     }
-    static constexpr std::string_view text_prefix = "text/";
-    std::string_view sv_mime_type(out_mime_types[i]);
+    std::string_view sv_mime_type(clipboard->mime_types[i]);
     if (sv_mime_type.substr(0, text_prefix.length()) == text_prefix) {
       if (sv_mime_type.substr(0, text_plain.length()) == text_plain) {
         std::ignore =
             result->Set(context, i,
-                        lok_clipboard_to_string(isolate_, text_plain.data(),
-                                                out_streams[i]));
+                        lok_clipboard_to_string(isolate, text_plain.data(),
+                                                clipboard->streams[i]));
       } else {
-        std::ignore =
-            result->Set(context, i,
-                        lok_clipboard_to_string(isolate_, out_mime_types[i],
-                                                out_streams[i]));
+        std::ignore = result->Set(
+            context, i,
+            lok_clipboard_to_string(isolate, clipboard->mime_types[i],
+                                    clipboard->streams[i]));
       }
     } else {
-      std::ignore =
-          result->Set(context, i,
-                      lok_clipboard_to_buffer(isolate_, out_mime_types[i],
-                                              out_streams[i], out_sizes[i]));
+      std::ignore = result->Set(
+          context, i,
+          lok_clipboard_to_buffer(isolate, clipboard->mime_types[i],
+                                  clipboard->streams[i], buffer_size));
+      clipboard->streams[i] = nullptr;
     }
-
-    // free the clipboard item, can't use std::unique_ptr without a
-    // wrapper class since it needs to be size aware
-    lok_safe_free(out_streams[i]);
-    lok_safe_free(out_mime_types[i]);
   }
-  // free the clipboard item containers
-  lok_safe_free(out_sizes);
-  lok_safe_free(out_streams);
-  lok_safe_free(out_mime_types);
 
   return result;
 }
 
-bool DocumentClient::SetClipboard(
-    std::vector<v8::Local<v8::Object>> clipboard_data,
+}  // namespace
+
+namespace {
+
+bool IsTextMimeType(std::string_view mime_type) {
+  return mime_type.substr(0, 5) == "text/";
+}
+
+// resolves a lazy clipboard item, replacing the accessor with the value
+void GetLazyClipboardValue(v8::Local<v8::Name> name,
+                           const v8::PropertyCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Array> data = info.Data().As<v8::Array>();
+
+  v8::Local<v8::Value> wrapper;
+  v8::Local<v8::Value> mime_type;
+  DocumentClient* client = nullptr;
+  std::string mime_type_str;
+  if (!data->Get(context, 0).ToLocal(&wrapper) ||
+      !data->Get(context, 1).ToLocal(&mime_type) ||
+      !gin::ConvertFromV8(isolate, wrapper, &client) || !client ||
+      !gin::ConvertFromV8(isolate, mime_type, &mime_type_str))
+    return;
+
+  DocumentHolderWithView holder = client->GetDocument();
+  if (!holder)
+    return;
+
+  BlockingWatchdog::Scope watchdog("getClipboard");
+  std::unique_ptr<LokClipboard> clipboard =
+      GetLokClipboard(holder, {mime_type_str});
+  v8::Local<v8::Array> items =
+      LokClipboardToV8(isolate, context, clipboard.get());
+
+  v8::Local<v8::Value> item;
+  if (items->Length() == 0 || !items->Get(context, 0).ToLocal(&item) ||
+      !item->IsObject())
+    return;
+
+  v8::Local<v8::Value> value;
+  if (item.As<v8::Object>()->Get(context, name).ToLocal(&value))
+    info.GetReturnValue().Set(value);
+}
+
+// an item whose text or buffer is only generated by LOK once it's read
+v8::Local<v8::Value> LazyClipboardItem(v8::Isolate* isolate,
+                                       v8::Local<v8::Context> context,
+                                       v8::Local<v8::Value> wrapper,
+                                       const std::string& mime_type) {
+  v8::Local<v8::Object> item = v8::Object::New(isolate);
+  v8::Local<v8::String> mime_type_v8 = gin::StringToV8(isolate, mime_type);
+  std::ignore = item->Set(context, gin::StringToV8(isolate, "mimeType"),
+                          mime_type_v8);
+
+  v8::Local<v8::Value> data_values[2] = {wrapper, mime_type_v8};
+  v8::Local<v8::Array> data = v8::Array::New(isolate, data_values, 2);
+  std::ignore = item->SetLazyDataProperty(
+      context,
+      gin::StringToSymbol(isolate, IsTextMimeType(mime_type) ? "text"
+                                                             : "buffer"),
+      GetLazyClipboardValue, data);
+  return item;
+}
+
+}  // namespace
+
+v8::Local<v8::Value> DocumentClient::GetClipboard(gin::Arguments* args) {
+  std::vector<std::string> mime_types;
+  args->GetNext(&mime_types);
+
+  // with the lazy option, each format is only requested from LOK when its
+  // text or buffer is read, instead of every format being encoded up front
+  v8::Local<v8::Object> options;
+  bool lazy = false;
+  if (args->GetNext(&options)) {
+    gin::Dictionary options_dict(args->isolate(), options);
+    options_dict.Get("lazy", &lazy);
+  }
+
+  v8::Local<v8::Value> wrapper;
+  if (lazy && !mime_types.empty() &&
+      GetWrapper(args->isolate()).ToLocal(&wrapper)) {
+    v8::Isolate* isolate = args->isolate();
+    v8::Local<v8::Context> context = args->GetHolderCreationContext();
+    v8::Local<v8::Array> result = v8::Array::New(isolate, mime_types.size());
+    for (size_t i = 0; i < mime_types.size(); ++i) {
+      std::ignore = result->Set(
+          context, i,
+          LazyClipboardItem(isolate, context, wrapper, mime_types[i]));
+    }
+    return result;
+  }
+
+  BlockingWatchdog::Scope watchdog("getClipboard");
+  std::unique_ptr<LokClipboard> clipboard =
+      GetLokClipboard(document_holder_, mime_types);
+
+  return LokClipboardToV8(args->isolate(), args->GetHolderCreationContext(),
+                          clipboard.get());
+}
+
+v8::Local<v8::Promise> DocumentClient::GetClipboardAsync(
     gin::Arguments* args) {
+  Promise<v8::Value> promise(args->isolate());
+  auto handle = promise.GetHandle();
+  std::vector<std::string> mime_types;
+  args->GetNext(&mime_types);
+
+  document_holder_.PostBlocking(
+      UnoCommandTaskRunner(),
+      base::BindOnce(
+          [](Promise<v8::Value> promise, std::vector<std::string> mime_types,
+             PendingBuffer::Counter pending_buffer_bytes,
+             base::WeakPtr<OfficeClient> office,
+             DocumentHolderWithView holder) {
+            std::unique_ptr<LokClipboard> clipboard =
+                GetLokClipboard(holder, mime_types);
+            const size_t bytes = LokClipboardBytes(clipboard.get());
+            promise.task_runner()->PostTask(
+                FROM_HERE,
+                base::BindOnce(
+                    [](Promise<v8::Value> promise,
+                       std::unique_ptr<LokClipboard> clipboard,
+                       PendingBuffer pending,
+                       base::WeakPtr<OfficeClient> office) {
+                      if (!office.MaybeValid())
+                        return;
+                      v8::Isolate* isolate = promise.isolate();
+                      v8::HandleScope handle_scope(isolate);
+                      v8::MicrotasksScope microtasks_scope(
+                          isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+                      v8::Context::Scope context_scope(promise.GetContext());
+                      promise.Resolve(LokClipboardToV8(
+                          isolate, promise.GetContext(), clipboard.get()));
+                    },
+                    std::move(promise), std::move(clipboard),
+                    PendingBuffer(std::move(pending_buffer_bytes), bytes),
+                    std::move(office)));
+          },
+          std::move(promise), std::move(mime_types), pending_buffer_bytes_,
+          OfficeClient::GetWeakPtr()));
+
+  return handle;
+}
+
+namespace {
+
+struct ClipboardEntry {
+  std::string mime_type;
+  // keeps the buffer alive while LOK reads from it off of the JS thread
+  std::shared_ptr<v8::BackingStore> backing_store;
+};
+
+std::vector<ClipboardEntry> ToClipboardEntries(
+    v8::Isolate* isolate,
+    const std::vector<v8::Local<v8::Object>>& clipboard_data) {
+  std::vector<ClipboardEntry> result;
+  for (const v8::Local<v8::Object>& item : clipboard_data) {
+    gin::Dictionary dictionary(isolate, item);
+
+    ClipboardEntry entry;
+    dictionary.Get<std::string>("mimeType", &entry.mime_type);
+
+    v8::Local<v8::ArrayBuffer> buffer;
+    if (!dictionary.Get<v8::Local<v8::ArrayBuffer>>("buffer", &buffer))
+      continue;
+    entry.backing_store = buffer->GetBackingStore();
+    result.emplace_back(std::move(entry));
+  }
+  return result;
+}
+
+bool SetLokClipboard(const DocumentHolderWithView& holder,
+                     const std::vector<ClipboardEntry>& clipboard_entries) {
   // entries in clipboard_data
-  const size_t entries = clipboard_data.size();
+  const size_t entries = clipboard_entries.size();
 
   // No entries in clipboard_data
   if (entries == 0) {
@@ -579,42 +1271,95 @@ bool DocumentClient::SetClipboard(
   }
 
   std::vector<const char*> mime_c_str;
-  size_t in_sizes[entries];
-  const char* streams[entries];
+  std::vector<size_t> in_sizes;
+  std::vector<const char*> streams;
 
-  v8::Isolate* isolate = args->isolate();
-  for (size_t i = 0; i < entries; ++i) {
-    gin::Dictionary dictionary(isolate, clipboard_data[i]);
-
-    std::string mime_type;
-    dictionary.Get<std::string>("mimeType", &mime_type);
-
-    v8::Local<v8::ArrayBuffer> buffer;
-    dictionary.Get<v8::Local<v8::ArrayBuffer>>("buffer", &buffer);
-
-    in_sizes[i] = buffer->ByteLength();
-    mime_c_str.push_back(mime_type.c_str());
-    streams[i] = static_cast<char*>(buffer->GetBackingStore()->Data());
+  for (const ClipboardEntry& entry : clipboard_entries) {
+    in_sizes.push_back(entry.backing_store->ByteLength());
+    mime_c_str.push_back(entry.mime_type.c_str());
+    streams.push_back(static_cast<char*>(entry.backing_store->Data()));
   }
 
   // add the nullptr terminator to the list of null-terminated strings
   mime_c_str.push_back(nullptr);
 
-  return document_holder_->setClipboard(entries, mime_c_str.data(), in_sizes,
-                                        streams);
+  return holder->setClipboard(entries, mime_c_str.data(), in_sizes.data(),
+                              streams.data());
+}
+
+}  // namespace
+
+bool DocumentClient::SetClipboard(
+    std::vector<v8::Local<v8::Object>> clipboard_data,
+    gin::Arguments* args) {
+  BlockingWatchdog::Scope watchdog("setClipboard");
+  return SetLokClipboard(document_holder_,
+                         ToClipboardEntries(args->isolate(), clipboard_data));
+}
+
+v8::Local<v8::Promise> DocumentClient::SetClipboardAsync(
+    std::vector<v8::Local<v8::Object>> clipboard_data,
+    gin::Arguments* args) {
+  Promise<bool> promise(args->isolate());
+  auto handle = promise.GetHandle();
+
+  std::vector<ClipboardEntry> entries =
+      ToClipboardEntries(args->isolate(), clipboard_data);
+  size_t bytes = 0;
+  for (const ClipboardEntry& entry : entries)
+    bytes += entry.backing_store->ByteLength();
+
+  // the buffers are held until LOK has read them
+  document_holder_.PostBlocking(
+      UnoCommandTaskRunner(),
+      base::BindOnce(
+          [](Promise<bool> promise, std::vector<ClipboardEntry> entries,
+             PendingBuffer pending, DocumentHolderWithView holder) {
+            Promise<bool>::ResolvePromise(std::move(promise),
+                                          SetLokClipboard(holder, entries));
+          },
+          std::move(promise), std::move(entries),
+          PendingBuffer(pending_buffer_bytes_, bytes)));
+
+  return handle;
 }
 
 bool DocumentClient::Paste(const std::string& mime_type,
                            const std::string& data,
                            gin::Arguments* args) {
+  BlockingWatchdog::Scope watchdog("paste");
+  InvalidateSearchCache();
   return document_holder_->paste(mime_type.c_str(), data.c_str(), data.size());
 }
 
+v8::Local<v8::Promise> DocumentClient::PasteAsync(const std::string& mime_type,
+                                                  const std::string& data,
+                                                  gin::Arguments* args) {
+  Promise<bool> promise(args->isolate());
+  auto handle = promise.GetHandle();
+  InvalidateSearchCache();
+
+  document_holder_.PostBlocking(
+      UnoCommandTaskRunner(),
+      base::BindOnce(
+          [](Promise<bool> promise, std::string mime_type, std::string data,
+             DocumentHolderWithView holder) {
+            bool res =
+                holder->paste(mime_type.c_str(), data.c_str(), data.size());
+            Promise<bool>::ResolvePromise(std::move(promise), res);
+          },
+          std::move(promise), mime_type, data));
+
+  return handle;
+}
+
 void DocumentClient::SetGraphicSelection(int n_type, int n_x, int n_y) {
+  BlockingWatchdog::Scope watchdog("setGraphicSelection");
   document_holder_->setGraphicSelection(n_type, n_x, n_y);
 }
 
 void DocumentClient::ResetSelection() {
+  BlockingWatchdog::Scope watchdog("resetSelection");
   document_holder_->resetSelection();
 }
 
@@ -663,6 +1408,9 @@ v8::Local<v8::Promise> DocumentClient::GetCommandValues(
 
 v8::Local<v8::Value> DocumentClient::As(const std::string& type,
                                         v8::Isolate* isolate) {
+  BlockingWatchdog::Scope watchdog("as");
+  if (auto office = OfficeClient::GetWeakPtr())
+    office->EnsureUnoBridge();
   void* component = document_holder_->getXComponent();
   return convert::As(isolate, component, type);
 }
@@ -677,6 +1425,94 @@ v8::Local<v8::Value> DocumentClient::NewView(v8::Isolate* isolate) {
   return result;
 }
 
+v8::Local<v8::Value> DocumentClient::GetViewSwitches(v8::Isolate* isolate) {
+  const uint64_t count = document_holder_.ViewSwitchCount();
+  const base::TimeTicks now = base::TimeTicks::Now();
+  double per_second = 0;
+  if (!view_switch_sample_time_.is_null()) {
+    const double seconds = (now - view_switch_sample_time_).InSecondsF();
+    if (seconds > 0)
+      per_second = (count - view_switch_sample_count_) / seconds;
+  }
+  view_switch_sample_time_ = now;
+  view_switch_sample_count_ = count;
+
+  gin::Dictionary result = gin::Dictionary::CreateEmpty(isolate);
+  result.Set("total", static_cast<double>(count));
+  result.Set("perSecond", per_second);
+  return gin::ConvertToV8(isolate, result);
+}
+
+v8::Local<v8::Value> DocumentClient::GetMemoryStats(v8::Isolate* isolate) {
+  MemoryStats stats;
+  AddMemoryStats(&stats);
+  return gin::ConvertToV8(isolate, stats);
+}
+
+void DocumentClient::SetMemoryLimit(double bytes) {
+  memory_limit_ = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+  if (!memory_limit_) {
+    memory_limit_timer_.Stop();
+    return;
+  }
+
+  // tiles are painted continuously, so the limit is checked on an interval
+  // instead of on every paint
+  memory_limit_timer_.Start(FROM_HERE, kMemoryLimitInterval, this,
+                            &DocumentClient::EnforceMemoryLimit);
+  EnforceMemoryLimit();
+}
+
+void DocumentClient::AddMemoryConsumer(MemoryConsumer* consumer) {
+  if (!memory_consumers_.HasObserver(consumer))
+    memory_consumers_.AddObserver(consumer);
+}
+
+void DocumentClient::RemoveMemoryConsumer(MemoryConsumer* consumer) {
+  memory_consumers_.RemoveObserver(consumer);
+}
+
+void DocumentClient::AddMemoryStats(MemoryStats* stats) {
+  stats->pending_buffer_bytes += pending_buffer_bytes_->load();
+  for (MemoryConsumer& consumer : memory_consumers_)
+    consumer.AddMemoryStats(stats);
+  for (auto& [key, transferable] : tile_buffers_to_restore_) {
+    if (transferable.tile_buffer)
+      transferable.tile_buffer->AddMemoryStats(transferable.snapshot, stats);
+  }
+}
+
+void DocumentClient::TrimMemory() {
+  TrimRenderersToRestore();
+  for (MemoryConsumer& consumer : memory_consumers_)
+    consumer.TrimMemory();
+}
+
+void DocumentClient::TrimRenderersToRestore() {
+  // a renderer waiting to remount has nothing on screen, it keeps its
+  // snapshot and paints again once restored
+  for (auto& [key, transferable] : tile_buffers_to_restore_) {
+    if (transferable.tile_buffer)
+      transferable.tile_buffer->TrimMemory();
+  }
+}
+
+void DocumentClient::EnforceMemoryLimit() {
+  MemoryStats stats;
+  AddMemoryStats(&stats);
+  if (stats.LimitedBytes() <= memory_limit_)
+    return;
+
+  TrimRenderersToRestore();
+  stats = MemoryStats();
+  AddMemoryStats(&stats);
+  if (stats.LimitedBytes() <= memory_limit_)
+    return;
+
+  for (MemoryConsumer& consumer : memory_consumers_)
+    consumer.TrimMemory();
+}
+
 void DocumentClient::EmitReady(v8::Isolate* isolate,
                                v8::Global<v8::Context> context) {
   v8::Isolate::Scope isolate_scope(isolate);
@@ -707,6 +1543,12 @@ void DocumentClient::EmitReady(v8::Isolate* isolate,
 }
 
 void DocumentClient::ForwardEmit(int type, const std::string& payload) {
+  auto binary_itr = binary_event_listeners_.find(type);
+  if (binary_itr != binary_event_listeners_.end() &&
+      !binary_itr->second.empty()) {
+    QueueBinaryEvent(type, payload);
+  }
+
   auto itr = event_listeners_.find(type);
   if (itr == event_listeners_.end())
     return;
@@ -717,6 +1559,187 @@ void DocumentClient::ForwardEmit(int type, const std::string& payload) {
   }
 }
 
+// parsing into a flat array avoids creating a JS array (and an array per rect)
+// for every event, which adds up for invalidate_tiles and text_selection
+void DocumentClient::QueueBinaryEvent(int type, const std::string& payload) {
+  BinaryEventBatch& batch = binary_event_batches_[type];
+  batch.offsets.push_back(batch.values.size());
+
+  // the JSON form used with multiple views has no binary representation, so
+  // it's passed along as is to keep one event per offset
+  if (!payload.empty() && payload[0] == '{') {
+    batch.json.emplace_back(batch.offsets.size() - 1, payload);
+    ScheduleBinaryFlush();
+    return;
+  }
+
+  // twips and indices fit easily, but a malformed payload shouldn't wrap
+  auto append = [&batch](const std::vector<int64_t>& values) {
+    for (int64_t value : values)
+      batch.values.push_back(base::saturated_cast<int32_t>(value));
+  };
+
+  std::string_view payload_sv(payload);
+  std::string_view::const_iterator start = payload_sv.begin();
+  if (lok_callback::IsTypeMultipleCSV(type)) {
+    for (auto& values :
+         lok_callback::ParseMultipleCSV(start, payload_sv.end())) {
+      append(values);
+    }
+  } else {
+    append(lok_callback::ParseCSV(start, payload_sv.end()));
+  }
+  ScheduleBinaryFlush();
+}
+
+void DocumentClient::ScheduleBinaryFlush() {
+  // events that are already queued on this sequence are delivered together
+  if (!binary_flush_scheduled_) {
+    binary_flush_scheduled_ = true;
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&DocumentClient::FlushBinaryEvents, GetWeakPtr()));
+  }
+}
+
+void DocumentClient::FlushBinaryEvents() {
+  binary_flush_scheduled_ = false;
+  DCHECK(isolate_);
+
+  auto batches = std::move(binary_event_batches_);
+  binary_event_batches_.clear();
+  for (auto& [type, batch] : batches) {
+    auto itr = binary_event_listeners_.find(type);
+    if (itr == binary_event_listeners_.end())
+      continue;
+
+    for (auto& callback : itr->second) {
+      V8FunctionInvoker<void(const BinaryEventBatch&)>::Go(isolate_, callback,
+                                                           batch);
+    }
+  }
+}
+
+BinaryEventBatch::BinaryEventBatch() = default;
+BinaryEventBatch::~BinaryEventBatch() = default;
+BinaryEventBatch::BinaryEventBatch(BinaryEventBatch&&) = default;
+BinaryEventBatch& BinaryEventBatch::operator=(BinaryEventBatch&&) = default;
+
+bool DocumentClient::StartAutosave(const std::string& path,
+                                   gin::Arguments* args) {
+  if (path.empty())
+    return false;
+
+  // the longest an edit goes without a full save while editing never pauses
+  int interval = 30000;
+  // a pause in editing long enough to save without getting in the way
+  int idle = 2000;
+  std::string format;
+  v8::Local<v8::Object> options;
+  if (args->GetNext(&options)) {
+    gin::Dictionary options_dict(args->isolate(), options);
+    options_dict.Get("interval", &interval);
+    options_dict.Get("idle", &idle);
+    options_dict.Get("format", &format);
+  }
+  if (interval <= 0 || idle <= 0)
+    return false;
+
+  StopAutosave();
+  autosave_journal_ = base::SequenceBound<AutosaveJournal>(
+      base::ThreadPool::CreateSequencedTaskRunner(
+          {base::TaskPriority::BEST_EFFORT, base::MayBlock(),
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN}),
+      base::FilePath::FromUTF8Unsafe(path));
+  autosave_format_ = std::move(format);
+  autosave_idle_ = base::Milliseconds(idle);
+  autosave_timer_.Start(FROM_HERE, base::Milliseconds(interval), this,
+                        &DocumentClient::CompactAutosave);
+
+  // autosave starts from a full save
+  autosave_dirty_ = true;
+  CompactAutosave();
+  return true;
+}
+
+void DocumentClient::StopAutosave() {
+  autosave_timer_.Stop();
+  autosave_idle_timer_.Stop();
+  // a pending write finishes on the journal's sequence
+  autosave_journal_.Reset();
+  autosave_dirty_ = false;
+  // a save in progress is dropped when it completes
+  autosave_saving_ = false;
+  ++autosave_generation_;
+}
+
+void DocumentClient::MarkAutosaveDirty() {
+  if (!autosave_journal_)
+    return;
+
+  autosave_dirty_ = true;
+  autosave_idle_timer_.Start(FROM_HERE, autosave_idle_, this,
+                             &DocumentClient::CompactAutosave);
+}
+
+void DocumentClient::CompactAutosave() {
+  // edits during a save are included in the next one
+  if (!autosave_journal_ || !autosave_dirty_ || autosave_saving_)
+    return;
+  autosave_dirty_ = false;
+  autosave_saving_ = true;
+  autosave_idle_timer_.Stop();
+
+  auto save = base::BindOnce(
+      [](std::string format, uint64_t generation,
+         PendingBuffer::Counter pending_buffer_bytes,
+         base::WeakPtr<DocumentClient> client,
+         scoped_refptr<base::SequencedTaskRunner> reply_runner,
+         DocumentHolderWithView holder) {
+        char* output = nullptr;
+        const int size = holder->saveToMemory(
+            &output, UncheckedAlloc, format.empty() ? nullptr : format.c_str());
+        LokStrPtr data(output);
+        PendingBuffer pending(std::move(pending_buffer_bytes),
+                              size > 0 ? static_cast<size_t>(size) : 0);
+        reply_runner->PostTask(
+            FROM_HERE,
+            base::BindOnce(
+                [](base::WeakPtr<DocumentClient> client, uint64_t generation,
+                   LokStrPtr data, int size, PendingBuffer pending) {
+                  // autosave was stopped or restarted during the save
+                  if (!client || generation != client->autosave_generation_)
+                    return;
+                  client->autosave_saving_ = false;
+
+                  if (size <= 0) {
+                    // try again with the next edit or interval
+                    client->autosave_dirty_ = true;
+                    return;
+                  }
+
+                  // the buffer is written without a copy and freed once
+                  // written
+                  client->autosave_journal_.PostTaskWithThisObject(
+                      base::BindOnce(
+                          [](LokStrPtr data, size_t size,
+                             PendingBuffer pending, AutosaveJournal* journal) {
+                            journal->Compact(base::make_span(
+                                reinterpret_cast<const uint8_t*>(data.get()),
+                                size));
+                          },
+                          std::move(data), static_cast<size_t>(size),
+                          std::move(pending)));
+                },
+                std::move(client), generation, std::move(data), size,
+                std::move(pending)));
+      },
+      autosave_format_, autosave_generation_, pending_buffer_bytes_,
+      GetWeakPtr(),
+      base::SequencedTaskRunnerHandle::Get(), document_holder_);
+  UnoCommandTaskRunner()->PostTask(FROM_HERE, std::move(save));
+}
+
 v8::Local<v8::Promise> DocumentClient::SaveAs(v8::Isolate* isolate,
                                               gin::Arguments* args) {
   v8::Local<v8::Value> arguments;
@@ -752,6 +1775,60 @@ v8::Local<v8::Promise> DocumentClient::SaveAs(v8::Isolate* isolate,
   return holder;
 }
 
+v8::Local<v8::Value> DocumentClient::ExportAs(const std::string& url,
+                                              gin::Arguments* args) {
+  v8::Isolate* isolate = args->isolate();
+  if (url.empty()) {
+    args->ThrowTypeError("missing url");
+    return {};
+  }
+
+  std::string format;
+  std::string filter;
+  std::string page_range;
+  v8::Local<v8::Value> on_progress = v8::Undefined(isolate);
+  v8::Local<v8::Object> options;
+  if (args->GetNext(&options)) {
+    gin::Dictionary options_dict(isolate, options);
+    options_dict.Get("format", &format);
+    options_dict.Get("filter", &filter);
+    options_dict.Get("pageRange", &page_range);
+    options_dict.Get("onProgress", &on_progress);
+  }
+
+  // pages of a text document, slides of a presentation, unknown otherwise
+  int total_pages = 0;
+  switch (document_holder_->getDocumentType()) {
+    case LOK_DOCTYPE_TEXT:
+      total_pages = page_geometry_.Size();
+      break;
+    case LOK_DOCTYPE_PRESENTATION:
+    case LOK_DOCTYPE_DRAWING:
+      total_pages = document_holder_->getParts();
+      break;
+    default:
+      break;
+  }
+
+  if (!page_range.empty()) {
+    total_pages = ExportJob::CountPages(page_range, total_pages);
+    if (total_pages < 0) {
+      args->ThrowTypeError("invalid pageRange");
+      return {};
+    }
+    if (!ExportJob::AddPageRange(page_range, &filter)) {
+      args->ThrowTypeError("pageRange requires the filter to be JSON");
+      return {};
+    }
+  }
+
+  return gin::CreateHandle(
+             isolate, new ExportJob(isolate, document_holder_, url,
+                                    std::move(format), std::move(filter),
+                                    total_pages, on_progress))
+      .ToV8();
+}
+
 v8::Local<v8::Promise> DocumentClient::InitializeForRendering(
     v8::Isolate* isolate) {
   document_holder_.PostBlocking(base::BindOnce(
@@ -784,7 +1861,13 @@ void DocumentClient::DocumentCallback(int type, std::string payload) {
   switch (static_cast<LibreOfficeKitCallbackType>(type)) {
       // internal monitors
     case LOK_CALLBACK_DOCUMENT_SIZE_CHANGED:
-      HandleDocSizeChanged();
+      InvalidateSearchCache();
+      // forwarded once the new size is available
+      HandleDocSizeChanged(std::move(payload));
+      break;
+    case LOK_CALLBACK_SEARCH_RESULT_SELECTION:
+    case LOK_CALLBACK_SEARCH_NOT_FOUND:
+      HandleSearchResult(type, payload);
       ForwardEmit(type, payload);
       break;
     case LOK_CALLBACK_INVALIDATE_TILES:
@@ -795,12 +1878,471 @@ void DocumentClient::DocumentCallback(int type, std::string payload) {
       HandleStateChange(payload);
       ForwardEmit(type, payload);
       break;
+    case LOK_CALLBACK_UNO_COMMAND_RESULT:
+      HandleUnoCommandResult(payload);
+      ForwardEmit(type, payload);
+      break;
     default:
       ForwardEmit(type, payload);
       break;
   }
 }
 
+SearchResult::SearchResult() = default;
+SearchResult::~SearchResult() = default;
+SearchResult::SearchResult(const SearchResult&) = default;
+SearchResult& SearchResult::operator=(const SearchResult&) = default;
+SearchResult::SearchResult(SearchResult&&) = default;
+SearchResult& SearchResult::operator=(SearchResult&&) = default;
+
+DocumentClient::PendingSearch::PendingSearch(std::string query,
+                                             bool all,
+                                             bool case_sensitive,
+                                             uint64_t generation,
+                                             SearchCallback callback)
+    : query(std::move(query)),
+      all(all),
+      case_sensitive(case_sensitive),
+      generation(generation),
+      callback(std::move(callback)),
+      deadline(base::TimeTicks::Now() + kSearchResultTimeout) {}
+DocumentClient::PendingSearch::~PendingSearch() = default;
+DocumentClient::PendingSearch::PendingSearch(PendingSearch&&) = default;
+DocumentClient::PendingSearch& DocumentClient::PendingSearch::operator=(
+    PendingSearch&&) = default;
+
+namespace {
+
+// see TransliterationFlags::IGNORE_CASE in i18nutil
+constexpr int kTransliterateIgnoreCase = 0x100;
+// see SvxSearchCmd in svx
+constexpr int kSearchCommandFind = 0;
+constexpr int kSearchCommandFindAll = 1;
+// see SearchAlgorithms2 in i18nutil
+constexpr int kSearchAlgorithmRegex = 2;
+
+std::string SearchArguments(const std::string& query,
+                            bool all,
+                            bool case_sensitive,
+                            bool backward,
+                            bool regex = false) {
+  auto uno_value = [](const char* type, base::Value value) {
+    base::Value::Dict dict;
+    dict.Set("type", type);
+    dict.Set("value", std::move(value));
+    return dict;
+  };
+
+  base::Value::Dict args;
+  args.Set("SearchItem.SearchString", uno_value("string", base::Value(query)));
+  args.Set("SearchItem.Backward", uno_value("boolean", base::Value(backward)));
+  args.Set("SearchItem.Command",
+           uno_value("long", base::Value(all ? kSearchCommandFindAll
+                                             : kSearchCommandFind)));
+  args.Set("SearchItem.TransliterateFlags",
+           uno_value("long", base::Value(case_sensitive
+                                             ? 0
+                                             : kTransliterateIgnoreCase)));
+
+  if (regex) {
+    args.Set("SearchItem.AlgorithmType2",
+             uno_value("short", base::Value(kSearchAlgorithmRegex)));
+  }
+
+  std::string json;
+  base::JSONWriter::Write(args, &json);
+  return json;
+}
+
+// The payload is of the form:
+// {"searchString": "...", "highlightAll": "true", "searchResultSelection":
+//  [{"part": "0", "rectangles": "x, y, w, h; x, y, w, h"}, ...]}
+std::vector<SearchResult> ParseSearchResults(const std::string& payload,
+                                             const PageGeometry& geometry) {
+  std::vector<SearchResult> results;
+  absl::optional<base::Value> json = base::JSONReader::Read(payload);
+  if (!json || !json->is_dict())
+    return results;
+
+  const base::Value::List* selections =
+      json->GetDict().FindList("searchResultSelection");
+  if (!selections)
+    return results;
+
+  results.reserve(selections->size());
+  for (const base::Value& selection : *selections) {
+    if (!selection.is_dict())
+      continue;
+    const std::string* part = selection.GetDict().FindString("part");
+    const std::string* rectangles =
+        selection.GetDict().FindString("rectangles");
+    if (!rectangles)
+      continue;
+
+    SearchResult& result = results.emplace_back();
+    if (part)
+      base::StringToInt(*part, &result.part);
+
+    std::string_view rectangles_sv(*rectangles);
+    std::string_view::const_iterator start = rectangles_sv.begin();
+    while (start < rectangles_sv.end()) {
+      // ParseRect doesn't stop at the end when skipping a trailing separator
+      while (start < rectangles_sv.end() && (*start ^ '0') > 9)
+        ++start;
+      if (start == rectangles_sv.end())
+        break;
+      gfx::Rect rect = lok_callback::ParseRect(start, rectangles_sv.end());
+      if (!rect.IsEmpty())
+        result.rects.push_back(rect);
+    }
+
+    result.page = result.part;
+    if (!result.rects.empty() && !geometry.IsEmpty()) {
+      int page = geometry
+                     .IntersectingPages(result.rects[0].y(),
+                                        result.rects[0].bottom())
+                     .first;
+      if (page >= 0)
+        result.page = page;
+    }
+  }
+
+  return results;
+}
+
+// LOK has no API to walk paragraphs, but a find-all for this selects the text
+// of every paragraph that has any, which reads as one paragraph per line
+constexpr char kParagraphPattern[] = "^.+$";
+constexpr char kTextSelectionMimeType[] = "text/plain;charset=utf-8";
+constexpr size_t kTextBatchSize = 64;
+
+}  // namespace
+
+v8::Local<v8::Promise> DocumentClient::Search(const std::string& query,
+                                              gin::Arguments* args) {
+  Promise<std::vector<SearchResult>> promise(args->isolate());
+  auto handle = promise.GetHandle();
+
+  bool all = false;
+  bool case_sensitive = false;
+  bool backward = false;
+  gin::Dictionary options(args->isolate());
+  if (args->GetNext(&options)) {
+    options.Get("all", &all);
+    options.Get("caseSensitive", &case_sensitive);
+    options.Get("backward", &backward);
+  }
+
+  FindText(query, all, case_sensitive, backward,
+           base::BindOnce(
+               [](Promise<std::vector<SearchResult>> promise,
+                  std::vector<SearchResult> results) {
+                 promise.Resolve(results);
+               },
+               std::move(promise)));
+  return handle;
+}
+
+void DocumentClient::FindText(const std::string& query,
+                              bool all,
+                              bool case_sensitive,
+                              bool backward,
+                              SearchCallback callback) {
+  if (query.empty()) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback),
+                                  std::vector<SearchResult>()));
+    return;
+  }
+
+  if (all) {
+    auto it = search_cache_.find({query, case_sensitive});
+    if (it != search_cache_.end()) {
+      base::SequencedTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE, base::BindOnce(std::move(callback), it->second));
+      return;
+    }
+  }
+
+  AddPendingSearch(PendingSearch(query, all, case_sensitive,
+                                 search_cache_generation_,
+                                 std::move(callback)));
+
+  // a single find moves the selection to the match like find next does, a
+  // find-all selects every match, so it runs in the search view instead.
+  // Finding every match in a large document takes a while, so it happens off
+  // of the renderer thread, ordered with the other UNO commands.
+  UnoCommandTaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](std::string args, DocumentHolderWithView holder) {
+            holder->postUnoCommand(".uno:ExecuteSearch", args.c_str(), false);
+          },
+          SearchArguments(query, all, case_sensitive, backward),
+          all ? SearchView() : document_holder_));
+}
+
+const DocumentHolderWithView& DocumentClient::SearchView() {
+  if (!search_holder_) {
+    search_holder_ = document_holder_.NewView();
+    for (int type : kSearchResultEvents)
+      search_holder_.AddDocumentObserver(type, this);
+  }
+  return search_holder_;
+}
+
+void DocumentClient::AddPendingSearch(PendingSearch search) {
+  for (int type : kSearchResultEvents) {
+    if (event_types_registered_.emplace(type).second)
+      document_holder_.AddDocumentObserver(type, this);
+  }
+  pending_searches_.emplace_back(std::move(search));
+  if (!search_timer_.IsRunning()) {
+    search_timer_.Start(FROM_HERE, kSearchResultTimeout, this,
+                        &DocumentClient::ExpireSearches);
+  }
+}
+
+void DocumentClient::ExpireSearches() {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  // searches are sent in the order they are queued, so only the oldest can
+  // have expired
+  while (!pending_searches_.empty() &&
+         pending_searches_.front().deadline <= now) {
+    PendingSearch search = std::move(pending_searches_.front());
+    pending_searches_.pop_front();
+    LOG(WARNING) << "No search result for " << search.query << " after "
+                 << kSearchResultTimeout;
+    std::move(search.callback).Run({});
+  }
+  if (!pending_searches_.empty()) {
+    search_timer_.Start(FROM_HERE, pending_searches_.front().deadline - now,
+                        this, &DocumentClient::ExpireSearches);
+  }
+}
+
+void DocumentClient::InvalidateSearchCache() {
+  ++search_cache_generation_;
+  search_cache_.clear();
+}
+
+void DocumentClient::HandleSearchResult(int type, const std::string& payload) {
+  if (pending_searches_.empty())
+    return;
+
+  // not found only carries the search string
+  std::string query = payload;
+  bool all = false;
+  if (type == LOK_CALLBACK_SEARCH_RESULT_SELECTION) {
+    absl::optional<base::Value> json = base::JSONReader::Read(payload);
+    if (!json || !json->is_dict())
+      return;
+    const std::string* search_string =
+        json->GetDict().FindString("searchString");
+    const std::string* highlight_all =
+        json->GetDict().FindString("highlightAll");
+    if (!search_string)
+      return;
+    query = *search_string;
+    all = highlight_all && *highlight_all == "true";
+  }
+
+  auto it = base::ranges::find_if(
+      pending_searches_, [&](const PendingSearch& search) {
+        return search.query == query &&
+               (type == LOK_CALLBACK_SEARCH_NOT_FOUND || search.all == all);
+      });
+  if (it == pending_searches_.end())
+    return;
+  PendingSearch search = std::move(*it);
+  pending_searches_.erase(it);
+
+  std::vector<SearchResult> results;
+  if (type == LOK_CALLBACK_SEARCH_RESULT_SELECTION)
+    results = ParseSearchResults(payload, page_geometry_);
+
+  if (search.all && !search.regex &&
+      search.generation == search_cache_generation_)
+    search_cache_[{search.query, search.case_sensitive}] = results;
+
+  std::move(search.callback).Run(std::move(results));
+}
+
+struct DocumentClient::TextExtraction {
+  TextExtraction(Promise<TextExtractionSummary> promise,
+                 SafeV8Function on_paragraphs)
+      : promise(std::move(promise)), on_paragraphs(std::move(on_paragraphs)) {}
+
+  Promise<TextExtractionSummary> promise;
+  SafeV8Function on_paragraphs;
+  uint64_t since = 0;
+  bool with_positions = false;
+  // inclusive, -1 for every page
+  int first_page = -1;
+  int last_page = -1;
+
+  // the text and the matches of the paragraph search arrive separately
+  absl::optional<std::vector<TextParagraph>> selected;
+  absl::optional<std::vector<SearchResult>> located;
+
+  // the changed paragraphs
+  std::vector<TextParagraph> paragraphs;
+  size_t next = 0;
+  TextExtractionSummary summary;
+};
+
+v8::Local<v8::Promise> DocumentClient::ExtractText(
+    v8::Local<v8::Function> on_paragraphs,
+    gin::Arguments* args) {
+  v8::Isolate* isolate = args->isolate();
+  Promise<TextExtractionSummary> promise(isolate);
+  auto handle = promise.GetHandle();
+  auto extraction = std::make_unique<TextExtraction>(
+      std::move(promise), SafeV8Function(isolate, on_paragraphs));
+
+  gin::Dictionary options(isolate);
+  if (args->GetNext(&options)) {
+    std::vector<int> pages;
+    if (options.Get("pages", &pages) && pages.size() == 2) {
+      extraction->first_page = pages[0];
+      extraction->last_page = pages[1];
+    }
+    options.Get("withPositions", &extraction->with_positions);
+    options.Get("since", &extraction->since);
+  }
+  // pages are only known from positions
+  if (extraction->first_page >= 0)
+    extraction->with_positions = true;
+
+  const uint64_t id = next_text_extraction_id_++;
+  if (extraction->with_positions) {
+    PendingSearch search(
+        kParagraphPattern, true, true, search_cache_generation_,
+        base::BindOnce(&DocumentClient::OnTextLocated, GetWeakPtr(), id));
+    search.regex = true;
+    AddPendingSearch(std::move(search));
+  }
+  text_extractions_.emplace(id, std::move(extraction));
+
+  // the search selects every paragraph, so the text of the whole document is
+  // read in one pass as the selection and the matches are its positions. It
+  // runs in the search view, which leaves the selection of this one alone.
+  UnoCommandTaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](std::string args, uint64_t id,
+             scoped_refptr<base::SequencedTaskRunner> task_runner,
+             base::WeakPtr<DocumentClient> client,
+             DocumentHolderWithView holder) {
+            std::string text;
+            {
+              DocumentHolderWithView::ViewSession session(holder);
+              session->postUnoCommand(".uno:ExecuteSearch", args.c_str(),
+                                      false);
+              LokStrPtr selected(
+                  session->getTextSelection(kTextSelectionMimeType, nullptr));
+              if (selected)
+                text = selected.get();
+            }
+            task_runner->PostTask(
+                FROM_HERE, base::BindOnce(&DocumentClient::OnTextSelected,
+                                          std::move(client), id,
+                                          std::move(text)));
+          },
+          SearchArguments(kParagraphPattern, true, true, false, true),
+          id, base::SequencedTaskRunnerHandle::Get(), GetWeakPtr(),
+          SearchView()));
+
+  return handle;
+}
+
+void DocumentClient::OnTextSelected(uint64_t id, std::string text) {
+  auto it = text_extractions_.find(id);
+  if (it == text_extractions_.end())
+    return;
+  it->second->selected = TextIndex::Split(text);
+  if (!it->second->with_positions || it->second->located)
+    CompleteTextSelection(id);
+}
+
+void DocumentClient::OnTextLocated(uint64_t id,
+                                   std::vector<SearchResult> results) {
+  auto it = text_extractions_.find(id);
+  if (it == text_extractions_.end())
+    return;
+  it->second->located = std::move(results);
+  if (it->second->selected)
+    CompleteTextSelection(id);
+}
+
+void DocumentClient::CompleteTextSelection(uint64_t id) {
+  auto it = text_extractions_.find(id);
+  std::unique_ptr<TextExtraction> extraction = std::move(it->second);
+  text_extractions_.erase(it);
+
+  std::vector<TextParagraph>& paragraphs = *extraction->selected;
+  if (extraction->located) {
+    // the pattern only matches paragraphs with text, so there is a match per
+    // paragraph that isn't empty, both in document order
+    std::vector<SearchResult>& results = *extraction->located;
+    size_t next = 0;
+    for (TextParagraph& paragraph : paragraphs) {
+      if (next == results.size())
+        break;
+      if (paragraph.text.empty())
+        continue;
+      paragraph.page = results[next].page;
+      paragraph.rects = std::move(results[next].rects);
+      ++next;
+    }
+  }
+
+  // only part of the changes are yielded for a range of pages, so the revision
+  // isn't moved past the others
+  TextIndex::Diff diff =
+      extraction->first_page < 0
+          ? text_index_.Update(paragraphs, extraction->since)
+          : text_index_.Compare(paragraphs, extraction->since);
+  extraction->summary.revision = text_index_.Revision();
+  extraction->summary.diff = diff;
+
+  // only the changed paragraphs are yielded
+  auto first = paragraphs.begin() + diff.start;
+  extraction->paragraphs.assign(std::make_move_iterator(first),
+                                std::make_move_iterator(first + diff.inserted));
+  extraction->selected.reset();
+  extraction->located.reset();
+  ContinueTextExtraction(std::move(extraction));
+}
+
+void DocumentClient::ContinueTextExtraction(
+    std::unique_ptr<TextExtraction> extraction) {
+  std::vector<TextParagraph> batch;
+  while (extraction->next < extraction->paragraphs.size() &&
+         batch.size() < kTextBatchSize) {
+    TextParagraph& paragraph = extraction->paragraphs[extraction->next++];
+    if (extraction->first_page < 0 ||
+        (paragraph.page >= extraction->first_page &&
+         paragraph.page <= extraction->last_page)) {
+      batch.emplace_back(std::move(paragraph));
+    }
+  }
+  if (!batch.empty()) {
+    V8FunctionInvoker<void(std::vector<TextParagraph>)>::Go(
+        extraction->promise.isolate(), extraction->on_paragraphs,
+        std::move(batch));
+  }
+
+  if (extraction->next < extraction->paragraphs.size()) {
+    // yield between batches to keep the renderer responsive
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(&DocumentClient::ContinueTextExtraction,
+                                  GetWeakPtr(), std::move(extraction)));
+    return;
+  }
+  extraction->promise.Resolve(extraction->summary);
+}
+
 void DocumentClient::OnDestroyed() {
   delete this;
 }
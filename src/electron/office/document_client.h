@@ -4,24 +4,47 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/atomic_ref_count.h"
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
 #include "base/memory/weak_ptr.h"
+#include "base/observer_list.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/threading/sequence_bound.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "base/token.h"
 #include "gin/arguments.h"
 #include "gin/converter.h"
 #include "gin/wrappable.h"
+#include "office/autosave_journal.h"
+#include "office/cancellation_flag.h"
 #include "office/destroyed_observer.h"
 #include "office/document_event_observer.h"
 #include "office/document_holder.h"
+#include "office/lok_callback.h"
+#include "office/memory_stats.h"
+#include "office/page_geometry.h"
+#include "office/promise.h"
 #include "office/renderer_transferable.h"
+#include "office/text_index.h"
 #include "office/v8_callback.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 #include "ui/gfx/geometry/rect.h"
 #include "ui/gfx/geometry/size.h"
+#include "v8/include/v8-array-buffer.h"
 #include "v8/include/v8-persistent-handle.h"
+#include "v8/include/v8-typed-array.h"
 
 namespace lok {
 class Document;
@@ -31,9 +54,48 @@ namespace electron::office {
 
 class OfficeClient;
 
+// The numbers from every payload of one event type received before a flush,
+// flattened into one array. The values of the payload N start at offsets[N],
+// an empty payload (like EMPTY in invalidate_tiles) has no values.
+struct BinaryEventBatch {
+  BinaryEventBatch();
+  ~BinaryEventBatch();
+  BinaryEventBatch(BinaryEventBatch&&);
+  BinaryEventBatch& operator=(BinaryEventBatch&&);
+
+  std::vector<int32_t> values;
+  std::vector<int32_t> offsets;
+  // payloads in the JSON form, by the index of their event in offsets
+  std::vector<std::pair<int32_t, std::string>> json;
+};
+
+// A single match from a search, rects are in twips
+struct SearchResult {
+  SearchResult();
+  ~SearchResult();
+  SearchResult(const SearchResult&);
+  SearchResult& operator=(const SearchResult&);
+  SearchResult(SearchResult&&);
+  SearchResult& operator=(SearchResult&&);
+
+  // the page containing the match, or the part for documents without pages
+  int page = 0;
+  // the sheet or slide, always 0 for text documents
+  int part = 0;
+  std::vector<gfx::Rect> rects;
+};
+using SearchCallback = base::OnceCallback<void(std::vector<SearchResult>)>;
+
+// What an extractText call yielded, relative to the requested revision
+struct TextExtractionSummary {
+  uint64_t revision = 0;
+  TextIndex::Diff diff;
+};
+
 class DocumentClient : public gin::Wrappable<DocumentClient>,
                        public DocumentEventObserver,
-                       public DestroyedObserver {
+                       public DestroyedObserver,
+                       public MemoryConsumer {
  public:
   DocumentClient();
   ~DocumentClient() override;
@@ -53,7 +115,8 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   // v8 EventBus
   void On(v8::Isolate* isolate,
           const std::u16string& event_name,
-          v8::Local<v8::Function> listener_callback);
+          v8::Local<v8::Function> listener_callback,
+          gin::Arguments* args);
   void Off(const std::u16string& event_name,
            v8::Local<v8::Function> listener_callback);
   void Emit(v8::Isolate* isolate,
@@ -63,31 +126,64 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   // Exposed to v8 {
   // Loaded and capable of receiving events
   bool IsReady() const;
-  std::vector<gfx::Rect> PageRects() const;
+  const std::vector<gfx::Rect>& PageRects() const;
   gfx::Size Size() const;
   void SetAuthor(const std::string& author, gin::Arguments* args);
   void PostUnoCommand(const std::string& command, gin::Arguments* args);
   void PostUnoCommandInternal(const std::string& command,
                               std::unique_ptr<char[]> json_buffer,
                               bool notifyWhenFinished);
+  v8::Local<v8::Promise> PostUnoCommandAsync(const std::string& command,
+                                             gin::Arguments* args);
+  int CancelUnoCommand(gin::Arguments* args);
   v8::Local<v8::Value> GotoOutline(int idx, gin::Arguments* args);
+  v8::Local<v8::Promise> GotoOutlineAsync(int idx, gin::Arguments* args);
   v8::Local<v8::Promise> SaveToMemory(v8::Isolate* isolate,
                                       gin::Arguments* args);
   v8::Local<v8::Promise> SaveAs(v8::Isolate* isolate, gin::Arguments* args);
+  v8::Local<v8::Value> ExportAs(const std::string& url, gin::Arguments* args);
+  bool StartAutosave(const std::string& path, gin::Arguments* args);
+  void StopAutosave();
   void SetTextSelection(int n_type, int n_x, int n_y);
+  v8::Local<v8::Promise> SetTextSelectionAsync(int n_type,
+                                               int n_x,
+                                               int n_y,
+                                               gin::Arguments* args);
   v8::Local<v8::Value> GetClipboard(gin::Arguments* args);
+  v8::Local<v8::Promise> GetClipboardAsync(gin::Arguments* args);
   bool SetClipboard(std::vector<v8::Local<v8::Object>> clipboard_data,
                     gin::Arguments* args);
+  v8::Local<v8::Promise> SetClipboardAsync(
+      std::vector<v8::Local<v8::Object>> clipboard_data,
+      gin::Arguments* args);
   bool Paste(const std::string& mime_type,
              const std::string& data,
              gin::Arguments* args);
+  v8::Local<v8::Promise> PasteAsync(const std::string& mime_type,
+                                    const std::string& data,
+                                    gin::Arguments* args);
   void SetGraphicSelection(int n_type, int n_x, int n_y);
   void ResetSelection();
   v8::Local<v8::Promise> GetCommandValues(const std::string& command,
                                           gin::Arguments* args);
   v8::Local<v8::Value> As(const std::string& type, v8::Isolate* isolate);
+  v8::Local<v8::Promise> Search(const std::string& query,
+                                gin::Arguments* args);
+  v8::Local<v8::Promise> ExtractText(v8::Local<v8::Function> on_paragraphs,
+                                     gin::Arguments* args);
   // }
 
+  // Searches for `query` on the UNO command sequence. `all` finds and selects
+  // every match, otherwise the next match after the cursor is selected. The
+  // results of `all` are cached until the document is edited.
+  void FindText(const std::string& query,
+                bool all,
+                bool case_sensitive,
+                bool backward,
+                SearchCallback callback);
+  // called when the document may have been edited
+  void InvalidateSearchCache();
+
   // DocumentEventObserver
   void DocumentCallback(int type, std::string payload) override;
 
@@ -106,6 +202,7 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   RendererTransferable GetRestoredRenderer(const base::Token& restore_key);
 
   int GetNumberOfPages() const;
+  const PageGeometry& Geometry() const;
 
   // Editing State {
   bool CanUndo();
@@ -115,6 +212,23 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   std::string Path();
 
   v8::Local<v8::Value> NewView(v8::Isolate* isolate);
+  // LOK view switches for the document, the rate is since the previous call
+  v8::Local<v8::Value> GetViewSwitches(v8::Isolate* isolate);
+
+  // Memory {
+  v8::Local<v8::Value> GetMemoryStats(v8::Isolate* isolate);
+  // trims the document whenever it holds more than `bytes`, 0 for no limit
+  void SetMemoryLimit(double bytes);
+
+  // the plugins rendering the document
+  void AddMemoryConsumer(MemoryConsumer* consumer);
+  void RemoveMemoryConsumer(MemoryConsumer* consumer);
+
+  // MemoryConsumer
+  void AddMemoryStats(MemoryStats* stats) override;
+  // releases the renderers waiting to remount first, then trims the plugins
+  void TrimMemory() override;
+  // }
 
   DocumentHolderWithView GetDocument();
 
@@ -123,13 +237,48 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
  private:
   void HandleStateChange(const std::string& payload);
   void HandleUnoCommandResult(const std::string& payload);
-  void HandleDocSizeChanged();
+  // queues a command for the UNO sequence, expecting a result for it. Its
+  // result resolves `promise`, or is only consumed if there is none.
+  void QueueUnoCommand(const std::string& command,
+                       std::unique_ptr<char[]> json_buffer,
+                       absl::optional<Promise<v8::Value>> promise);
+  void FlushUnoCommands();
+  void ObserveUnoCommandResults();
+  // settles the commands LOK didn't answer within kUnoCommandResultTimeout
+  void ExpireUnoResults();
+  scoped_refptr<base::SequencedTaskRunner> UnoCommandTaskRunner();
+  void HandleSearchResult(int type, const std::string& payload);
+
+  // a second view of the document, created on the first find-all, in which
+  // the find-alls run so that the selection of this view stays as it was
+  const DocumentHolderWithView& SearchView();
+  struct PendingSearch;
+  void AddPendingSearch(PendingSearch search);
+  // fails the searches LOK didn't answer within kSearchResultTimeout
+  void ExpireSearches();
+
+  struct TextExtraction;
+  void OnTextSelected(uint64_t id, std::string text);
+  void OnTextLocated(uint64_t id, std::vector<SearchResult> results);
+  // both the text and the positions, if requested, have arrived
+  void CompleteTextSelection(uint64_t id);
+  void ContinueTextExtraction(std::unique_ptr<TextExtraction> extraction);
+  void OnUnoCommandSkipped(const std::string& command, uint64_t id);
+  void HandleDocSizeChanged(std::string payload);
+  void OnSizeRefreshed(uint64_t generation,
+                       long width_twips,
+                       long height_twips,
+                       std::string page_rects,
+                       std::string payload);
   void HandleInvalidate();
 
   void RefreshSize();
 
   void EmitReady(v8::Isolate* isolate, v8::Global<v8::Context> context);
   void ForwardEmit(int type, const std::string& payload);
+  void QueueBinaryEvent(int type, const std::string& payload);
+  void ScheduleBinaryFlush();
+  void FlushBinaryEvents();
 
   v8::Local<v8::Promise> InitializeForRendering(v8::Isolate* isolate);
 
@@ -139,7 +288,9 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   long document_height_in_twips_;
   long document_width_in_twips_;
 
-  std::vector<gfx::Rect> page_rects_;
+  PageGeometry page_geometry_;
+  // only the latest asynchronous size refresh is applied
+  uint64_t size_refresh_generation_ = 0;
 
   // holds state changes until the document is mounted
   std::vector<std::string> state_change_buffer_;
@@ -154,6 +305,131 @@ class DocumentClient : public gin::Wrappable<DocumentClient>,
   std::unordered_map<int, std::vector<SafeV8Function>> event_listeners_;
   // used to track what has a registered observer
   std::unordered_set<int> event_types_registered_;
+  // listeners registered with { binary: true }, which receive the numbers in a
+  // payload as typed arrays, batched per event type
+  std::unordered_map<int, std::vector<SafeV8Function>> binary_event_listeners_;
+  std::unordered_map<int, BinaryEventBatch> binary_event_batches_;
+  bool binary_flush_scheduled_ = false;
+
+  // UNO commands posted from JS in the same task are sent to LOK together
+  struct UnoCommandRequest {
+    UnoCommandRequest(uint64_t id,
+                      std::string command,
+                      std::unique_ptr<char[]> args,
+                      CancelFlagPtr cancel_flag);
+    ~UnoCommandRequest();
+    UnoCommandRequest(UnoCommandRequest&&);
+    UnoCommandRequest& operator=(UnoCommandRequest&&);
+
+    uint64_t id;
+    std::string command;
+    std::unique_ptr<char[]> args;
+    CancelFlagPtr cancel_flag;
+  };
+  // LOK doesn't identify the command in a result beyond its name, so results
+  // are matched to pending commands in FIFO order per command name. Every
+  // command that asks LOK for a result is registered here before it is sent,
+  // in the order it is sent in, so the order results arrive in is the order
+  // of entries.
+  struct PendingUnoResult {
+    PendingUnoResult(uint64_t id,
+                     CancelFlagPtr cancel_flag,
+                     absl::optional<Promise<v8::Value>> promise,
+                     base::TimeTicks deadline);
+    ~PendingUnoResult();
+    PendingUnoResult(PendingUnoResult&&);
+    PendingUnoResult& operator=(PendingUnoResult&&);
+
+    uint64_t id;
+    CancelFlagPtr cancel_flag;
+    // empty for postUnoCommand with notifyWhenFinished, whose result is only
+    // emitted as an event
+    absl::optional<Promise<v8::Value>> promise;
+    // settled if unanswered by then, so a command LOK is slow to answer
+    // doesn't hold up its promise indefinitely
+    base::TimeTicks deadline;
+    // cancelled and timed out entries stay queued until LOK skips or answers
+    // them, so a late result isn't taken for that of a later command
+    bool settled = false;
+  };
+  std::vector<UnoCommandRequest> queued_uno_commands_;
+  std::unordered_map<std::string, base::circular_deque<PendingUnoResult>>
+      pending_uno_results_;
+  uint64_t next_uno_command_id_ = 0;
+  bool uno_flush_scheduled_ = false;
+  base::OneShotTimer uno_result_timer_;
+  scoped_refptr<base::SequencedTaskRunner> uno_command_task_runner_;
+
+  // LOK reports search results by the search string only, so they are matched
+  // to the oldest pending search for the same string, and results of searches
+  // posted elsewhere are ignored
+  struct PendingSearch {
+    PendingSearch(std::string query,
+                  bool all,
+                  bool case_sensitive,
+                  uint64_t generation,
+                  SearchCallback callback);
+    ~PendingSearch();
+    PendingSearch(PendingSearch&&);
+    PendingSearch& operator=(PendingSearch&&);
+
+    std::string query;
+    bool all;
+    bool case_sensitive;
+    // the search cache generation when the search was started
+    uint64_t generation;
+    SearchCallback callback;
+    // the query is a regular expression, whose results aren't cached
+    bool regex = false;
+    base::TimeTicks deadline;
+  };
+  base::circular_deque<PendingSearch> pending_searches_;
+  base::OneShotTimer search_timer_;
+  // find-all results keyed by query and case sensitivity
+  std::map<std::pair<std::string, bool>, std::vector<SearchResult>>
+      search_cache_;
+  uint64_t search_cache_generation_ = 0;
+  DocumentHolderWithView search_holder_;
+
+  // paragraph hashes of the last extractText, for incremental extraction
+  TextIndex text_index_;
+  std::map<uint64_t, std::unique_ptr<TextExtraction>> text_extractions_;
+  uint64_t next_text_extraction_id_ = 0;
+
+  // Autosave {
+  // schedules a full save after a pause in editing
+  void MarkAutosaveDirty();
+  // replaces the journal with a full save if anything changed
+  void CompactAutosave();
+
+  base::SequenceBound<AutosaveJournal> autosave_journal_;
+  std::string autosave_format_;
+  base::TimeDelta autosave_idle_;
+  bool autosave_dirty_ = false;
+  bool autosave_saving_ = false;
+  // tells a save that completes after autosave was stopped or restarted
+  uint64_t autosave_generation_ = 0;
+  // compacts after a pause in editing
+  base::OneShotTimer autosave_idle_timer_;
+  // compacts while editing never pauses
+  base::RepeatingTimer autosave_timer_;
+  // }
+
+  // Memory limit {
+  void EnforceMemoryLimit();
+  void TrimRenderersToRestore();
+
+  base::ObserverList<MemoryConsumer> memory_consumers_;
+  // the saves and clipboard contents in flight, see PendingBuffer
+  PendingBuffer::Counter pending_buffer_bytes_ =
+      std::make_shared<std::atomic<size_t>>(0);
+  size_t memory_limit_ = 0;
+  base::RepeatingTimer memory_limit_timer_;
+  // }
+
+  // the previous sample of getViewSwitches
+  base::TimeTicks view_switch_sample_time_;
+  uint64_t view_switch_sample_count_ = 0;
 
   bool can_undo_ = false;
   bool can_redo_ = false;
@@ -189,4 +465,101 @@ struct Converter<EventPayload> {
     return ConvertToV8(isolate, dict);
   }
 };
+
+template <>
+struct Converter<BinaryEventBatch> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                   const BinaryEventBatch& val) {
+    auto to_int32_array = [isolate](const std::vector<int32_t>& in) {
+      size_t byte_length = in.size() * sizeof(int32_t);
+      v8::Local<v8::ArrayBuffer> buffer =
+          v8::ArrayBuffer::New(isolate, byte_length);
+      if (byte_length)
+        memcpy(buffer->Data(), in.data(), byte_length);
+      return v8::Int32Array::New(buffer, 0, in.size());
+    };
+    Dictionary dict = Dictionary::CreateEmpty(isolate);
+    dict.Set("payload", to_int32_array(val.values));
+    dict.Set("offsets", to_int32_array(val.offsets));
+    if (!val.json.empty()) {
+      std::vector<v8::Local<v8::Value>> json;
+      json.reserve(val.json.size());
+      for (const auto& [index, payload] : val.json) {
+        Dictionary entry = Dictionary::CreateEmpty(isolate);
+        entry.Set("index", index);
+        entry.Set("payload",
+                  electron::office::lok_callback::ParseJSON(
+                      isolate, StringToV8(isolate, payload)));
+        json.push_back(ConvertToV8(isolate, entry));
+      }
+      dict.Set("json", json);
+    }
+    return ConvertToV8(isolate, dict);
+  }
+};
+
+template <>
+struct Converter<TextParagraph> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                   const TextParagraph& val) {
+    std::vector<std::vector<int>> rects;
+    rects.reserve(val.rects.size());
+    for (const gfx::Rect& rect : val.rects) {
+      rects.push_back({rect.x(), rect.y(), rect.width(), rect.height()});
+    }
+    Dictionary dict = Dictionary::CreateEmpty(isolate);
+    dict.Set("index", val.index);
+    dict.Set("text", val.text);
+    dict.Set("hash", val.hash);
+    dict.Set("page", val.page);
+    dict.Set("rects", rects);
+    return ConvertToV8(isolate, dict);
+  }
+};
+
+template <>
+struct Converter<TextExtractionSummary> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                   const TextExtractionSummary& val) {
+    Dictionary dict = Dictionary::CreateEmpty(isolate);
+    dict.Set("revision", static_cast<double>(val.revision));
+    dict.Set("start", static_cast<double>(val.diff.start));
+    dict.Set("removed", static_cast<double>(val.diff.removed));
+    dict.Set("inserted", static_cast<double>(val.diff.inserted));
+    dict.Set("full", val.diff.full);
+    return ConvertToV8(isolate, dict);
+  }
+};
+
+template <>
+struct Converter<MemoryStats> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                   const MemoryStats& val) {
+    Dictionary dict = Dictionary::CreateEmpty(isolate);
+    dict.Set("tilePool", static_cast<double>(val.tile_pool_bytes));
+    dict.Set("tiles", static_cast<double>(val.tile_bytes));
+    dict.Set("snapshots", static_cast<double>(val.snapshot_bytes));
+    dict.Set("slides", static_cast<double>(val.slide_bytes));
+    dict.Set("pendingBuffers", static_cast<double>(val.pending_buffer_bytes));
+    dict.Set("total", static_cast<double>(val.Total()));
+    return ConvertToV8(isolate, dict);
+  }
+};
+
+template <>
+struct Converter<SearchResult> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                   const SearchResult& val) {
+    std::vector<std::vector<int>> rects;
+    rects.reserve(val.rects.size());
+    for (const gfx::Rect& rect : val.rects) {
+      rects.push_back({rect.x(), rect.y(), rect.width(), rect.height()});
+    }
+    Dictionary dict = Dictionary::CreateEmpty(isolate);
+    dict.Set("page", val.page);
+    dict.Set("part", val.part);
+    dict.Set("rects", rects);
+    return ConvertToV8(isolate, dict);
+  }
+};
 }  // namespace gin
@@ -0,0 +1,37 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "base/hash/hash.h"
+
+namespace electron::office {
+struct DocumentEventId {
+  const size_t document_id;
+  const int event_id;
+  const int view_id;
+
+  DocumentEventId(size_t doc_id, int evt_id, int view_id_)
+      : document_id(doc_id), event_id(evt_id), view_id(view_id_) {}
+
+  bool operator==(const DocumentEventId& other) const {
+    return (document_id == other.document_id && event_id == other.event_id &&
+            view_id == other.view_id);
+  }
+};
+}  // namespace electron::office
+
+namespace std {
+using electron::office::DocumentEventId;
+template <>
+struct ::std::hash<DocumentEventId> {
+  std::size_t operator()(const DocumentEventId& id) const {
+    return base::HashInts64(id.document_id,
+                            base::HashInts32(id.view_id, id.event_id));
+  }
+};
+}  // namespace std
@@ -0,0 +1,179 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/document_event_queue.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "base/bind.h"
+#include "base/location.h"
+
+namespace electron::office {
+
+struct DocumentEventQueue::Event {
+  Event(const DocumentEventId& id, int type, std::string payload)
+      : id(id),
+        type(type),
+        payload(std::move(payload)),
+        pushed(base::TimeTicks::Now()) {}
+
+  const DocumentEventId id;
+  const int type;
+  std::string payload;
+  const base::TimeTicks pushed;
+  Event* next = nullptr;
+};
+
+DocumentEventQueue::DocumentEventQueue(
+    scoped_refptr<base::SequencedTaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)) {
+  DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+DocumentEventQueue::~DocumentEventQueue() {
+  Event* event = head_.exchange(nullptr, std::memory_order_acquire);
+  while (event) {
+    Event* next = event->next;
+    delete event;
+    event = next;
+  }
+}
+
+void DocumentEventQueue::Push(const DocumentEventId& id,
+                              int type,
+                              std::string payload) {
+  Event* event = new Event(id, type, std::move(payload));
+  event->next = head_.load(std::memory_order_relaxed);
+  while (!head_.compare_exchange_weak(event->next, event,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+
+  // only the first push after a drain starts schedules the next one
+  if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    task_runner_->PostTask(FROM_HERE,
+                           base::BindOnce(&DocumentEventQueue::Drain, this));
+  }
+}
+
+bool DocumentEventQueue::RunsTasksInCurrentSequence() const {
+  return task_runner_->RunsTasksInCurrentSequence();
+}
+
+void DocumentEventQueue::Drain() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // cleared before taking the events, so that a push racing with this drain
+  // schedules another one instead of being stranded
+  drain_scheduled_.store(false, std::memory_order_release);
+  Event* event = head_.exchange(nullptr, std::memory_order_acquire);
+
+  // restore the order the events were pushed in
+  Event* ordered = nullptr;
+  size_t depth = 0;
+  while (event) {
+    Event* next = event->next;
+    event->next = ordered;
+    ordered = event;
+    event = next;
+    ++depth;
+  }
+  if (!depth)
+    return;
+
+  ++stats_.drains;
+  stats_.events += depth;
+  stats_.max_depth = std::max(stats_.max_depth, depth);
+
+  draining_ = true;
+  base::TimeTicks now = base::TimeTicks::Now();
+  while (ordered) {
+    std::unique_ptr<Event> current(ordered);
+    ordered = current->next;
+
+    base::TimeDelta latency = now - current->pushed;
+    stats_.total_latency += latency;
+    stats_.max_latency = std::max(stats_.max_latency, latency);
+
+    auto it = observers_.find(current->id);
+    if (it == observers_.end())
+      continue;
+    for (DocumentEventObserver& observer : it->second) {
+      observer.DocumentCallback(current->type, current->payload);
+    }
+  }
+  draining_ = false;
+  EraseEmptyObserverLists();
+}
+
+bool DocumentEventQueue::AddObserver(const DocumentEventId& id,
+                                     DocumentEventObserver* observer) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto& list = observers_[id];
+  bool first = list.empty();
+  if (!list.HasObserver(observer))
+    list.AddObserver(observer);
+  return first;
+}
+
+bool DocumentEventQueue::RemoveObserver(const DocumentEventId& id,
+                                        DocumentEventObserver* observer) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto it = observers_.find(id);
+  if (it == observers_.end())
+    return false;
+
+  it->second.RemoveObserver(observer);
+  if (!it->second.empty())
+    return false;
+
+  if (!draining_)
+    observers_.erase(it);
+  return true;
+}
+
+std::vector<DocumentEventId> DocumentEventQueue::RemoveObservers(
+    size_t document_id,
+    DocumentEventObserver* observer) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  std::vector<DocumentEventId> emptied;
+  for (auto& [id, list] : observers_) {
+    if (id.document_id != document_id || list.empty())
+      continue;
+
+    if (observer) {
+      list.RemoveObserver(observer);
+    } else {
+      list.Clear();
+    }
+    if (list.empty())
+      emptied.push_back(id);
+  }
+
+  if (!draining_)
+    EraseEmptyObserverLists();
+  return emptied;
+}
+
+void DocumentEventQueue::EraseEmptyObserverLists() {
+  for (auto it = observers_.begin(); it != observers_.end();) {
+    if (it->second.empty()) {
+      it = observers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+DocumentEventQueue::Stats DocumentEventQueue::GetStats() const {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  return stats_;
+}
+
+void DocumentEventQueue::ResetStats() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  stats_ = {};
+}
+
+}  // namespace electron::office
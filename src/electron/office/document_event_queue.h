@@ -0,0 +1,91 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/observer_list.h"
+#include "base/sequence_checker.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/time/time.h"
+#include "office/document_event_id.h"
+#include "office/document_event_observer.h"
+
+namespace electron::office {
+
+// Delivers LOK document events to the observers on one sequence.
+//
+// LOK callbacks push into a lock-free stack from any thread, and a single
+// drain task dispatches everything pushed since the last drain, in order. This
+// replaces posting a task per observer per event, which for a burst of
+// invalidations across several views and event types was thousands of tasks.
+class DocumentEventQueue
+    : public base::RefCountedThreadSafe<DocumentEventQueue> {
+ public:
+  struct Stats {
+    uint64_t events = 0;
+    uint64_t drains = 0;
+    // the most events dispatched by a single drain
+    size_t max_depth = 0;
+    // time from the push until the event is dispatched
+    base::TimeDelta total_latency;
+    base::TimeDelta max_latency;
+  };
+
+  explicit DocumentEventQueue(
+      scoped_refptr<base::SequencedTaskRunner> task_runner);
+
+  // disable copy
+  DocumentEventQueue(const DocumentEventQueue&) = delete;
+  DocumentEventQueue& operator=(const DocumentEventQueue&) = delete;
+
+  // can be called from any thread
+  void Push(const DocumentEventId& id, int type, std::string payload);
+  bool RunsTasksInCurrentSequence() const;
+  const scoped_refptr<base::SequencedTaskRunner>& task_runner() const {
+    return task_runner_;
+  }
+
+  // must be called on the queue's sequence {
+  // returns true if this is the first observer of the id on this queue
+  bool AddObserver(const DocumentEventId& id, DocumentEventObserver* observer);
+  // returns true if the id has no observers left on this queue
+  bool RemoveObserver(const DocumentEventId& id,
+                      DocumentEventObserver* observer);
+  // removes the observer from every event of the document, or every observer
+  // if it is null, returns the ids left without observers
+  std::vector<DocumentEventId> RemoveObservers(size_t document_id,
+                                               DocumentEventObserver* observer);
+  Stats GetStats() const;
+  void ResetStats();
+  // }
+
+ private:
+  friend class base::RefCountedThreadSafe<DocumentEventQueue>;
+  ~DocumentEventQueue();
+
+  struct Event;
+  void Drain();
+  void EraseEmptyObserverLists();
+
+  const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  // most recently pushed first, reversed when drained
+  std::atomic<Event*> head_{nullptr};
+  std::atomic<bool> drain_scheduled_{false};
+
+  std::unordered_map<DocumentEventId, base::ObserverList<DocumentEventObserver>>
+      observers_;
+  // observer lists can't be erased while they're being iterated
+  bool draining_ = false;
+  Stats stats_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+};
+
+}  // namespace electron::office
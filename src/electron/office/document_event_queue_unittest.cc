@@ -0,0 +1,108 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/document_event_queue.h"
+
+#include "base/run_loop.h"
+#include "base/task/thread_pool.h"
+#include "base/test/task_environment.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+namespace {
+class RecordingObserver : public DocumentEventObserver {
+ public:
+  void DocumentCallback(int type, std::string payload) override {
+    payloads.push_back(std::move(payload));
+  }
+
+  std::vector<std::string> payloads;
+};
+}  // namespace
+
+class DocumentEventQueueTest : public testing::Test {
+ protected:
+  base::test::TaskEnvironment task_environment_;
+};
+
+TEST_F(DocumentEventQueueTest, DispatchesInOrderWithOneDrain) {
+  auto queue = base::MakeRefCounted<DocumentEventQueue>(
+      base::SequencedTaskRunnerHandle::Get());
+  DocumentEventId id{1, 2, 3};
+  RecordingObserver observer;
+  EXPECT_TRUE(queue->AddObserver(id, &observer));
+
+  queue->Push(id, 2, "a");
+  queue->Push(id, 2, "b");
+  queue->Push(id, 2, "c");
+  // a different view isn't observed
+  queue->Push({1, 2, 4}, 2, "d");
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_THAT(observer.payloads, testing::ElementsAre("a", "b", "c"));
+  DocumentEventQueue::Stats stats = queue->GetStats();
+  EXPECT_EQ(stats.events, uint64_t(4));
+  EXPECT_EQ(stats.drains, uint64_t(1));
+  EXPECT_EQ(stats.max_depth, size_t(4));
+
+  queue->ResetStats();
+  EXPECT_EQ(queue->GetStats().events, uint64_t(0));
+}
+
+TEST_F(DocumentEventQueueTest, AcceptsPushesFromOtherThreads) {
+  auto queue = base::MakeRefCounted<DocumentEventQueue>(
+      base::SequencedTaskRunnerHandle::Get());
+  DocumentEventId id{1, 2, 3};
+  RecordingObserver observer;
+  queue->AddObserver(id, &observer);
+
+  constexpr int kThreads = 8;
+  constexpr int kEventsPerThread = 100;
+  for (int i = 0; i < kThreads; ++i) {
+    base::ThreadPool::PostTask(
+        FROM_HERE, base::BindOnce(
+                       [](scoped_refptr<DocumentEventQueue> queue,
+                          DocumentEventId id) {
+                         for (int j = 0; j < kEventsPerThread; ++j) {
+                           queue->Push(id, 2, "payload");
+                         }
+                       },
+                       queue, id));
+  }
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ(observer.payloads.size(), size_t(kThreads * kEventsPerThread));
+  EXPECT_EQ(queue->GetStats().events, uint64_t(kThreads * kEventsPerThread));
+}
+
+TEST_F(DocumentEventQueueTest, RemovesObservers) {
+  auto queue = base::MakeRefCounted<DocumentEventQueue>(
+      base::SequencedTaskRunnerHandle::Get());
+  DocumentEventId id{1, 2, 3};
+  DocumentEventId id2{1, 5, 3};
+  RecordingObserver observer;
+  RecordingObserver observer_two;
+  EXPECT_TRUE(queue->AddObserver(id, &observer));
+  EXPECT_FALSE(queue->AddObserver(id, &observer_two));
+  EXPECT_TRUE(queue->AddObserver(id2, &observer));
+
+  EXPECT_FALSE(queue->RemoveObserver(id, &observer));
+  EXPECT_EQ(queue->RemoveObservers(1, &observer).size(), size_t(1));
+
+  queue->Push(id, 2, "a");
+  queue->Push(id2, 5, "b");
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(observer.payloads.empty());
+  EXPECT_THAT(observer_two.payloads, testing::ElementsAre("a"));
+
+  EXPECT_EQ(queue->RemoveObservers(1, nullptr).size(), size_t(1));
+  queue->Push(id, 2, "c");
+  base::RunLoop().RunUntilIdle();
+  EXPECT_THAT(observer_two.payloads, testing::ElementsAre("a"));
+}
+
+}  // namespace electron::office
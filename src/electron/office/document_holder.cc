@@ -2,6 +2,7 @@
 // Use of this source code is governed by the MIT license that can be
 // found in the LICENSE file.
 #include "office/document_holder.h"
+#include <utility>
 #include <vector>
 #include "LibreOfficeKit/LibreOfficeKit.hxx"
 #include "base/bind.h"
@@ -22,27 +23,41 @@ DocumentHolder::DocumentHolder(lok::Document* owned_document,
       path_(path),
       doc_(owned_document) {}
 
-DocumentHolder::~DocumentHolder() = default;
+DocumentHolder::~DocumentHolder() {
+  // a document loaded later can reuse the address
+  OfficeInstance* office = OfficeInstance::Get();
+  office->LockView();
+  office->ForgetViewLocked();
+  office->UnlockView();
+}
 
 // holder constructor
 DocumentHolderWithView::DocumentHolderWithView(
     const scoped_refptr<DocumentHolder>& holder)
     : holder_(holder) {
   auto& owned_document = holder_->doc_;
-  int count = owned_document->getViewsCount();
-  if (count == 0) {
-    view_id_ = owned_document->createView();
-  } else if (holder_->HasOneRef()) {
-    CHECK(count == 1);
-    // getting the current view is not reliable, so we get the list
-    std::vector<int> ids(count);
-    owned_document->getViewIds(ids.data(), count);
-    view_id_ = ids[0];
-  } else {
-    view_id_ = owned_document->createView();
+  {
+    OfficeInstance* office = OfficeInstance::Get();
+    office->LockView();
+    int count = owned_document->getViewsCount();
+    if (count == 0) {
+      view_id_ = owned_document->createView();
+    } else if (holder_->HasOneRef()) {
+      CHECK(count == 1);
+      // getting the current view is not reliable, so we get the list
+      std::vector<int> ids(count);
+      owned_document->getViewIds(ids.data(), count);
+      view_id_ = ids[0];
+    } else {
+      view_id_ = owned_document->createView();
+    }
+    // loading a document or creating a view makes it the current view, but
+    // don't rely on it
+    office->ForgetViewLocked();
+    DCHECK(OfficeInstance::IsValid());
+    SetAsCurrentViewLocked();
+    office->UnlockView();
   }
-  DCHECK(OfficeInstance::IsValid());
-  SetAsCurrentView();
 
   owned_document->registerCallback(
       &OfficeInstance::HandleDocumentCallback,
@@ -62,7 +77,7 @@ DocumentHolderWithView& DocumentHolderWithView::operator=(
   if (this != &other) {
     holder_ = std::move(other.holder_);
     view_id_ = other.view_id_;
-    other.deregisters_callback_ = false;
+    deregisters_callback_ = std::exchange(other.deregisters_callback_, false);
   }
   return *this;
 }
@@ -101,8 +116,40 @@ int DocumentHolderWithView::ViewId() const {
 }
 
 void DocumentHolderWithView::SetAsCurrentView() const {
+  OfficeInstance* office = OfficeInstance::Get();
+  office->LockView();
+  SetAsCurrentViewLocked();
+  office->UnlockView();
+}
+
+void DocumentHolderWithView::SetAsCurrentViewLocked() const {
   CHECK(view_id_ > -1);
-  holder_->doc_->setView(view_id_);
+  // setView drops view-specific caches in LOK, so switching to the view that
+  // is already current is skipped
+  if (OfficeInstance::Get()->SetViewLocked(holder_->doc_.get(), view_id_))
+    ++holder_->view_switches_;
+}
+
+uint64_t DocumentHolderWithView::ViewSwitchCount() const {
+  if (!holder_)
+    return 0;
+  return holder_->view_switches_;
+}
+
+DocumentHolderWithView::ViewSession::ViewSession(
+    const DocumentHolderWithView& holder)
+    : holder_(holder) {
+  OfficeInstance::Get()->LockView();
+  holder_.SetAsCurrentViewLocked();
+}
+
+DocumentHolderWithView::ViewSession::~ViewSession() {
+  OfficeInstance::Get()->UnlockView();
+}
+
+lok::Document* DocumentHolderWithView::ViewSession::operator->() const {
+  holder_.SetAsCurrentViewLocked();
+  return holder_.holder_->doc_.get();
 }
 
 lok::Document& DocumentHolderWithView::operator*() const {
@@ -112,11 +159,10 @@ lok::Document& DocumentHolderWithView::operator*() const {
   return *holder_->doc_;
 }
 
-lok::Document* DocumentHolderWithView::operator->() const {
+DocumentHolderWithView::ViewSession DocumentHolderWithView::operator->()
+    const {
   DCHECK(holder_);
-
-  SetAsCurrentView();
-  return holder_->doc_.get();
+  return ViewSession(*this);
 }
 
 DocumentHolderWithView::operator bool() const {
@@ -139,8 +185,7 @@ DocumentHolderWithView::~DocumentHolderWithView() {
   if (!deregisters_callback_)
     return;
 
-  SetAsCurrentView();
-  holder_->doc_->registerCallback(nullptr, nullptr);
+  ViewSession(*this)->registerCallback(nullptr, nullptr);
 }
 
 DocumentHolderWithView DocumentHolderWithView::NewView() {
@@ -173,6 +218,13 @@ void DocumentHolderWithView::PostBlocking(
       base::BindOnce(std::move(callback), *this));
 }
 
+void DocumentHolderWithView::PostBlocking(
+    scoped_refptr<base::SequencedTaskRunner> runner,
+    base::OnceCallback<void(DocumentHolderWithView holder)> callback,
+    const base::Location& from_here) const {
+  runner->PostTask(from_here, base::BindOnce(std::move(callback), *this));
+}
+
 void DocumentHolderWithView::AddDocumentObserver(
     int event_id,
     DocumentEventObserver* observer) {
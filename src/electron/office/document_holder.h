@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include "base/callback_forward.h"
 #include "base/memory/ref_counted_delete_on_sequence.h"
@@ -25,6 +27,8 @@ class DocumentHolder : public base::RefCountedDeleteOnSequence<DocumentHolder> {
  private:
   const std::string path_;
   std::unique_ptr<lok::Document> doc_;
+  // the number of times LOK switched to one of the document's views
+  std::atomic<uint64_t> view_switches_ = 0;
   friend class base::RefCountedDeleteOnSequence<DocumentHolder>;
   friend class base::DeleteHelper<DocumentHolder>;
   friend class DocumentHolderWithView;
@@ -52,8 +56,12 @@ class DocumentHolderWithView {
   DocumentHolderWithView();
   ~DocumentHolderWithView();
 
+  class ViewSession;
+
+  // the view is only guaranteed to be current for the call that follows
   lok::Document& operator*() const;
-  lok::Document* operator->() const;
+  // holds the view until the call through it returns
+  ViewSession operator->() const;
   explicit operator bool() const;
   bool operator==(const DocumentHolderWithView& other) const;
   bool operator!=(const DocumentHolderWithView& other) const;
@@ -68,6 +76,28 @@ class DocumentHolderWithView {
    */
   void SetAsCurrentView() const;
 
+  // Holds the view for a group of calls, so they pay for a single switch.
+  // Other threads wait until the session ends to switch views, of any
+  // document, since LOK has one current view for the process. Calls on the
+  // same thread, through the holder or another session, don't wait.
+  class ViewSession {
+   public:
+    explicit ViewSession(const DocumentHolderWithView& holder);
+    ~ViewSession();
+
+    ViewSession(const ViewSession&) = delete;
+    ViewSession& operator=(const ViewSession&) = delete;
+
+    // switches back if a call on this thread went to another view
+    lok::Document* operator->() const;
+
+   private:
+    const DocumentHolderWithView& holder_;
+  };
+
+  // the number of times LOK switched views for the document
+  uint64_t ViewSwitchCount() const;
+
   void Post(base::OnceCallback<void(DocumentHolderWithView holder)> callback,
             const base::Location& from_here = FROM_HERE) const;
   void Post(
@@ -79,6 +109,11 @@ class DocumentHolderWithView {
   void PostBlocking(
       base::OnceCallback<void(DocumentHolderWithView holder)> callback,
       const base::Location& from_here = FROM_HERE) const;
+  // Like PostBlocking, but runs in order with the other tasks of `runner`
+  void PostBlocking(
+      scoped_refptr<base::SequencedTaskRunner> runner,
+      base::OnceCallback<void(DocumentHolderWithView holder)> callback,
+      const base::Location& from_here = FROM_HERE) const;
 
   const std::string& Path() const;
 
@@ -93,6 +128,8 @@ class DocumentHolderWithView {
   bool deregisters_callback_ = false;
 
   size_t PtrToId();
+  // requires the view to be locked
+  void SetAsCurrentViewLocked() const;
 };
 
 struct DocumentCallbackContext {
@@ -0,0 +1,56 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/document_image.h"
+
+#include <algorithm>
+
+#include "LibreOfficeKit/LibreOfficeKit.hxx"
+#include "cc/paint/paint_image_builder.h"
+#include "office/tile_format.h"
+#include "third_party/skia/include/core/SkData.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
+
+namespace electron::office {
+
+cc::PaintImage RenderDocumentImage(const DocumentHolderWithView& document,
+                                   int part,
+                                   const gfx::Rect& rect_twips,
+                                   const gfx::Size& size_px,
+                                   SkColor background) {
+  if (!document || size_px.IsEmpty() || rect_twips.IsEmpty())
+    return {};
+
+  DocumentHolderWithView::ViewSession session(document);
+  const SkImageInfo image_info =
+      SkImageInfo::Make(size_px.width(), size_px.height(),
+                        TileColorType(session->getTileMode()),
+                        kPremul_SkAlphaType);
+  sk_sp<SkData> data =
+      SkData::MakeUninitialized(image_info.computeMinByteSize());
+  uint8_t* buffer = static_cast<uint8_t*>(data->writable_data());
+  std::fill_n(reinterpret_cast<uint32_t*>(buffer),
+              data->size() / sizeof(uint32_t), background);
+
+  if (part < 0) {
+    session->paintTile(buffer, size_px.width(), size_px.height(),
+                       rect_twips.x(), rect_twips.y(), rect_twips.width(),
+                       rect_twips.height());
+  } else {
+    // mode 0 is the normal slide, as opposed to notes or the master
+    session->paintPartTile(buffer, part, 0, size_px.width(), size_px.height(),
+                           rect_twips.x(), rect_twips.y(), rect_twips.width(),
+                           rect_twips.height());
+  }
+
+  return cc::PaintImageBuilder::WithDefault()
+      .set_id(cc::PaintImage::GetNextId())
+      .set_image(SkImage::MakeRasterData(image_info, std::move(data),
+                                         image_info.minRowBytes()),
+                 cc::PaintImage::GetNextContentId())
+      .TakePaintImage();
+}
+
+}  // namespace electron::office
@@ -0,0 +1,27 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "cc/paint/paint_image.h"
+#include "office/document_holder.h"
+#include "third_party/skia/include/core/SkColor.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace electron::office {
+
+// Renders `rect_twips` of the document into a single image of `size_px`,
+// over `background`, for what is painted whole instead of in tiles, like a
+// slide or a printed page.
+//
+// A `part` of -1 paints the part shown in the view, otherwise `part` is
+// painted without switching the part shown in the view. Blocks on LOK.
+cc::PaintImage RenderDocumentImage(const DocumentHolderWithView& document,
+                                   int part,
+                                   const gfx::Rect& rect_twips,
+                                   const gfx::Size& size_px,
+                                   SkColor background);
+
+}  // namespace electron::office
@@ -0,0 +1,231 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/export_job.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "LibreOfficeKit/LibreOfficeKit.hxx"
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/escape.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/values.h"
+#include "gin/dictionary.h"
+#include "gin/object_template_builder.h"
+#include "gin/per_isolate_data.h"
+#include "url/gurl.h"
+
+namespace electron::office {
+
+gin::WrapperInfo ExportJob::kWrapperInfo = {gin::kEmbedderNativeGin};
+
+ExportJob::ExportJob(v8::Isolate* isolate,
+                     DocumentHolderWithView document,
+                     std::string url,
+                     std::string format,
+                     std::string filter,
+                     int total_pages,
+                     v8::Local<v8::Value> on_progress)
+    : document_(std::move(document)),
+      total_pages_(total_pages),
+      cancel_flag_(CancelFlag::Create()),
+      isolate_(isolate) {
+  if (on_progress->IsFunction())
+    on_progress_.emplace(isolate, on_progress);
+
+  for (int type : {LOK_CALLBACK_STATUS_INDICATOR_START,
+                   LOK_CALLBACK_STATUS_INDICATOR_SET_VALUE}) {
+    document_.AddDocumentObserver(type, this);
+  }
+
+  Promise<bool> promise(isolate);
+  done_.Reset(isolate, promise.GetHandle());
+  document_.PostBlocking(base::BindOnce(
+      [](std::string url, std::string format, std::string filter,
+         CancelFlagPtr cancel_flag, base::WeakPtr<ExportJob> job,
+         Promise<bool> promise, DocumentHolderWithView document) {
+        const bool result = Export(std::move(url), std::move(format),
+                                   std::move(filter), std::move(cancel_flag),
+                                   std::move(document));
+        promise.task_runner()->PostTask(
+            FROM_HERE, base::BindOnce(&ExportJob::OnExported, std::move(job),
+                                      std::move(promise), result));
+      },
+      std::move(url), std::move(format), std::move(filter), cancel_flag_,
+      weak_factory_.GetWeakPtr(), std::move(promise)));
+}
+
+ExportJob::~ExportJob() {
+  // the export itself can't be stopped, but nobody is left to see it
+  CancelFlag::Set(cancel_flag_);
+  if (document_)
+    document_.RemoveDocumentObservers(this);
+}
+
+gin::ObjectTemplateBuilder ExportJob::GetObjectTemplateBuilder(
+    v8::Isolate* isolate) {
+  gin::PerIsolateData* data = gin::PerIsolateData::From(isolate);
+  v8::Local<v8::FunctionTemplate> constructor =
+      data->GetFunctionTemplate(&kWrapperInfo);
+  if (constructor.IsEmpty()) {
+    constructor = v8::FunctionTemplate::New(isolate);
+    constructor->SetClassName(gin::StringToV8(isolate, GetTypeName()));
+    constructor->ReadOnlyPrototype();
+    data->SetFunctionTemplate(&kWrapperInfo, constructor);
+  }
+  return gin::ObjectTemplateBuilder(isolate, GetTypeName(),
+                                    constructor->InstanceTemplate())
+      .SetProperty("done", &ExportJob::Done)
+      .SetProperty("progress", &ExportJob::Progress)
+      .SetMethod("cancel", &ExportJob::Cancel);
+}
+
+const char* ExportJob::GetTypeName() {
+  return "ExportJob";
+}
+
+void ExportJob::DocumentCallback(int type, std::string payload) {
+  if (finished_)
+    return;
+
+  int percent = 0;
+  if (type == LOK_CALLBACK_STATUS_INDICATOR_SET_VALUE &&
+      !base::StringToInt(payload, &percent)) {
+    return;
+  }
+  percent = std::clamp(percent, 0, 100);
+  if (percent == percent_)
+    return;
+  percent_ = percent;
+
+  if (on_progress_) {
+    V8FunctionInvoker<void(v8::Local<v8::Value>)>::Go(isolate_, *on_progress_,
+                                                      Progress(isolate_));
+  }
+}
+
+// static
+int ExportJob::CountPages(base::StringPiece range, int page_count) {
+  if (base::TrimWhitespaceASCII(range, base::TRIM_ALL).empty())
+    return page_count;
+
+  std::vector<bool> pages(page_count);
+  for (base::StringPiece part : base::SplitStringPiece(
+           range, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    const size_t dash = part.find('-');
+    base::StringPiece first_str = part.substr(0, dash);
+    base::StringPiece last_str =
+        dash == base::StringPiece::npos ? first_str : part.substr(dash + 1);
+    int first = 1;
+    int last = page_count;
+    // "-3" is the first three pages and "3-" is every page from the third
+    if (!first_str.empty() &&
+        !base::StringToInt(base::TrimWhitespaceASCII(first_str, base::TRIM_ALL),
+                           &first))
+      return -1;
+    if (!last_str.empty() &&
+        !base::StringToInt(base::TrimWhitespaceASCII(last_str, base::TRIM_ALL),
+                           &last))
+      return -1;
+    if (first < 1 || last < first)
+      return -1;
+    for (int page = first; page <= std::min(last, page_count); ++page)
+      pages[page - 1] = true;
+  }
+  return std::count(pages.begin(), pages.end(), true);
+}
+
+// static
+bool ExportJob::AddPageRange(base::StringPiece range, std::string* filter) {
+  base::Value options(base::Value::Type::DICTIONARY);
+  if (!filter->empty()) {
+    absl::optional<base::Value> parsed = base::JSONReader::Read(*filter);
+    if (!parsed || !parsed->is_dict())
+      return false;
+    options = std::move(*parsed);
+  }
+
+  // the PDF export's filter data, as a UNO property
+  base::Value page_range(base::Value::Type::DICTIONARY);
+  page_range.SetStringKey("type", "string");
+  page_range.SetStringKey("value", range);
+  options.SetKey("PageRange", std::move(page_range));
+  return base::JSONWriter::Write(options, filter);
+}
+
+v8::Local<v8::Promise> ExportJob::Done(v8::Isolate* isolate) {
+  return done_.Get(isolate);
+}
+
+v8::Local<v8::Value> ExportJob::Progress(v8::Isolate* isolate) {
+  gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+  dict.Set("percent", percent_);
+  // 0 when the page count isn't known, spreadsheets for instance
+  dict.Set("total", total_pages_);
+  dict.Set("pages", total_pages_ * percent_ / 100);
+  return gin::ConvertToV8(isolate, dict);
+}
+
+void ExportJob::Cancel() {
+  CancelFlag::Set(cancel_flag_);
+}
+
+// static
+bool ExportJob::Export(std::string url,
+                       std::string format,
+                       std::string filter,
+                       CancelFlagPtr cancel_flag,
+                       DocumentHolderWithView document) {
+  if (CancelFlag::IsCancelled(cancel_flag))
+    return false;
+
+  bool result = document->saveAs(url.c_str(),
+                                 format.empty() ? nullptr : format.c_str(),
+                                 filter.empty() ? nullptr : filter.c_str());
+
+  // cancelled while LOK was writing, the output is incomplete as far as the
+  // caller is concerned
+  if (CancelFlag::IsCancelled(cancel_flag)) {
+    const GURL file_url(url);
+    if (result && file_url.SchemeIsFile()) {
+      base::DeleteFile(base::FilePath::FromUTF8Unsafe(
+          base::UnescapeBinaryURLComponent(file_url.path())));
+    }
+    result = false;
+  }
+  return result;
+}
+
+// static
+void ExportJob::OnExported(base::WeakPtr<ExportJob> job,
+                           Promise<bool> promise,
+                           bool result) {
+  if (job)
+    job->Finish(result);
+  promise.Resolve(result);
+}
+
+void ExportJob::Finish(bool result) {
+  finished_ = true;
+  document_.RemoveDocumentObservers(this);
+  if (!result || percent_ == 100)
+    return;
+
+  percent_ = 100;
+  if (on_progress_) {
+    V8FunctionInvoker<void(v8::Local<v8::Value>)>::Go(isolate_, *on_progress_,
+                                                      Progress(isolate_));
+  }
+}
+
+}  // namespace electron::office
@@ -0,0 +1,91 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <string>
+
+#include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
+#include "gin/wrappable.h"
+#include "office/cancellation_flag.h"
+#include "office/document_event_observer.h"
+#include "office/document_holder.h"
+#include "office/promise.h"
+#include "office/v8_callback.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+#include "v8/include/v8-persistent-handle.h"
+
+namespace electron::office {
+
+// An export of a document running on the thread pool, exposed to JS as the
+// handle returned by DocumentClient.exportAs.
+//
+// LOK exports in a single blocking saveAs, so progress comes from the status
+// indicator LOK updates while it writes, converted to pages, and cancelling
+// stops an export that hasn't started yet or discards the output of one that
+// has.
+class ExportJob : public gin::Wrappable<ExportJob>,
+                  public DocumentEventObserver {
+ public:
+  ExportJob(v8::Isolate* isolate,
+            DocumentHolderWithView document,
+            std::string url,
+            std::string format,
+            std::string filter,
+            int total_pages,
+            v8::Local<v8::Value> on_progress);
+  ~ExportJob() override;
+
+  ExportJob(const ExportJob&) = delete;
+  ExportJob& operator=(const ExportJob&) = delete;
+
+  // gin::Wrappable
+  static gin::WrapperInfo kWrapperInfo;
+  gin::ObjectTemplateBuilder GetObjectTemplateBuilder(
+      v8::Isolate* isolate) override;
+  const char* GetTypeName() override;
+
+  // DocumentEventObserver
+  void DocumentCallback(int type, std::string payload) override;
+
+  // The number of pages in a 1-based page range like "1-3,5,8-", not counting
+  // pages past `page_count` or a page more than once, or -1 if the range is
+  // invalid
+  static int CountPages(base::StringPiece range, int page_count);
+
+  // Adds the page range to the JSON filter options `filter`, which can be
+  // empty. False if `filter` isn't a JSON object.
+  static bool AddPageRange(base::StringPiece range, std::string* filter);
+
+ private:
+  // Exposed to v8 {
+  v8::Local<v8::Promise> Done(v8::Isolate* isolate);
+  v8::Local<v8::Value> Progress(v8::Isolate* isolate);
+  void Cancel();
+  // }
+
+  static bool Export(std::string url,
+                     std::string format,
+                     std::string filter,
+                     CancelFlagPtr cancel_flag,
+                     DocumentHolderWithView document);
+  static void OnExported(base::WeakPtr<ExportJob> job,
+                         Promise<bool> promise,
+                         bool result);
+  void Finish(bool result);
+
+  DocumentHolderWithView document_;
+  const int total_pages_;
+  int percent_ = 0;
+  bool finished_ = false;
+  CancelFlagPtr cancel_flag_;
+  v8::Isolate* isolate_;
+  v8::Global<v8::Promise> done_;
+  absl::optional<SafeV8Function> on_progress_;
+
+  base::WeakPtrFactory<ExportJob> weak_factory_{this};
+};
+
+}  // namespace electron::office
@@ -0,0 +1,43 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/export_job.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(ExportJobTest, CountsPagesInRange) {
+  EXPECT_EQ(ExportJob::CountPages("", 10), 10);
+  EXPECT_EQ(ExportJob::CountPages("4", 10), 1);
+  EXPECT_EQ(ExportJob::CountPages("1-3, 5", 10), 4);
+  EXPECT_EQ(ExportJob::CountPages("8-", 10), 3);
+  EXPECT_EQ(ExportJob::CountPages("-2", 10), 2);
+  // overlapping ranges count a page once
+  EXPECT_EQ(ExportJob::CountPages("1-3,2-4", 10), 4);
+  // pages past the end aren't exported
+  EXPECT_EQ(ExportJob::CountPages("9-12", 10), 2);
+}
+
+TEST(ExportJobTest, RejectsInvalidRange) {
+  EXPECT_EQ(ExportJob::CountPages("a", 10), -1);
+  EXPECT_EQ(ExportJob::CountPages("0", 10), -1);
+  EXPECT_EQ(ExportJob::CountPages("3-1", 10), -1);
+  EXPECT_EQ(ExportJob::CountPages("1-2-3", 10), -1);
+}
+
+TEST(ExportJobTest, AddsPageRangeToFilter) {
+  std::string filter;
+  ASSERT_TRUE(ExportJob::AddPageRange("1-3", &filter));
+  EXPECT_EQ(filter, R"({"PageRange":{"type":"string","value":"1-3"}})");
+
+  filter = R"({"Quality":{"type":"long","value":"90"}})";
+  ASSERT_TRUE(ExportJob::AddPageRange("2", &filter));
+  EXPECT_NE(filter.find("Quality"), std::string::npos);
+  EXPECT_NE(filter.find(R"("value":"2")"), std::string::npos);
+
+  filter = "SkipImages";
+  EXPECT_FALSE(ExportJob::AddPageRange("2", &filter));
+}
+
+}  // namespace electron::office
@@ -0,0 +1,37 @@
+async function testPostUnoCommandAsync() {
+  const docClient = await libreoffice.loadDocument('private:factory/swriter');
+
+  const result = await docClient.postUnoCommandAsync('.uno:Bold');
+  assert(result.commandName === '.uno:Bold');
+  assert(result.success === true);
+
+  // commands posted in the same task are batched and resolve in order
+  const [first, second] = await Promise.all([
+    docClient.postUnoCommandAsync('.uno:Italic'),
+    docClient.postUnoCommandAsync('.uno:Underline'),
+  ]);
+  assert(first.commandName === '.uno:Italic');
+  assert(second.commandName === '.uno:Underline');
+
+  // cancelled before the batch is sent
+  const cancelled = docClient.postUnoCommandAsync('.uno:Bold');
+  assert(docClient.cancelUnoCommand('.uno:Bold') === 1);
+  assert((await cancelled).cancelled === true);
+
+  const afterCancel = await docClient.postUnoCommandAsync('.uno:Italic');
+  assert(afterCancel.commandName === '.uno:Italic');
+  assert(afterCancel.cancelled === undefined);
+
+  // a result requested by postUnoCommand isn't taken by a later async command
+  let results = 0;
+  docClient.on('uno_command_result', () => {
+    results++;
+  });
+  docClient.postUnoCommand('.uno:Bold', undefined, true);
+  const afterSync = await docClient.postUnoCommandAsync('.uno:Bold');
+  assert(afterSync.commandName === '.uno:Bold');
+  assert(afterSync.success === true);
+  assert(results === 2);
+}
+
+testPostUnoCommandAsync();
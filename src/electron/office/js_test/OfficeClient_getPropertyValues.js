@@ -0,0 +1,141 @@
+// a stand-in for a UNO bridge wrapper that only supports XPropertySet
+class FakePropertySet {
+  constructor(properties) {
+    this.properties = properties;
+  }
+  as(type) {
+    return type === 'beans.XPropertySet' ? this : null;
+  }
+  getPropertyValue(name) {
+    if (!(name in this.properties)) throw new Error('UnknownPropertyException');
+    return this.properties[name];
+  }
+}
+
+// a stand-in for wrappers of different UNO types sharing a prototype, like
+// the bridge's, which supports the interfaces in `types`
+class FakeUnoObject {
+  constructor(types, properties) {
+    this.types = types;
+    this.properties = properties;
+  }
+  as(type) {
+    return this.types.includes(type) ? this : null;
+  }
+  getPropertyValue(name) {
+    if (!(name in this.properties)) throw new Error('UnknownPropertyException');
+    return this.properties[name];
+  }
+  getPropertyValues(names) {
+    return names.map((name) => this.properties[name]);
+  }
+}
+
+function testMixedTypes() {
+  const objects = [
+    new FakeUnoObject(['beans.XPropertySet'], { Width: 1 }),
+    new FakeUnoObject(['beans.XMultiPropertySet'], { Width: 2 }),
+    new FakeUnoObject(['beans.XPropertySet'], { Width: 3 }),
+  ];
+  const result = libreoffice.getPropertyValues(objects, ['Width']);
+  // the second object is only read through XMultiPropertySet
+  assert(result.Width instanceof Float64Array);
+  assert(result.Width.join() === '1,2,3');
+}
+
+function testColumns() {
+  const objects = [
+    new FakePropertySet({ Width: 1, Name: 'a', Position: { X: 1, Y: 2 } }),
+    new FakePropertySet({ Width: 2.5, Name: 'b', Position: { X: 3, Y: 4 } }),
+    null,
+  ];
+  const result = libreoffice.getPropertyValues(objects, [
+    'Width',
+    'Name',
+    'Position',
+    'Missing',
+  ]);
+
+  // a missing object makes the numeric column an Array
+  assert(Array.isArray(result.Width));
+  assert(result.Width[1] === 2.5);
+  assert(result.Width[2] === undefined);
+  assert(result.Name[0] === 'a');
+  assert(result.Missing.every((value) => value === undefined));
+
+  const numbers = libreoffice.getPropertyValues(objects.slice(0, 2), [
+    'Width',
+    'Position',
+  ]);
+  assert(numbers.Width instanceof Float64Array);
+  assert(numbers.Width[1] === 2.5);
+  assert(numbers.Position.fields.join() === 'X,Y');
+  assert(numbers.Position.values.join() === '1,2,3,4');
+}
+
+// compares getPropertyValue on every paragraph with a single bulk read
+async function benchmarkParagraphs() {
+  const docClient = await libreoffice.loadDocument('private:factory/swriter');
+  const xText = docClient.as('text.XTextDocument').getText();
+  const paragraphCount = 500;
+  xText.setString(
+    Array.from({ length: paragraphCount }, (_, i) => `paragraph ${i}`).join(
+      '\n'
+    )
+  );
+
+  const cursor = xText.createTextCursor();
+  cursor.gotoStart(false);
+  const xParagraphCursor = cursor.as('text.XParagraphCursor');
+  const paragraphs = [];
+  do {
+    const paragraph = xText.createTextCursorByRange(cursor);
+    paragraph.as('text.XParagraphCursor').gotoEndOfParagraph(true);
+    paragraphs.push(paragraph);
+  } while (xParagraphCursor.gotoNextParagraph(false));
+  assert(paragraphs.length === paragraphCount);
+
+  const names = ['CharHeight', 'CharWeight', 'ParaLeftMargin'];
+
+  // the fastest of a few rounds, so a pause doesn't decide the comparison
+  const rounds = 3;
+  let perObject;
+  let perObjectMs = Infinity;
+  for (let round = 0; round < rounds; ++round) {
+    const start = Date.now();
+    perObject = names.map(() => []);
+    for (const paragraph of paragraphs) {
+      const xPropertySet = paragraph.as('beans.XPropertySet');
+      names.forEach((name, i) =>
+        perObject[i].push(xPropertySet.getPropertyValue(name))
+      );
+    }
+    perObjectMs = Math.min(perObjectMs, Date.now() - start);
+  }
+
+  let bulk;
+  let bulkMs = Infinity;
+  for (let round = 0; round < rounds; ++round) {
+    const start = Date.now();
+    bulk = libreoffice.getPropertyValues(paragraphs, names);
+    bulkMs = Math.min(bulkMs, Date.now() - start);
+  }
+
+  names.forEach((name, i) => {
+    assert(bulk[name] instanceof Float64Array);
+    assert(bulk[name].length === paragraphCount);
+    for (let j = 0; j < paragraphCount; ++j)
+      assert(bulk[name][j] === perObject[i][j]);
+  });
+
+  // a call per paragraph instead of one per property
+  assert(bulkMs < perObjectMs);
+}
+
+async function testGetPropertyValues() {
+  testColumns();
+  testMixedTypes();
+  await benchmarkParagraphs();
+}
+
+testGetPropertyValues();
@@ -0,0 +1,16 @@
+async function testOfficeClientGetStartupTimings() {
+  const doc = await libreoffice.loadDocument('private:factory/swriter');
+  assert(doc != null);
+
+  const timings = libreoffice.getStartupTimings();
+  assert(timings != null);
+  assert(timings.lokInit > 0);
+  assert(timings.total >= timings.queued + timings.lokInit);
+  // the UNO bridge is only created once it is used
+  assert(timings.unoBridge === undefined);
+
+  doc.as('text.XTextDocument');
+  assert(libreoffice.getStartupTimings().unoBridge >= 0);
+}
+
+testOfficeClientGetStartupTimings();
@@ -38,13 +38,23 @@ uint64_t ParseLong(std::string_view::const_iterator& target,
   return value;
 }
 
+// like ParseLong, with an optional leading -
+int64_t ParseSignedLong(std::string_view::const_iterator& target,
+                        std::string_view::const_iterator end) {
+  if (target < end && *target == '-') {
+    ++target;
+    return -static_cast<int64_t>(ParseLong(target, end));
+  }
+  return ParseLong(target, end);
+}
+
 // simple, fast parse for a ,-separated list of longs, optionally terminated
 // with a ;
 // target comes from a stored iterator from a string_view
 // end is the end iterator from a string_view
-std::vector<uint64_t> ParseCSV(std::string_view::const_iterator& target,
-                               std::string_view::const_iterator end) {
-  std::vector<uint64_t> result;
+std::vector<int64_t> ParseCSV(std::string_view::const_iterator& target,
+                              std::string_view::const_iterator end) {
+  std::vector<int64_t> result;
   while (target < end) {
     if (*target == ';') {
       ++target;
@@ -55,11 +65,11 @@ std::vector<uint64_t> ParseCSV(std::string_view::const_iterator& target,
     SkipWhitespace(target, end);
 
     // no number follows, finish
-    if ((*target ^ '0') > 9) {
+    if (target == end || (*target != '-' && (*target ^ '0') > 9)) {
       return result;
     }
 
-    result.emplace_back(ParseLong(target, end));
+    result.emplace_back(ParseSignedLong(target, end));
   }
 
   return result;
@@ -69,10 +79,10 @@ std::vector<uint64_t> ParseCSV(std::string_view::const_iterator& target,
 // optionally terminated with a ;
 // target comes from a stored iterator from a string_view
 // end is the end iterator from a string_view
-std::vector<std::vector<uint64_t>> ParseMultipleCSV(
+std::vector<std::vector<int64_t>> ParseMultipleCSV(
     std::string_view::const_iterator& target,
     std::string_view::const_iterator end) {
-  std::vector<std::vector<uint64_t>> result;
+  std::vector<std::vector<int64_t>> result;
   while (target < end) {
     result.emplace_back(ParseCSV(target, end));
   }
@@ -80,9 +90,10 @@ std::vector<std::vector<uint64_t>> ParseMultipleCSV(
   return result;
 }
 
+// stops at a - as well, since it starts a negative number
 void SkipNonNumeric(std::string_view::const_iterator& target,
                     std::string_view::const_iterator end) {
-  while ((*target ^ '0') > 9) {
+  while (target < end && *target != '-' && (*target ^ '0') > 9) {
     ++target;
   }
 }
@@ -97,9 +108,9 @@ gfx::Rect ParseRect(std::string_view::const_iterator& target,
   if (target == end)
     return gfx::Rect();
 
-  long x = ParseLong(target, end);
+  long x = ParseSignedLong(target, end);
   SkipNonNumeric(target, end);
-  long y = ParseLong(target, end);
+  long y = ParseSignedLong(target, end);
   SkipNonNumeric(target, end);
   long w = ParseLong(target, end);
   SkipNonNumeric(target, end);
@@ -320,9 +331,9 @@ v8::Local<v8::Value> GraphicSelectionPayloadToLocalValue(v8::Isolate* isolate,
   std::string_view payload_sv(payload);
   std::string_view::const_iterator start = payload_sv.begin();
   std::string_view::const_iterator end = payload_sv.end();
-  std::vector<uint64_t> numbers = ParseCSV(start, end);
+  std::vector<int64_t> numbers = ParseCSV(start, end);
   auto numbers_v8 =
-      gin::Converter<std::vector<uint64_t>>::ToV8(isolate, numbers);
+      gin::Converter<std::vector<int64_t>>::ToV8(isolate, numbers);
 
   v8::Local<v8::Context> context = isolate->GetCurrentContext();
   auto result_array = v8::Array::New(isolate, 2);
@@ -362,17 +373,17 @@ v8::Local<v8::Value> PayloadToLocalValue(v8::Isolate* isolate,
   if (IsTypeCSV(type) && payload[0] != '{') {
     std::string_view payload_sv(payload);
     std::string_view::const_iterator start = payload_sv.begin();
-    std::vector<uint64_t> result = ParseCSV(start, payload_sv.end());
-    return gin::Converter<std::vector<uint64_t>>::ToV8(isolate, result);
+    std::vector<int64_t> result = ParseCSV(start, payload_sv.end());
+    return gin::Converter<std::vector<int64_t>>::ToV8(isolate, result);
   }
 
   if (IsTypeMultipleCSV(type)) {
     std::string_view payload_sv(payload);
     std::string_view::const_iterator start = payload_sv.begin();
-    std::vector<std::vector<uint64_t>> result =
+    std::vector<std::vector<int64_t>> result =
         ParseMultipleCSV(start, payload_sv.end());
-    return gin::Converter<std::vector<std::vector<uint64_t>>>::ToV8(isolate,
-                                                                    result);
+    return gin::Converter<std::vector<std::vector<int64_t>>>::ToV8(isolate,
+                                                                   result);
   }
 
   v8::MaybeLocal<v8::String> maybe_string =
@@ -18,9 +18,9 @@ bool IsTypeJSON(int type);
 bool IsTypeCSV(int type);
 bool IsTypeMultipleCSV(int type);
 
-std::vector<uint64_t> ParseCSV(std::string_view::const_iterator& target,
-                               std::string_view::const_iterator end);
-std::vector<std::vector<uint64_t>> ParseMultipleCSV(
+std::vector<int64_t> ParseCSV(std::string_view::const_iterator& target,
+                              std::string_view::const_iterator end);
+std::vector<std::vector<int64_t>> ParseMultipleCSV(
     std::string_view::const_iterator& target,
     std::string_view::const_iterator end);
 
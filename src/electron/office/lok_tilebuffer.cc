@@ -24,6 +24,7 @@
 #include "ui/gfx/geometry/rect.h"
 #include "ui/gfx/geometry/rect_conversions.h"
 #include "ui/gfx/geometry/rect_f.h"
+#include "ui/gfx/geometry/skia_conversions.h"
 
 // Uncomment to display debug painting
 // #define TILEBUFFER_DEBUG_PAINT
@@ -34,35 +35,68 @@ TileBuffer::TileBuffer()
           base::SequencedTaskRunnerHandle::Get()),
       valid_tile_(0),
       active_context_hash_(0) {
-  pool_buffer_ =
-      std::shared_ptr<uint8_t[]>(static_cast<uint8_t*>(base::AlignedAlloc(
-                                     kPoolAllocatedSize, kPoolAligned)),
-                                 base::AlignedFreeDeleter{});
-
-  std::fill_n(pool_index_to_tile_index_, kPoolSize, kInvalidTileIndex);
-}
-
-Snapshot::Snapshot(std::vector<cc::PaintImage> tiles_,
-                   float scale_,
-                   int column_start_,
-                   int column_end_,
-                   int row_start_,
-                   int row_end_,
-                   int scroll_y_position)
-    : tiles(std::move(tiles_)),
-      scale(scale_),
-      column_start(column_start_),
-      column_end(column_end_),
-      row_start(row_start_),
-      row_end(row_end_),
-      scroll_y_position(scroll_y_position) {}
-
-Snapshot::Snapshot() = default;
-Snapshot::~Snapshot() = default;
-Snapshot::Snapshot(const Snapshot& other) = default;
-Snapshot& Snapshot::operator=(const Snapshot& other) = default;
-Snapshot& Snapshot::operator=(Snapshot&& other) noexcept = default;
-Snapshot::Snapshot(Snapshot&& other) noexcept = default;
+  pool_buffer_ = AllocatePool();
+
+  std::fill_n(pool_index_to_tile_index_, kMaxPoolSize, kInvalidTileIndex);
+}
+
+// static
+std::shared_ptr<uint8_t[]> TileBuffer::AllocatePool() {
+  return std::shared_ptr<uint8_t[]>(
+      static_cast<uint8_t*>(
+          base::AlignedAlloc(kPoolAllocatedSize, kPoolAligned)),
+      base::AlignedFreeDeleter{});
+}
+
+void TileBuffer::TrimMemory() {
+  // in-flight paints keep their reference to the pool until they finish
+  ResetPool();
+  std::atomic_store(&pool_buffer_, std::shared_ptr<uint8_t[]>());
+}
+
+void TileBuffer::ResetPool() {
+  base::AutoLock lock(pool_lock_);
+  // in-flight paints see the generation change and drop their tile
+  ++trim_generation_;
+  InvalidateAllTiles();
+  std::fill_n(pool_index_to_tile_index_, kMaxPoolSize, kInvalidTileIndex);
+  pool_paint_images_.fill(cc::PaintImage());
+}
+
+void TileBuffer::EnsurePool() {
+  if (!std::atomic_load(&pool_buffer_))
+    std::atomic_store(&pool_buffer_, AllocatePool());
+}
+
+bool TileBuffer::IsTrimmed() {
+  return !std::atomic_load(&pool_buffer_);
+}
+
+void TileBuffer::TrimTilesOutside(TileRange keep) {
+  // a paint in flight for a dropped tile sees its slot cleared and drops it
+  base::AutoLock lock(pool_lock_);
+  for (size_t pool_index = 0; pool_index < pool_size_; ++pool_index) {
+    unsigned int tile_index = pool_index_to_tile_index_[pool_index];
+    if (tile_index == kInvalidTileIndex ||
+        (tile_index >= keep.index_start && tile_index <= keep.index_end))
+      continue;
+    InvalidatePoolTile(pool_index);
+    pool_paint_images_[pool_index] = cc::PaintImage();
+  }
+}
+
+void TileBuffer::AddMemoryStats(const Snapshot& snapshot, MemoryStats* stats) {
+  if (!IsTrimmed())
+    stats->tile_pool_bytes += kPoolAllocatedSize;
+
+  base::AutoLock lock(pool_lock_);
+  for (const cc::PaintImage& image : pool_paint_images_) {
+    if (image)
+      stats->tile_bytes += format_.Bytes();
+  }
+
+  stats->snapshot_bytes += snapshot.Bytes();
+}
 
 TileBuffer::~TileBuffer() = default;
 
@@ -74,16 +108,67 @@ void TileBuffer::Resize(long width_twips, long height_twips, float scale) {
   doc_width_scaled_px_ = lok_callback::TwipToPixel(doc_width_twips_, scale_);
   doc_height_scaled_px_ = lok_callback::TwipToPixel(doc_height_twips_, scale_);
 
-  columns_ = std::ceil(static_cast<double>(doc_width_scaled_px_) / kTileSizePx);
-  rows_ = std::ceil(static_cast<double>(doc_height_scaled_px_) / kTileSizePx);
+  columns_ =
+      std::ceil(static_cast<double>(doc_width_scaled_px_) / format_.size_px);
+  rows_ =
+      std::ceil(static_cast<double>(doc_height_scaled_px_) / format_.size_px);
 
   valid_tile_ = AtomicBitset(columns_ * rows_ + 1);
-  std::fill_n(pool_index_to_tile_index_, kPoolSize, kInvalidTileIndex);
+  std::fill_n(pool_index_to_tile_index_, kMaxPoolSize, kInvalidTileIndex);
 }
 
 void TileBuffer::Resize(long width_twips, long height_twips) {
-  if (doc_width_twips_ != width_twips || doc_height_twips_ != height_twips)
-    Resize(width_twips, height_twips, scale_);
+  if (doc_width_twips_ == width_twips && doc_height_twips_ == height_twips)
+    return;
+
+  const unsigned int columns = columns_;
+  const bool had_tiles = valid_tile_.Size() > 0;
+  doc_width_twips_ = width_twips;
+  doc_height_twips_ = height_twips;
+  doc_width_scaled_px_ = lok_callback::TwipToPixel(doc_width_twips_, scale_);
+  doc_height_scaled_px_ = lok_callback::TwipToPixel(doc_height_twips_, scale_);
+  columns_ =
+      std::ceil(static_cast<double>(doc_width_scaled_px_) / format_.size_px);
+  rows_ =
+      std::ceil(static_cast<double>(doc_height_scaled_px_) / format_.size_px);
+
+  if (!had_tiles || columns != columns_) {
+    valid_tile_ = AtomicBitset(columns_ * rows_ + 1);
+    std::fill_n(pool_index_to_tile_index_, kMaxPoolSize, kInvalidTileIndex);
+    return;
+  }
+
+  // Rows are added and removed at the bottom without changing the index of
+  // any tile above them, which is how a sheet grows as rows are resized or
+  // inserted. LOK invalidates the rows that moved, so the rest stay valid.
+  const unsigned int tile_count = columns_ * rows_;
+  valid_tile_.Resize(tile_count + 1);
+  for (unsigned int& tile_index : pool_index_to_tile_index_) {
+    if (tile_index != kInvalidTileIndex && tile_index >= tile_count)
+      tile_index = kInvalidTileIndex;
+  }
+}
+
+bool TileBuffer::SetFormat(const TileFormat& format) {
+  DCHECK_GE(format.size_px, TileFormat::kMinSizePx);
+  DCHECK_LE(format.size_px, TileFormat::kMaxSizePx);
+  if (format == format_)
+    return false;
+
+  {
+    // the pool is reused, only how it's divided changes, and a paint of the
+    // previous format doesn't store its tile
+    base::AutoLock lock(pool_lock_);
+    ++trim_generation_;
+    InvalidateAllTiles();
+    std::fill_n(pool_index_to_tile_index_, kMaxPoolSize, kInvalidTileIndex);
+    pool_paint_images_.fill(cc::PaintImage());
+    format_ = format;
+    pool_size_ = PoolSize(format_);
+  }
+  if (!IsEmpty())
+    Resize(doc_width_twips_, doc_height_twips_, scale_);
+  return true;
 }
 
 void TileBuffer::SetActiveContext(std::size_t active_context_hash) {
@@ -101,8 +186,6 @@ bool TileBuffer::PaintTile(CancelFlagPtr cancel_flag,
                            DocumentHolderWithView document,
                            unsigned int tile_index,
                            std::size_t context_hash) {
-  static const SkImageInfo image_info_ = SkImageInfo::Make(
-      kTileSizePx, kTileSizePx, kBGRA_8888_SkColorType, kPremul_SkAlphaType);
   size_t pool_index;
   const unsigned int max = columns_ * rows_ - 1;
   if (const std::size_t ah = active_context_hash_; ah != context_hash) {
@@ -110,6 +193,10 @@ bool TileBuffer::PaintTile(CancelFlagPtr cancel_flag,
     return false;
   }
 
+  std::shared_ptr<uint8_t[]> pool = std::atomic_load(&pool_buffer_);
+  if (!pool)
+    return false;
+
   if (tile_index > max) {
     // TODO: proper fix, this probably occurs after a zoom
     LOG(ERROR) << "invalid tile index: " << tile_index << ", exceeds max "
@@ -120,38 +207,54 @@ bool TileBuffer::PaintTile(CancelFlagPtr cancel_flag,
     return false;
   }
 
-  if (!TileToPoolIndex(tile_index, &pool_index)) {
-    InvalidatePoolTile(pool_index);
-    pool_index_to_tile_index_[pool_index] = tile_index;
+  uint64_t trim_generation;
+  TileFormat format;
+  {
+    // a format change after this bumps the generation, which drops the tile
+    base::AutoLock lock(pool_lock_);
+    trim_generation = trim_generation_;
+    format = format_;
+    if (!TileToPoolIndex(tile_index, pool_size_, &pool_index)) {
+      InvalidatePoolTile(pool_index);
+      pool_index_to_tile_index_[pool_index] = tile_index;
+    }
   }
+  const int tile_size = format.size_px;
+  const size_t stride = format.Bytes();
 
   if (!CancelFlag::IsCancelled(cancel_flag) &&
       tile_index < valid_tile_.Size() && !valid_tile_[tile_index]) {
     std::pair<int, int> coord = IndexToCoord(tile_index);
     int column = coord.first;
     int row = coord.second;
-    uint8_t* buffer = GetPoolBuffer(pool_index);
+    uint8_t* buffer = GetPoolBuffer(pool, pool_index, stride);
     std::fill_n(reinterpret_cast<uint32_t*>(buffer),
-                kBufferStride / sizeof(uint32_t), SK_ColorTRANSPARENT);
-    document->paintTile(buffer, kTileSizePx, kTileSizePx,
-                        lok_callback::PixelToTwip(kTileSizePx * column, scale_),
-                        lok_callback::PixelToTwip(kTileSizePx * row, scale_),
-                        lok_callback::PixelToTwip(kTileSizePx, scale_),
-                        lok_callback::PixelToTwip(kTileSizePx, scale_));
+                stride / sizeof(uint32_t), SK_ColorTRANSPARENT);
+    document->paintTile(buffer, tile_size, tile_size,
+                        lok_callback::PixelToTwip(tile_size * column, scale_),
+                        lok_callback::PixelToTwip(tile_size * row, scale_),
+                        lok_callback::PixelToTwip(tile_size, scale_),
+                        lok_callback::PixelToTwip(tile_size, scale_));
 
     if (const std::size_t ah = active_context_hash_; ah != context_hash) {
       valid_tile_.Clear();
       return false;
     }
     sk_sp<SkImage> image = SkImage::MakeRasterData(
-        image_info_,
-        SkData::MakeWithCopy(GetPoolBuffer(pool_index), kBufferStride),
-        kTileSizePx * kBytesPerPx);
-    pool_paint_images_[pool_index] =
+        format.ImageInfo(), SkData::MakeWithCopy(buffer, stride),
+        tile_size * TileFormat::kBytesPerPx);
+    cc::PaintImage paint_image =
         cc::PaintImageBuilder::WithDefault()
             .set_id(cc::PaintImage::GetNextId())
             .set_image(image, cc::PaintImage::GetNextContentId())
             .TakePaintImage();
+    // held until the tile is valid, so a trim can't drop it in between
+    base::AutoLock lock(pool_lock_);
+    // trimmed while painting, the slot may belong to another tile now
+    if (trim_generation != trim_generation_ ||
+        pool_index_to_tile_index_[pool_index] != tile_index)
+      return false;
+    pool_paint_images_[pool_index] = std::move(paint_image);
 
     // because valid_tile is critical to render, check after rasterization
     if (const std::size_t ah = active_context_hash_; ah != context_hash) {
@@ -189,7 +292,8 @@ gfx::Rect TileRect(const gfx::RectF& target,
 TileRange TileBuffer::InvalidateTilesInRect(const gfx::RectF& rect,
                                             bool dry_run) {
   auto tile_rect =
-      TileRect(rect, doc_width_scaled_px_, doc_height_scaled_px_, kTileSizePx);
+      TileRect(rect, doc_width_scaled_px_, doc_height_scaled_px_,
+               format_.size_px);
   DCHECK(tile_rect.x() >= 0);
   DCHECK(tile_rect.y() >= 0);
   DCHECK(tile_rect.width() >= 0);
@@ -230,9 +334,9 @@ std::vector<TileRange> TileBuffer::InvalidRangesRemaining(
 TileBuffer::RowLimit TileBuffer::LimitRange(int y_pos,
                                             unsigned int view_height) {
   unsigned int start_row = y_pos < 0 ? 0 :
-      std::floor((double)y_pos / (double)TileBuffer::kTileSizePx);
-  unsigned int end_row = start_row + std::ceil((double)view_height /
-                                               (double)TileBuffer::kTileSizePx);
+      std::floor((double)y_pos / (double)format_.size_px);
+  unsigned int end_row =
+      start_row + std::ceil((double)view_height / (double)format_.size_px);
   return {start_row, std::max(start_row, end_row)};
 }
 
@@ -279,7 +383,7 @@ TileRange TileBuffer::NextScrollTileRange(int next_y_pos,
 TileRange TileBuffer::InvalidateTilesInTwipRect(const gfx::Rect& rect_twips) {
   auto tile_rect = TileRect(std::move(gfx::RectF(rect_twips)), doc_width_twips_,
                             doc_height_twips_,
-                            lok_callback::PixelToTwip(kTileSizePx, scale_));
+                            lok_callback::PixelToTwip(format_.size_px, scale_));
   DCHECK(tile_rect.x() >= 0);
   DCHECK(tile_rect.y() >= 0);
   DCHECK(tile_rect.width() >= 0);
@@ -319,8 +423,9 @@ std::vector<TileRange> TileBuffer::PaintToCanvas(CancelFlagPtr cancel_flag,
 
   auto offset_rect = gfx::RectF(rect);
   offset_rect.Offset(0, y_pos_);
+  const int tile_size = format_.size_px;
   gfx::Rect tile_rect = TileRect(offset_rect, doc_width_scaled_px_,
-                                 doc_height_scaled_px_, kTileSizePx);
+                                 doc_height_scaled_px_, tile_size);
 
   DCHECK(tile_rect.x() >= 0);
   DCHECK(tile_rect.y() >= 0);
@@ -360,9 +465,9 @@ std::vector<TileRange> TileBuffer::PaintToCanvas(CancelFlagPtr cancel_flag,
       cc::PaintFlags debugPaint;
       debugPaint.setColor(SK_ColorRED);
       debugPaint.setStrokeWidth(1);
-      SkRect debugRect{(float)kTileSizePx * column, (float)kTileSizePx * row,
-                       (float)kTileSizePx * (column + 1),
-                       (float)kTileSizePx * (row + 1)};
+      SkRect debugRect{(float)tile_size * column, (float)tile_size * row,
+                       (float)tile_size * (column + 1),
+                       (float)tile_size * (row + 1)};
 
       SkFont font;
       font.setScaleX(0.5);
@@ -383,6 +488,7 @@ std::vector<TileRange> TileBuffer::PaintToCanvas(CancelFlagPtr cancel_flag,
     }
   }
 
+  const unsigned int visible_row_end = row_end;
   if (last_good_row != -1) {
     row_end = last_good_row;
   }
@@ -401,16 +507,16 @@ std::vector<TileRange> TileBuffer::PaintToCanvas(CancelFlagPtr cancel_flag,
         if (!TileToPoolIndex(tile_index, &pool_index)) {
           return missing_ranges;
         }
-        canvas->drawImage(pool_paint_images_[pool_index], kTileSizePx * column,
-                          kTileSizePx * row,
+        canvas->drawImage(pool_paint_images_[pool_index], tile_size * column,
+                          tile_size * row,
                           SkSamplingOptions(SkFilterMode::kLinear), &flags);
 #ifdef TILEBUFFER_DEBUG_PAINT
         cc::PaintFlags debugPaint;
         debugPaint.setColor(SK_ColorBLUE);
         debugPaint.setStrokeWidth(1);
-        SkRect debugRect{(float)kTileSizePx * column, (float)kTileSizePx * row,
-                         (float)kTileSizePx * (column + 1),
-                         (float)kTileSizePx * (row + 1)};
+        SkRect debugRect{(float)tile_size * column, (float)tile_size * row,
+                         (float)tile_size * (column + 1),
+                         (float)tile_size * (row + 1)};
 
         SkFont font;
         font.setScaleX(0.5);
@@ -435,57 +541,66 @@ std::vector<TileRange> TileBuffer::PaintToCanvas(CancelFlagPtr cancel_flag,
   }
 
   // there are missing tiles, paint the snapshot (unless it isn't set)
-  if (snapshot.tiles.empty()) {
+  if (!snapshot.IsEmpty() &&
+      !PaintSnapshot(cancel_flag, canvas, snapshot, total_scale, flags)) {
     return missing_ranges;
   }
 
-  // this seems redundant, but it's to adjust for scale without an offset that
-  // causes jiggling
-  canvas->translate(0, y_pos_);
-  canvas->scale(total_scale / snapshot.scale);
-  canvas->translate(0, -y_pos_);
-  std::vector<cc::PaintImage>::const_iterator it = snapshot.tiles.cbegin();
-  for (unsigned int row = snapshot.row_start; row < snapshot.row_end; ++row) {
-    for (unsigned int column = snapshot.column_start;
-         column < snapshot.column_end; ++column) {
+  // then the tiles painted so far on top of it, so that a long repaint fills
+  // in as the tiles complete instead of all at once
+  if (scale_pending)
+    return missing_ranges;
+  for (unsigned int row = row_start; row < visible_row_end; ++row) {
+    for (unsigned int column = column_start; column < column_end; ++column) {
       if (CancelFlag::IsCancelled(cancel_flag)) {
         return missing_ranges;
       }
-      canvas->drawImage(*it++, kTileSizePx * column, kTileSizePx * row,
-                        SkSamplingOptions(SkFilterMode::kLinear), &flags);
-#ifdef TILEBUFFER_DEBUG_PAINT
-      cc::PaintFlags debugPaint;
-      debugPaint.setColor(SK_ColorBLUE);
-      debugPaint.setStrokeWidth(1);
-      SkRect debugRect{(float)kTileSizePx * column, (float)kTileSizePx * row,
-                       (float)kTileSizePx * (column + 1),
-                       (float)kTileSizePx * (row + 1)};
-      std::string coord;
-      coord += std::to_string(column);
-      coord += "x";
-      coord += std::to_string(row);
 
-      SkFont font;
-      font.setScaleX(0.5);
-      font.setSize(12 * scale_);
-      canvas->drawTextBlob(SkTextBlob::MakeFromString(coord.c_str(), font),
-                           debugRect.left(), debugRect.bottom(), debugPaint);
-
-      canvas->drawLine(debugRect.left(), debugRect.top(), debugRect.right(),
-                       debugRect.top(), debugPaint);
-      canvas->drawLine(debugRect.right(), debugRect.top(), debugRect.right(),
-                       debugRect.bottom(), debugPaint);
-      canvas->drawLine(debugRect.right(), debugRect.bottom(), debugRect.left(),
-                       debugRect.bottom(), debugPaint);
-      canvas->drawLine(debugRect.left(), debugRect.top(), debugRect.left(),
-                       debugRect.bottom(), debugPaint);
-#endif
+      size_t pool_index;
+      if (!TileToPoolIndex(CoordToIndex(column, row), &pool_index))
+        continue;
+      canvas->drawImage(pool_paint_images_[pool_index], tile_size * column,
+                        tile_size * row,
+                        SkSamplingOptions(SkFilterMode::kLinear), &flags);
     }
   }
 
   return missing_ranges;
 }
 
+bool TileBuffer::PaintSnapshot(CancelFlagPtr cancel_flag,
+                               cc::PaintCanvas* canvas,
+                               const Snapshot& snapshot,
+                               float total_scale,
+                               const cc::PaintFlags& flags) {
+  cc::PaintCanvasAutoRestore auto_restore(canvas, true);
+
+  // this seems redundant, but it's to adjust for scale without an offset that
+  // causes jiggling. y_pos_ is at the scale of the tiles, which differs from
+  // the snapshot's when it's reused across zoom steps.
+  canvas->translate(0, y_pos_);
+  canvas->scale(total_scale / snapshot.scale);
+  canvas->translate(0, -y_pos_ * snapshot.scale / scale_);
+  if (CancelFlag::IsCancelled(cancel_flag)) {
+    return false;
+  }
+  canvas->drawImageRect(
+      snapshot.image,
+      SkRect::MakeIWH(snapshot.image.width(), snapshot.image.height()),
+      gfx::RectToSkRect(snapshot.rect),
+      SkSamplingOptions(SkFilterMode::kLinear), &flags,
+      SkCanvas::kFast_SrcRectConstraint);
+#ifdef TILEBUFFER_DEBUG_PAINT
+  cc::PaintFlags debugPaint;
+  debugPaint.setColor(SK_ColorBLUE);
+  debugPaint.setStyle(cc::PaintFlags::kStroke_Style);
+  debugPaint.setStrokeWidth(1);
+  canvas->drawRect(gfx::RectToSkRect(snapshot.rect), debugPaint);
+#endif
+
+  return true;
+}
+
 bool TileRange::operator==(const TileRange& rhs) const {
   return index_start == rhs.index_start && index_end == rhs.index_end;
 }
@@ -530,43 +645,39 @@ bool TileBuffer::IsEmpty() {
   return rows_ == 0 || columns_ == 0;
 }
 
-Snapshot TileBuffer::MakeSnapshot(CancelFlagPtr cancel_flag,
-                                  const gfx::Rect& rect) {
-  std::vector<cc::PaintImage> tiles;
-
-  auto offset_rect = gfx::RectF(rect);
-  offset_rect.Offset(0, y_pos_);
-  gfx::Rect tile_rect = TileRect(offset_rect, doc_width_scaled_px_,
-                                 doc_height_scaled_px_, kTileSizePx);
-
-  DCHECK(tile_rect.x() >= 0);
-  DCHECK(tile_rect.y() >= 0);
-  DCHECK(tile_rect.width() >= 0);
-  DCHECK(tile_rect.height() >= 0);
+SnapshotTiles TileBuffer::CollectSnapshotTiles(const gfx::Rect& rect) {
+  SnapshotTiles result;
+  gfx::Rect view = rect;
+  view.Offset(0, y_pos_);
+  result.document_size = gfx::Size(std::ceil(doc_width_scaled_px_),
+                                   std::ceil(doc_height_scaled_px_));
+  result.rect = SnapshotRect(view, result.document_size);
+  result.scale = scale_;
+  result.scroll_y_position = y_pos_;
+  result.color_type = format_.color_type;
+
+  const int tile_size = format_.size_px;
+  gfx::Rect tile_rect =
+      TileRect(gfx::RectF(result.rect), doc_width_scaled_px_,
+               doc_height_scaled_px_, tile_size);
   DCHECK((unsigned int)tile_rect.right() <= columns_);
   DCHECK((unsigned int)tile_rect.bottom() <= rows_);
 
-  unsigned int row_start = (unsigned int)tile_rect.y();
-  unsigned int row_end = (unsigned int)tile_rect.bottom();
-  unsigned int column_start = (unsigned int)tile_rect.x();
-  unsigned int column_end = (unsigned int)tile_rect.right();
-
-  for (unsigned int row = row_start; row < row_end; ++row) {
-    for (unsigned int column = column_start; column < column_end; ++column) {
-      unsigned int tile_index = CoordToIndex(column, row);
+  // the margin has whatever the pool still holds around the view, the rest
+  // is left out
+  for (unsigned int row = tile_rect.y(); row < (unsigned int)tile_rect.bottom();
+       ++row) {
+    for (unsigned int column = tile_rect.x();
+         column < (unsigned int)tile_rect.right(); ++column) {
       size_t pool_index;
-
-      if (!TileToPoolIndex(tile_index, &pool_index)) {
-        LOG(ERROR) << "This shouldn't happen";
-        return Snapshot();
-      }
-
-      tiles.emplace_back(pool_paint_images_[pool_index]);
+      if (!TileToPoolIndex(CoordToIndex(column, row), &pool_index))
+        continue;
+      result.tiles.push_back({gfx::Point(tile_size * column, tile_size * row),
+                              pool_paint_images_[pool_index]});
     }
   }
 
-  return Snapshot(std::move(tiles), scale_, column_start, column_end, row_start,
-                  row_end, y_pos_);
+  return result;
 }
 
 }  // namespace electron::office
@@ -4,15 +4,21 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include "base/memory/ref_counted_delete_on_sequence.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "cc/paint/paint_canvas.h"
 #include "office/atomic_bitset.h"
 #include "office/cancellation_flag.h"
 #include "office/document_holder.h"
 #include "office/lok_callback.h"
+#include "office/memory_stats.h"
+#include "office/snapshot.h"
+#include "office/tile_format.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "ui/gfx/geometry/rect.h"
@@ -25,6 +31,7 @@ class Document;
 
 namespace cc {
 class PaintCanvas;
+class PaintFlags;
 class PaintImage;
 }  // namespace cc
 
@@ -47,39 +54,8 @@ std::vector<TileRange> SimplifyRanges(std::vector<TileRange> tile_ranges_);
 // is simplified
 size_t TileCount(std::vector<TileRange> tile_ranges_);
 
-struct Snapshot {
-  std::vector<cc::PaintImage> tiles;
-  float scale = 0.0;
-  unsigned int column_start = 0;
-  unsigned int column_end = 0;
-  unsigned int row_start = 0;
-  unsigned int row_end = 0;
-  unsigned int scroll_y_position = 0;
-
-  Snapshot(std::vector<cc::PaintImage> tiles_,
-           float scale_,
-           int column_start_,
-           int column_end_,
-           int row_start_,
-           int row_end_,
-           int scroll_y_position);
-
-	// copy
-  Snapshot(const Snapshot& other);
-  Snapshot& operator=(const Snapshot& other);
-	// move
-  Snapshot& operator=(Snapshot&& other) noexcept;
-  Snapshot(Snapshot&& other) noexcept;
-
-  Snapshot();
-  ~Snapshot();
-};
-
 class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
  public:
-  static constexpr int kTileSizePx = 256;
-  static constexpr int kTileSizeTwips = kTileSizePx * lok_callback::kTwipPerPx;
-
   // no copy
   TileBuffer(const TileBuffer& other) = delete;
   TileBuffer& operator=(const TileBuffer& other) = delete;
@@ -100,12 +76,15 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
                                        float total_scale,
                                        bool scale_pending,
                                        bool scrolling);
-  Snapshot MakeSnapshot(CancelFlagPtr cancel_flag, const gfx::Rect& rect);
+  // The painted tiles within a margin around `rect`, the visible area, to be
+  // flattened into a snapshot off the main thread
+  SnapshotTiles CollectSnapshotTiles(const gfx::Rect& rect);
   bool PaintTile(CancelFlagPtr cancel_flag,
                  DocumentHolderWithView document,
                  unsigned int tile_index,
                  std::size_t context_hash);
   void SetYPosition(float y);
+  // keeps the valid tiles if only the number of rows changed
   void Resize(long width_twips, long heigh_twips);
   void Resize(long width_twips, long heigh_twips, float scale);
   void ResetScale(float scale);
@@ -119,6 +98,28 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
   TileBuffer();
   bool IsEmpty();
 
+  // Changes the tile size and color type, invalidating every tile. Returns
+  // false if `format` is the current format.
+  bool SetFormat(const TileFormat& format);
+  const TileFormat& Format() const { return format_; }
+
+  // Releases the pool and the rasterized tiles, leaving every tile invalid.
+  // Snapshots are flattened copies, so they outlive the tiles. Paints still in
+  // flight on the thread pool drop their tile instead of storing it.
+  void TrimMemory();
+  // Invalidates every tile and forgets which tile each slot of the pool
+  // holds, for when the same tiles show something else, like another slide
+  void ResetPool();
+  // Allocates the pool again after TrimMemory
+  void EnsurePool();
+  bool IsTrimmed();
+
+  // Drops the painted tiles outside of `keep`, which become invalid, along
+  // with any of them being painted
+  void TrimTilesOutside(TileRange keep);
+  // Adds the pool, the painted tiles and `snapshot` to `stats`
+  void AddMemoryStats(const Snapshot& snapshot, MemoryStats* stats);
+
  private:
   friend class base::RefCountedDeleteOnSequence<TileBuffer>;
   friend class base::DeleteHelper<TileBuffer>;
@@ -142,7 +143,7 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
 
   unsigned long NextPoolIndex() {
     return current_pool_index_.fetch_add(1, std::memory_order_relaxed) %
-           kPoolSize;
+           pool_size_;
   }
 
   void InvalidatePoolTile(size_t pool_index) {
@@ -156,14 +157,29 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
     pool_index_to_tile_index_[pool_index] = kInvalidTileIndex;
   }
 
-  uint8_t* GetPoolBuffer(size_t pool_index) {
-    return &pool_buffer_[pool_index * kBufferStride];
+  static uint8_t* GetPoolBuffer(const std::shared_ptr<uint8_t[]>& pool,
+                                size_t pool_index,
+                                size_t stride) {
+    return &pool[pool_index * stride];
+  }
+
+  static std::shared_ptr<uint8_t[]> AllocatePool();
+
+  // the number of tiles of `format` the pool holds
+  static size_t PoolSize(const TileFormat& format) {
+    return kPoolAllocatedSize / format.Bytes() - 1;
   }
 
   // returns true if the tile resides in the pool, false otherwise
   bool TileToPoolIndex(unsigned int tile_index, size_t* pool_index) {
-    size_t result = *pool_index = tile_index % kPoolSize;
-    return result < kPoolSize &&
+    return TileToPoolIndex(tile_index, pool_size_, pool_index);
+  }
+
+  bool TileToPoolIndex(unsigned int tile_index,
+                       size_t pool_size,
+                       size_t* pool_index) {
+    size_t result = *pool_index = tile_index % pool_size;
+    return result < pool_size &&
            pool_index_to_tile_index_[result] == tile_index;
   }
 
@@ -174,6 +190,13 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
 
   RowLimit LimitRange(int y_pos, unsigned int view_height);
 
+  // returns false if cancelled
+  bool PaintSnapshot(CancelFlagPtr cancel_flag,
+                     cc::PaintCanvas* canvas,
+                     const Snapshot& snapshot,
+                     float total_scale,
+                     const cc::PaintFlags& flags);
+
   unsigned int columns_ = 0;
   unsigned int rows_ = 0;
   float scale_ = 1.0f;
@@ -195,17 +218,34 @@ class TileBuffer : public base::RefCountedDeleteOnSequence<TileBuffer> {
   // fine for now?
   static constexpr size_t kPoolAllocatedSize = 256 * 1024 * 1024;
   static constexpr size_t kPoolAligned = 4096;
-  static constexpr size_t kBytesPerPx = 4;  // both color types are 32-bit
   static constexpr unsigned int kInvalidTileIndex =
       std::numeric_limits<unsigned int>::max();
 
+  // swapped atomically, since TrimMemory can race with tiles being painted
   std::shared_ptr<uint8_t[]> pool_buffer_ = nullptr;
-  static constexpr size_t kBufferStride =
-      kTileSizePx * kTileSizePx * kBytesPerPx;
-  static constexpr size_t kPoolSize = kPoolAllocatedSize / kBufferStride - 1;
-
-  unsigned int pool_index_to_tile_index_[kPoolSize];
-  std::array<cc::PaintImage, kPoolSize> pool_paint_images_;
+  // the pool is the same size for every format, holding fewer larger tiles
+  // or more smaller ones, so changing the format doesn't reallocate
+  static constexpr size_t kMaxPoolSize =
+      kPoolAllocatedSize /
+          (TileFormat::kMinSizePx * TileFormat::kMinSizePx *
+           TileFormat::kBytesPerPx) -
+      1;
+
+  // only written on the renderer thread, under pool_lock_, so a paint on the
+  // thread pool reads them under the lock and the renderer thread without
+  TileFormat format_;
+  size_t pool_size_ = PoolSize(format_);
+
+  unsigned int pool_index_to_tile_index_[kMaxPoolSize];
+  std::array<cc::PaintImage, kMaxPoolSize> pool_paint_images_;
+
+  // held while a paint on the thread pool or a trim or format change on the
+  // renderer thread writes the two arrays above, while the format is changed
+  // or read by a paint, and while the painted tiles are counted
+  base::Lock pool_lock_;
+  // bumped by every trim, reset or format change, a paint started before it
+  // doesn't store its tile
+  uint64_t trim_generation_ GUARDED_BY(pool_lock_) = 0;
 
   std::atomic<unsigned long long> current_pool_index_ = 0;
 
@@ -0,0 +1,90 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/memory_stats.h"
+
+#include <utility>
+
+#include "base/no_destructor.h"
+#include "base/observer_list.h"
+
+namespace electron::office {
+
+namespace {
+base::ObserverList<MemoryConsumer>& Documents() {
+  static base::NoDestructor<base::ObserverList<MemoryConsumer>> documents;
+  return *documents;
+}
+}  // namespace
+
+MemoryStats& MemoryStats::operator+=(const MemoryStats& other) {
+  tile_pool_bytes += other.tile_pool_bytes;
+  tile_bytes += other.tile_bytes;
+  snapshot_bytes += other.snapshot_bytes;
+  slide_bytes += other.slide_bytes;
+  pending_buffer_bytes += other.pending_buffer_bytes;
+  return *this;
+}
+
+size_t MemoryStats::Total() const {
+  return tile_pool_bytes + tile_bytes + snapshot_bytes + slide_bytes +
+         pending_buffer_bytes;
+}
+
+size_t MemoryStats::LimitedBytes() const {
+  return tile_bytes + snapshot_bytes + slide_bytes;
+}
+
+PendingBuffer::PendingBuffer() = default;
+
+PendingBuffer::PendingBuffer(Counter counter, size_t bytes)
+    : counter_(std::move(counter)), bytes_(bytes) {
+  if (counter_)
+    *counter_ += bytes_;
+}
+
+PendingBuffer::~PendingBuffer() {
+  Release();
+}
+
+PendingBuffer::PendingBuffer(PendingBuffer&& other)
+    : counter_(std::move(other.counter_)), bytes_(other.bytes_) {}
+
+PendingBuffer& PendingBuffer::operator=(PendingBuffer&& other) {
+  if (this != &other) {
+    Release();
+    counter_ = std::move(other.counter_);
+    bytes_ = other.bytes_;
+  }
+  return *this;
+}
+
+void PendingBuffer::Release() {
+  if (counter_)
+    *counter_ -= bytes_;
+  counter_.reset();
+}
+
+void AddDocumentMemoryConsumer(MemoryConsumer* document) {
+  if (!Documents().HasObserver(document))
+    Documents().AddObserver(document);
+}
+
+void RemoveDocumentMemoryConsumer(MemoryConsumer* document) {
+  Documents().RemoveObserver(document);
+}
+
+MemoryStats DocumentMemoryStats() {
+  MemoryStats stats;
+  for (MemoryConsumer& document : Documents())
+    document.AddMemoryStats(&stats);
+  return stats;
+}
+
+void TrimDocumentMemory() {
+  for (MemoryConsumer& document : Documents())
+    document.TrimMemory();
+}
+
+}  // namespace electron::office
@@ -0,0 +1,77 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "base/observer_list_types.h"
+
+namespace electron::office {
+
+// Memory held on behalf of a document, in bytes.
+//
+// LOK's own model isn't included, it has no per-document accounting.
+struct MemoryStats {
+  // the tile pools, allocated whether or not tiles are painted
+  size_t tile_pool_bytes = 0;
+  // the painted tiles, which are copied out of the pool
+  size_t tile_bytes = 0;
+  // the flattened snapshots shown while zooming and scrolling
+  size_t snapshot_bytes = 0;
+  // whole-slide surfaces of presentations
+  size_t slide_bytes = 0;
+  // saves and clipboard contents on their way between LOK and JS, see
+  // PendingBuffer
+  size_t pending_buffer_bytes = 0;
+
+  MemoryStats& operator+=(const MemoryStats& other);
+  size_t Total() const;
+  // what a document's memory limit applies to, everything but the pools,
+  // which a shown document keeps however few tiles it paints, and the
+  // pending buffers, which trimming can't release
+  size_t LimitedBytes() const;
+};
+
+// Counts the bytes of a buffer that is passed between sequences, like a save
+// that LOK made off of the renderer thread, for as long as it lives
+class PendingBuffer {
+ public:
+  using Counter = std::shared_ptr<std::atomic<size_t>>;
+
+  PendingBuffer();
+  PendingBuffer(Counter counter, size_t bytes);
+  ~PendingBuffer();
+
+  PendingBuffer(PendingBuffer&& other);
+  PendingBuffer& operator=(PendingBuffer&& other);
+
+ private:
+  void Release();
+
+  Counter counter_;
+  size_t bytes_ = 0;
+};
+
+// Something rendering a document, which the document accounts for and asks
+// to release memory when it goes over its limit
+class MemoryConsumer : public base::CheckedObserver {
+ public:
+  virtual void AddMemoryStats(MemoryStats* stats) = 0;
+  // releases what isn't needed to paint what's visible
+  virtual void TrimMemory() = 0;
+};
+
+// Every document of the renderer is registered for the process-wide stats,
+// only used on the renderer thread
+void AddDocumentMemoryConsumer(MemoryConsumer* document);
+void RemoveDocumentMemoryConsumer(MemoryConsumer* document);
+// The sum over every registered document
+MemoryStats DocumentMemoryStats();
+// Trims every registered document
+void TrimDocumentMemory();
+
+}  // namespace electron::office
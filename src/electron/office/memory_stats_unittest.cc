@@ -0,0 +1,73 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/memory_stats.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+namespace {
+class FakeDocument : public MemoryConsumer {
+ public:
+  explicit FakeDocument(size_t tile_bytes) : tile_bytes_(tile_bytes) {}
+
+  void AddMemoryStats(MemoryStats* stats) override {
+    stats->tile_bytes += tile_bytes_;
+  }
+  void TrimMemory() override { tile_bytes_ = 0; }
+
+ private:
+  size_t tile_bytes_;
+};
+}  // namespace
+
+TEST(MemoryStatsTest, Sums) {
+  MemoryStats stats;
+  stats.tile_pool_bytes = 1;
+  stats.snapshot_bytes = 2;
+  MemoryStats other;
+  other.tile_bytes = 4;
+  other.slide_bytes = 8;
+  other.pending_buffer_bytes = 16;
+  stats += other;
+  EXPECT_EQ(stats.Total(), size_t(31));
+  // neither the pool of a shown document nor a pending buffer is released by
+  // trimming
+  EXPECT_EQ(stats.LimitedBytes(), size_t(14));
+}
+
+TEST(MemoryStatsTest, CountsPendingBuffers) {
+  auto counter = std::make_shared<std::atomic<size_t>>(0);
+  {
+    PendingBuffer save(counter, 16);
+    PendingBuffer clipboard(counter, 32);
+    EXPECT_EQ(counter->load(), size_t(48));
+
+    // counted once however often it's moved
+    PendingBuffer moved = std::move(save);
+    EXPECT_EQ(counter->load(), size_t(48));
+    clipboard = std::move(moved);
+    EXPECT_EQ(counter->load(), size_t(16));
+  }
+  EXPECT_EQ(counter->load(), size_t(0));
+}
+
+TEST(MemoryStatsTest, SumsAndTrimsDocuments) {
+  FakeDocument a(16);
+  FakeDocument b(32);
+  AddDocumentMemoryConsumer(&a);
+  AddDocumentMemoryConsumer(&b);
+  // registered once
+  AddDocumentMemoryConsumer(&b);
+  EXPECT_EQ(DocumentMemoryStats().tile_bytes, size_t(48));
+
+  RemoveDocumentMemoryConsumer(&a);
+  EXPECT_EQ(DocumentMemoryStats().tile_bytes, size_t(32));
+
+  TrimDocumentMemory();
+  EXPECT_EQ(DocumentMemoryStats().Total(), size_t(0));
+  RemoveDocumentMemoryConsumer(&b);
+}
+
+}  // namespace electron::office
@@ -6,29 +6,39 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "LibreOfficeKit/LibreOfficeKit.hxx"
 #include "base/atomic_ref_count.h"
 #include "base/bind.h"
 #include "base/callback_forward.h"
+#include "base/files/file_path.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/no_destructor.h"
 #include "base/notreached.h"
+#include "base/process/process_metrics.h"
 #include "base/task/bind_post_task.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "base/token.h"
 #include "gin/converter.h"
+#include "gin/dictionary.h"
 #include "gin/handle.h"
 #include "gin/object_template_builder.h"
 #include "gin/per_isolate_data.h"
+#include "office/autosave_journal.h"
+#include "office/blocking_watchdog.h"
 #include "office/document_client.h"
 #include "office/document_holder.h"
+#include "office/memory_stats.h"
 #include "office/office_instance.h"
 #include "office/promise.h"
+#include "office/snapshot_store.h"
+#include "office/uno_bulk.h"
 #include "unov8.hxx"
+#include "v8/include/v8-array-buffer.h"
 #include "v8/include/v8-function.h"
 #include "v8/include/v8-isolate.h"
 #include "v8/include/v8-json.h"
@@ -48,10 +58,19 @@ gin::WrapperInfo OfficeClient::kWrapperInfo = {gin::kEmbedderNativeGin};
 
 void OfficeClient::OnLoaded(lok::Office* client) {
   office_ = client;
-  ::UnoV8Instance::Set(client->getUnoV8());
   loaded_.Signal();
 }
 
+void OfficeClient::EnsureUnoBridge() {
+  if (uno_bridge_set_ || !office_)
+    return;
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  ::UnoV8Instance::Set(office_->getUnoV8());
+  uno_bridge_time_ = base::TimeTicks::Now() - start;
+  uno_bridge_set_ = true;
+}
+
 v8::Local<v8::Value> OfficeClient::GetHandle(v8::Isolate* isolate) {
   return self_.Get(isolate);
 }
@@ -149,6 +168,15 @@ gin::ObjectTemplateBuilder OfficeClient::GetObjectTemplateBuilder(
       // .SetMethod("setDocumentPassword", &OfficeClient::SetDocumentPasswordAsync)
       .SetMethod("loadDocument", &OfficeClient::LoadDocumentAsync)
 			.SetMethod("getLastError", &OfficeClient::GetLastError)
+      .SetMethod("getStartupTimings", &OfficeClient::GetStartupTimings)
+      .SetMethod("getBlockingStats", &OfficeClient::GetBlockingStats)
+      .SetMethod("resetBlockingStats", &OfficeClient::ResetBlockingStats)
+      .SetMethod("getEventQueueStats", &OfficeClient::GetEventQueueStats)
+      .SetMethod("resetEventQueueStats", &OfficeClient::ResetEventQueueStats)
+      .SetMethod("readAutosave", &OfficeClient::ReadAutosave)
+      .SetMethod("getPropertyValues", &OfficeClient::GetPropertyValues)
+      .SetMethod("getMemoryStats", &OfficeClient::GetMemoryStats)
+      .SetMethod("trimMemory", &OfficeClient::TrimMemory)
       .SetMethod("loadDocumentFromArrayBuffer",
                  &OfficeClient::LoadDocumentFromArrayBuffer)
       .SetMethod("__handleBeforeUnload", &OfficeClient::HandleBeforeUnload);
@@ -175,6 +203,59 @@ std::string OfficeClient::GetLastError() {
   return result;
 }
 
+v8::Local<v8::Value> OfficeClient::GetStartupTimings(v8::Isolate* isolate) {
+  StartupTimings timings = OfficeInstance::Get()->GetStartupTimings();
+  if (!timings.complete)
+    return v8::Null(isolate);
+
+  gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+  dict.Set("queued", timings.queued.InMillisecondsF());
+  dict.Set("lokInit", timings.lok_init.InMillisecondsF());
+  dict.Set("optionalFeatures", timings.optional_features.InMillisecondsF());
+  dict.Set("total", timings.total.InMillisecondsF());
+  dict.Set("persistentProfile", timings.persistent_profile);
+  dict.Set("preinitialized", timings.preinitialized);
+  if (uno_bridge_set_)
+    dict.Set("unoBridge", uno_bridge_time_.InMillisecondsF());
+  return gin::ConvertToV8(isolate, dict);
+}
+
+v8::Local<v8::Value> OfficeClient::GetBlockingStats(v8::Isolate* isolate) {
+  gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+  for (const auto& [name, stats] : BlockingWatchdog::Get()->GetStats()) {
+    gin::Dictionary entry = gin::Dictionary::CreateEmpty(isolate);
+    entry.Set("count", stats.count);
+    entry.Set("stalls", stats.stalls);
+    entry.Set("total", stats.total.InMillisecondsF());
+    entry.Set("max", stats.max.InMillisecondsF());
+    dict.Set(name, entry);
+  }
+  return gin::ConvertToV8(isolate, dict);
+}
+
+void OfficeClient::ResetBlockingStats() {
+  BlockingWatchdog::Get()->Reset();
+}
+
+v8::Local<v8::Value> OfficeClient::GetEventQueueStats(v8::Isolate* isolate) {
+  DocumentEventQueue::Stats stats =
+      OfficeInstance::Get()->GetEventQueueStats();
+  gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+  dict.Set("events", static_cast<double>(stats.events));
+  dict.Set("drains", static_cast<double>(stats.drains));
+  dict.Set("maxDepth", static_cast<double>(stats.max_depth));
+  dict.Set("meanLatency",
+           stats.events
+               ? stats.total_latency.InMillisecondsF() / stats.events
+               : 0.0);
+  dict.Set("maxLatency", stats.max_latency.InMillisecondsF());
+  return gin::ConvertToV8(isolate, dict);
+}
+
+void OfficeClient::ResetEventQueueStats() {
+  OfficeInstance::Get()->ResetEventQueueStats();
+}
+
 namespace {
 void ResolveLoadWithDocumentClient(const base::WeakPtr<OfficeClient>& client,
                                    Promise<DocumentClient> promise,
@@ -294,6 +375,87 @@ v8::Local<v8::Promise> OfficeClient::LoadDocumentFromArrayBuffer(
   return promise_handle;
 }
 
+v8::Local<v8::Promise> OfficeClient::ReadAutosave(v8::Isolate* isolate,
+                                                 const std::string& path) {
+  Promise<v8::Value> promise(isolate);
+  auto handle = promise.GetHandle();
+
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::TaskPriority::USER_VISIBLE, base::MayBlock()},
+      base::BindOnce(
+          [](const std::string& path) {
+            auto snapshot = std::make_unique<std::string>();
+            if (!AutosaveJournal::Read(base::FilePath::FromUTF8Unsafe(path),
+                                       snapshot.get()))
+              snapshot.reset();
+            return snapshot;
+          },
+          path),
+      base::BindOnce(
+          [](Promise<v8::Value> promise,
+             std::unique_ptr<std::string> snapshot) {
+            if (!snapshot) {
+              promise.Resolve();
+              return;
+            }
+            v8::Isolate* isolate = promise.isolate();
+            v8::HandleScope handle_scope(isolate);
+            v8::MicrotasksScope microtasks_scope(
+                isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+            v8::Context::Scope context_scope(promise.GetContext());
+
+            // the snapshot can be the size of the document, so it's handed to
+            // the ArrayBuffer instead of copied
+            std::string* data = snapshot.release();
+            auto backing_store = v8::ArrayBuffer::NewBackingStore(
+                data->data(), data->size(),
+                [](void*, size_t, void* data) {
+                  delete static_cast<std::string*>(data);
+                },
+                data);
+
+            gin::Dictionary result = gin::Dictionary::CreateEmpty(isolate);
+            result.Set("snapshot",
+                       v8::ArrayBuffer::New(isolate, std::move(backing_store)));
+            promise.Resolve(gin::ConvertToV8(isolate, result));
+          },
+          std::move(promise)));
+
+  return handle;
+}
+
+v8::Local<v8::Value> OfficeClient::GetPropertyValues(
+    v8::Isolate* isolate,
+    v8::Local<v8::Array> objects,
+    v8::Local<v8::Array> names) {
+  BlockingWatchdog::Scope watchdog("getPropertyValues");
+  v8::Local<v8::Object> result;
+  if (!uno_bulk::GetPropertyValues(isolate->GetCurrentContext(), objects,
+                                   names)
+           .ToLocal(&result)) {
+    return v8::Undefined(isolate);
+  }
+  return result;
+}
+
+v8::Local<v8::Value> OfficeClient::GetMemoryStats(v8::Isolate* isolate) {
+  MemoryStats stats = DocumentMemoryStats();
+  stats.snapshot_bytes += SnapshotStore::Get()->BytesUsed();
+
+  v8::Local<v8::Object> result =
+      gin::ConvertToV8(isolate, stats).As<v8::Object>();
+  // LOK allocates from the same heap, but doesn't account for it per document
+  gin::Dictionary dict(isolate, result);
+  dict.Set("heap", static_cast<double>(
+                       base::ProcessMetrics::CreateCurrentProcessMetrics()
+                           ->GetMallocUsage()));
+  return result;
+}
+
+void OfficeClient::TrimMemory() {
+  TrimDocumentMemory();
+}
+
 /*
 v8::Local<v8::Promise> OfficeClient::SetDocumentPasswordAsync(
     v8::Isolate* isolate,
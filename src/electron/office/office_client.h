@@ -4,13 +4,17 @@
 
 #pragma once
 
+#include <string>
+
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/one_shot_event.h"
 #include "base/task/sequenced_task_runner.h"
+#include "base/time/time.h"
 #include "gin/handle.h"
 #include "gin/wrappable.h"
 #include "office_load_observer.h"
+#include "v8/include/v8-container.h"
 #include "v8/include/v8-isolate.h"
 #include "v8/include/v8-local-handle.h"
 
@@ -55,9 +59,18 @@ class OfficeClient : public gin::Wrappable<OfficeClient>,
   void Unset();
   void HandleBeforeUnload();
 
+  // the UNO/V8 bridge is only needed by DocumentClient::As, so it is created
+  // on first use instead of at startup
+  void EnsureUnoBridge();
+
  protected:
   // Exposed to v8 {
   std::string GetLastError();
+  v8::Local<v8::Value> GetStartupTimings(v8::Isolate* isolate);
+  v8::Local<v8::Value> GetBlockingStats(v8::Isolate* isolate);
+  void ResetBlockingStats();
+  v8::Local<v8::Value> GetEventQueueStats(v8::Isolate* isolate);
+  void ResetEventQueueStats();
 	// TODO: [MACRO-1899] fix setDocumentPassword in LOK, then re-enable
 	/*
   v8::Local<v8::Promise> SetDocumentPasswordAsync(v8::Isolate* isolate,
@@ -69,10 +82,21 @@ class OfficeClient : public gin::Wrappable<OfficeClient>,
   v8::Local<v8::Promise> LoadDocumentFromArrayBuffer(
       v8::Isolate* isolate,
       v8::Local<v8::ArrayBuffer> array_buffer);
+  v8::Local<v8::Promise> ReadAutosave(v8::Isolate* isolate,
+                                      const std::string& path);
+  v8::Local<v8::Value> GetPropertyValues(v8::Isolate* isolate,
+                                         v8::Local<v8::Array> objects,
+                                         v8::Local<v8::Array> names);
+  // the documents of the renderer, the stored snapshots and the heap, which
+  // includes LOK
+  v8::Local<v8::Value> GetMemoryStats(v8::Isolate* isolate);
+  void TrimMemory();
   // }
 
  private:
   lok::Office* office_ = nullptr;
+  bool uno_bridge_set_ = false;
+  base::TimeDelta uno_bridge_time_;
 
   v8::Global<v8::Context> context_;
   v8::Global<v8::Value> self_;
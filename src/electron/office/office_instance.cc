@@ -4,16 +4,23 @@
 
 #include "office_instance.h"
 
+#include <algorithm>
 #include <memory>
 #include "LibreOfficeKit/LibreOfficeKit.hxx"
+#include "LibreOfficeKit/LibreOfficeKitInit.h"
 #include "base/bind.h"
+#include "base/containers/contains.h"
+#include "base/environment.h"
 #include "base/files/file_path.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/no_destructor.h"
 #include "base/notreached.h"
 #include "base/path_service.h"
+#include "base/strings/string_util.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "build/build_config.h"
 
 #include "base/logging.h"
 #include "office/document_holder.h"
@@ -32,14 +39,65 @@ OfficeInstance& get_instance() {
   static base::NoDestructor<OfficeInstance> instance;
   return *instance;
 }
+
+// set in the zygote, inherited by the renderers forked from it
+bool g_preinitialized = false;
+
+base::FilePath LibreOfficePath() {
+  base::FilePath module_path;
+  if (!base::PathService::Get(base::DIR_MODULE, &module_path)) {
+    NOTREACHED();
+  }
+
+  return module_path.Append(FILE_PATH_LITERAL("libreofficekit"))
+      .Append(FILE_PATH_LITERAL("program"));
+}
+
+// LOK expects the user profile as a file URL
+std::string UserProfileURL() {
+  std::string profile_dir;
+  if (!base::Environment::Create()->GetVar(
+          OfficeInstance::kUserProfileEnvVar, &profile_dir) ||
+      profile_dir.empty())
+    return std::string();
+
+#if BUILDFLAG(IS_WIN)
+  std::string url;
+  base::ReplaceChars(profile_dir, "\\", "/", &url);
+  return "file:///" + url;
+#else
+  return "file://" + profile_dir;
+#endif
+}
 }  // namespace
 
+// static
+void OfficeInstance::PreInitForFork() {
+#if BUILDFLAG(IS_LINUX)
+  std::string prefork;
+  if (!base::Environment::Create()->GetVar(kPreforkEnvVar, &prefork) ||
+      prefork.empty() || prefork == "0")
+    return;
+
+  const std::string user_profile_url = UserProfileURL();
+  // lok_preinit only loads and preloads, it doesn't start any threads
+  if (lok_preinit(LibreOfficePath().AsUTF8Unsafe().c_str(),
+                  user_profile_url.empty() ? nullptr
+                                           : user_profile_url.c_str()) != 0) {
+    LOG(ERROR) << "Unable to preinit LibreOfficeKit before fork";
+    return;
+  }
+  g_preinitialized = true;
+#endif
+}
+
 void OfficeInstance::Create() {
   static std::atomic<bool> once = false;
   if (once)
     return;
   once = true;
 
+  get_instance().create_time_ = base::TimeTicks::Now();
   base::ThreadPool::PostTask(
       FROM_HERE, {base::TaskPriority::USER_BLOCKING},
       base::BindOnce(&OfficeInstance::Initialize,
@@ -59,25 +117,78 @@ OfficeInstance::OfficeInstance()
 OfficeInstance::~OfficeInstance() = default;
 
 void OfficeInstance::Initialize() {
-  base::FilePath module_path;
-  if (!base::PathService::Get(base::DIR_MODULE, &module_path)) {
-    NOTREACHED();
-  }
+  const base::TimeTicks start = base::TimeTicks::Now();
+  base::FilePath libreoffice_path = LibreOfficePath();
 
-  base::FilePath libreoffice_path =
-      module_path.Append(FILE_PATH_LITERAL("libreofficekit"))
-          .Append(FILE_PATH_LITERAL("program"));
+  const std::string user_profile_url = UserProfileURL();
 
   if (!unset_)
-    instance_.reset(lok::lok_cpp_init(libreoffice_path.AsUTF8Unsafe().c_str()));
+    instance_.reset(lok::lok_cpp_init(
+        libreoffice_path.AsUTF8Unsafe().c_str(),
+        user_profile_url.empty() ? nullptr : user_profile_url.c_str()));
+  const base::TimeTicks lok_init_end = base::TimeTicks::Now();
   if (!unset_)
     instance_->setOptionalFeatures(
         LibreOfficeKitOptionalFeatures::LOK_FEATURE_NO_TILED_ANNOTATIONS);
+  const base::TimeTicks end = base::TimeTicks::Now();
+
+  {
+    base::AutoLock lock(timings_lock_);
+    timings_.queued = start - create_time_;
+    timings_.lok_init = lok_init_end - start;
+    timings_.optional_features = end - lok_init_end;
+    timings_.total = end - create_time_;
+    timings_.persistent_profile = !user_profile_url.empty();
+    timings_.preinitialized = g_preinitialized;
+    timings_.complete = !unset_;
+  }
+
   if (!unset_)
     loaded_observers_->Notify(FROM_HERE, &OfficeLoadObserver::OnLoaded,
                               instance_.get());
 }
 
+StartupTimings OfficeInstance::GetStartupTimings() {
+  base::AutoLock lock(timings_lock_);
+  return timings_;
+}
+
+void OfficeInstance::LockView() {
+  const base::PlatformThreadId thread = base::PlatformThread::CurrentId();
+  // only this thread can have stored its own id
+  if (view_owner_.load(std::memory_order_relaxed) != thread) {
+    view_lock_.Acquire();
+    view_owner_.store(thread, std::memory_order_relaxed);
+  }
+  ++view_lock_depth_;
+}
+
+void OfficeInstance::UnlockView() {
+  DCHECK_EQ(view_owner_.load(std::memory_order_relaxed),
+            base::PlatformThread::CurrentId());
+  DCHECK_GT(view_lock_depth_, 0);
+  if (--view_lock_depth_ > 0)
+    return;
+  view_owner_.store(base::kInvalidThreadId, std::memory_order_relaxed);
+  view_lock_.Release();
+}
+
+bool OfficeInstance::SetViewLocked(lok::Document* document, int view_id) {
+  view_lock_.AssertAcquired();
+  if (current_view_document_ == document && current_view_ == view_id)
+    return false;
+  document->setView(view_id);
+  current_view_document_ = document;
+  current_view_ = view_id;
+  return true;
+}
+
+void OfficeInstance::ForgetViewLocked() {
+  view_lock_.AssertAcquired();
+  current_view_document_ = nullptr;
+  current_view_ = -1;
+}
+
 bool OfficeInstance::IsValid() {
   return static_cast<bool>(Get()->instance_);
 }
@@ -104,72 +215,152 @@ void OfficeInstance::HandleDocumentCallback(int type,
                                             void* documentContext) {
   DocumentCallbackContext* context =
       static_cast<DocumentCallbackContext*>(documentContext);
-  const OfficeInstance* office_instance =
-      static_cast<const OfficeInstance*>(context->office_instance);
+  OfficeInstance* office_instance = static_cast<OfficeInstance*>(
+      const_cast<void*>(context->office_instance));
 
   if (!office_instance->instance_) {
     LOG(ERROR) << "Uninitialized for doc callback";
     return;
   }
 
-  auto& observers = office_instance->document_event_observers_;
-  auto it =
-      observers.find(DocumentEventId(context->id, type, context->view_id));
-  if (it == observers.end()) {
+  DocumentEventId id(context->id, type, context->view_id);
+  base::AutoLock lock(office_instance->event_lock_);
+  auto it = office_instance->event_routes_.find(id);
+  if (it == office_instance->event_routes_.end()) {
     // document received an event, but wasn't observed
     return;
   }
 #ifdef DEBUG_EVENTS
   LOG(ERROR) << lokCallbackTypeToString(type) << " " << payload;
 #endif
-  it->second->Notify(FROM_HERE, &DocumentEventObserver::DocumentCallback, type,
-                     std::string(payload));
+  for (auto& queue : it->second) {
+    queue->Push(id, type, payload ? std::string(payload) : std::string());
+  }
+}
+
+scoped_refptr<DocumentEventQueue> OfficeInstance::CurrentEventQueue() {
+  base::AutoLock lock(event_lock_);
+  for (auto& queue : event_queues_) {
+    if (queue->RunsTasksInCurrentSequence())
+      return queue;
+  }
+  return event_queues_.emplace_back(base::MakeRefCounted<DocumentEventQueue>(
+      base::SequencedTaskRunnerHandle::Get()));
+}
+
+void OfficeInstance::RemoveEventRoute(
+    const DocumentEventId& id,
+    const scoped_refptr<DocumentEventQueue>& queue) {
+  base::AutoLock lock(event_lock_);
+  auto it = event_routes_.find(id);
+  if (it == event_routes_.end())
+    return;
+
+  auto& queues = it->second;
+  queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+  if (!queues.empty())
+    return;
+
+  event_routes_.erase(it);
+  auto range = document_id_to_document_event_ids_.equal_range(id.document_id);
+  for (auto id_it = range.first; id_it != range.second; ++id_it) {
+    if (id_it->second == id) {
+      document_id_to_document_event_ids_.erase(id_it);
+      break;
+    }
+  }
+  RemoveUnroutedEventQueuesLocked();
+}
+
+void OfficeInstance::RemoveUnroutedEventQueuesLocked() {
+  std::vector<scoped_refptr<DocumentEventQueue>> routed;
+  for (auto& queue : event_queues_) {
+    for (const auto& [id, queues] : event_routes_) {
+      if (base::Contains(queues, queue)) {
+        routed.push_back(std::move(queue));
+        break;
+      }
+    }
+  }
+  event_queues_ = std::move(routed);
 }
 
 void OfficeInstance::AddDocumentObserver(DocumentEventId id,
                                          DocumentEventObserver* observer) {
   DCHECK(IsValid());
-  auto it =
-      document_event_observers_
-          .try_emplace(id, base::MakeRefCounted<DocumentEventObserverList>())
-          .first;
-  it->second->AddObserver(observer);
-  auto& document_event_ids = Get()->document_id_to_document_event_ids_;
-  document_event_ids.emplace(id.document_id, id);
+  scoped_refptr<DocumentEventQueue> queue = CurrentEventQueue();
+  queue->AddObserver(id, observer);
+
+  base::AutoLock lock(event_lock_);
+  // the queue may have been dropped while it had no routes
+  if (!base::Contains(event_queues_, queue))
+    event_queues_.push_back(queue);
+  auto& queues = event_routes_[id];
+  if (base::Contains(queues, queue))
+    return;
+  if (queues.empty())
+    document_id_to_document_event_ids_.emplace(id.document_id, id);
+  queues.push_back(std::move(queue));
 }
 
 void OfficeInstance::RemoveDocumentObserver(DocumentEventId id,
                                             DocumentEventObserver* observer) {
   DCHECK(IsValid());
-  auto it = document_event_observers_.find(id);
-  if (it == document_event_observers_.end()) {
-    return;
-  }
-  it->second->RemoveObserver(observer);
+  scoped_refptr<DocumentEventQueue> queue = CurrentEventQueue();
+  if (queue->RemoveObserver(id, observer))
+    RemoveEventRoute(id, queue);
 }
 
 void OfficeInstance::RemoveDocumentObservers(size_t document_id) {
   DCHECK(IsValid());
-  auto& event_ids = document_id_to_document_event_ids_;
-  auto range = event_ids.equal_range(document_id);
-  for (auto it = range.first; it != range.second; ++it) {
-    document_event_observers_.erase(it->second);
+  std::vector<scoped_refptr<DocumentEventQueue>> queues;
+  {
+    base::AutoLock lock(event_lock_);
+    auto& event_ids = document_id_to_document_event_ids_;
+    auto range = event_ids.equal_range(document_id);
+    for (auto it = range.first; it != range.second; ++it) {
+      event_routes_.erase(it->second);
+    }
+    event_ids.erase(document_id);
+    queues = event_queues_;
+    RemoveUnroutedEventQueuesLocked();
+  }
+
+  // nothing is routed to the queues anymore, but their observers still need
+  // to be dropped on their own sequence
+  for (auto& queue : queues) {
+    if (queue->RunsTasksInCurrentSequence()) {
+      queue->RemoveObservers(document_id, nullptr);
+    } else {
+      queue->task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(
+                         [](scoped_refptr<DocumentEventQueue> queue,
+                            size_t document_id) {
+                           queue->RemoveObservers(document_id, nullptr);
+                         },
+                         queue, document_id));
+    }
   }
-  event_ids.erase(document_id);
 }
 
 void OfficeInstance::RemoveDocumentObservers(size_t document_id,
                                              DocumentEventObserver* observer) {
   DCHECK(IsValid());
-  auto range = document_id_to_document_event_ids_.equal_range(document_id);
-  for (auto it = range.first; it != range.second; ++it) {
-    auto obs_it = document_event_observers_.find(it->second);
-    if (obs_it != document_event_observers_.end()) {
-      obs_it->second->RemoveObserver(observer);
-    }
+  scoped_refptr<DocumentEventQueue> queue = CurrentEventQueue();
+  for (const DocumentEventId& id :
+       queue->RemoveObservers(document_id, observer)) {
+    RemoveEventRoute(id, queue);
   }
 }
 
+DocumentEventQueue::Stats OfficeInstance::GetEventQueueStats() {
+  return CurrentEventQueue()->GetStats();
+}
+
+void OfficeInstance::ResetEventQueueStats() {
+  CurrentEventQueue()->ResetStats();
+}
+
 void OfficeInstance::AddDestroyedObserver(DestroyedObserver* observer) {
   destroyed_observers_->AddObserver(observer);
 }
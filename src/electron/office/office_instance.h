@@ -6,10 +6,16 @@
 
 #include <unordered_map>
 #include <atomic>
-#include "base/hash/hash.h"
+#include <vector>
 #include "base/observer_list_threadsafe.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
 #include "document_event_observer.h"
 #include "office/destroyed_observer.h"
+#include "office/document_event_id.h"
+#include "office/document_event_queue.h"
 #include "office_load_observer.h"
 
 namespace lok {
@@ -18,33 +24,22 @@ class Document;
 }  // namespace lok
 
 namespace electron::office {
-struct DocumentEventId {
-  const size_t document_id;
-  const int event_id;
-  const int view_id;
-
-  DocumentEventId(size_t doc_id, int evt_id, int view_id_)
-      : document_id(doc_id), event_id(evt_id), view_id(view_id_) {}
-
-  bool operator==(const DocumentEventId& other) const {
-    return (document_id == other.document_id && event_id == other.event_id &&
-            view_id == other.view_id);
-  }
-};
-}  // namespace electron::office
 
-namespace std {
-using electron::office::DocumentEventId;
-template <>
-struct ::std::hash<DocumentEventId> {
-  std::size_t operator()(const DocumentEventId& id) const {
-    return base::HashInts64(id.document_id,
-                            base::HashInts32(id.view_id, id.event_id));
-  }
+// Breakdown of the time spent bringing up LOK in this process
+struct StartupTimings {
+  // waiting for the thread pool to run the initialization task
+  base::TimeDelta queued;
+  // lok_cpp_init, which includes the configuration registry and user profile
+  base::TimeDelta lok_init;
+  base::TimeDelta optional_features;
+  // from OfficeInstance::Create() until observers are notified
+  base::TimeDelta total;
+  // initialized with a persisted user profile, see kUserProfileEnvVar
+  bool persistent_profile = false;
+  // LOK was preloaded before this process was forked, see PreInitForFork
+  bool preinitialized = false;
+  bool complete = false;
 };
-}  // namespace std
-
-namespace electron::office {
 
 // This is separated from OfficeClient for two reasons:
 // 1. LOK is started before the V8 context arrives
@@ -54,6 +49,20 @@ class OfficeInstance {
   OfficeInstance();
   ~OfficeInstance();
 
+  // When set, the directory is used as the LOK user profile. The first start
+  // populates it from presets/ and the registry, later starts reuse it.
+  static constexpr char kUserProfileEnvVar[] = "LIBREOFFICEKIT_USER_PROFILE";
+
+  // When set on Linux, LOK is preloaded in the zygote before it forks any
+  // renderers, see PreInitForFork.
+  static constexpr char kPreforkEnvVar[] = "LIBREOFFICEKIT_PREFORK";
+
+  // Loads LOK in a process that will later fork the renderers. The children
+  // share the loaded libraries and configuration copy-on-write, so Create()
+  // in a forked renderer only has to finish the per-process setup. Must be
+  // called while the process is still single-threaded.
+  static void PreInitForFork();
+
   static void Create();
   static OfficeInstance* Get();
   static bool IsValid();
@@ -71,11 +80,28 @@ class OfficeInstance {
   void RemoveDocumentObservers(size_t document_id,
                                DocumentEventObserver* observer);
   void RemoveDocumentObservers(size_t document_id);
+  // depth and latency of the event queue for the current sequence
+  DocumentEventQueue::Stats GetEventQueueStats();
+  void ResetEventQueueStats();
 
   void AddDestroyedObserver(DestroyedObserver* observer);
   void RemoveDestroyedObserver(DestroyedObserver* observer);
 	void HandleClientDestroyed();
 
+  StartupTimings GetStartupTimings();
+
+  // LOK has a single current view for the process, shared by the views of
+  // every document. A thread holds it from setView until its calls on the
+  // view return, and can lock it again while holding it. The lock is taken
+  // and released in separate calls, which the analysis can't follow.
+  void LockView() NO_THREAD_SAFETY_ANALYSIS;
+  void UnlockView() NO_THREAD_SAFETY_ANALYSIS;
+  // Switches LOK to `view_id` of `document` unless it's already current,
+  // returning whether it switched. Requires the view to be locked.
+  bool SetViewLocked(lok::Document* document, int view_id);
+  // LOK switched the view on its own, by creating a view for instance
+  void ForgetViewLocked();
+
   // disable copy
   OfficeInstance(const OfficeInstance&) = delete;
   OfficeInstance& operator=(const OfficeInstance&) = delete;
@@ -86,19 +112,45 @@ class OfficeInstance {
 	std::atomic<bool> destroying_ = false;
   void Initialize();
 
+  base::TimeTicks create_time_;
+  base::Lock timings_lock_;
+  StartupTimings timings_ GUARDED_BY(timings_lock_);
+
+  // the queue for the current sequence, created on first use
+  scoped_refptr<DocumentEventQueue> CurrentEventQueue();
+  void RemoveEventRoute(const DocumentEventId& id,
+                        const scoped_refptr<DocumentEventQueue>& queue);
+  // queues are dropped once nothing is routed to them, the sequences they
+  // deliver to may be gone
+  void RemoveUnroutedEventQueuesLocked()
+      EXCLUSIVE_LOCKS_REQUIRED(event_lock_);
+
   using OfficeLoadObserverList =
       base::ObserverListThreadSafe<OfficeLoadObserver>;
-  using DocumentEventObserverList =
-      base::ObserverListThreadSafe<DocumentEventObserver>;
   using DestroyedObserverList =
       base::ObserverListThreadSafe<DestroyedObserver>;
   const scoped_refptr<OfficeLoadObserverList> loaded_observers_;
-  std::unordered_map<DocumentEventId, scoped_refptr<DocumentEventObserverList>>
-      document_event_observers_;
+
+  // document events are delivered through one queue per observing sequence,
+  // the lock only guards the routing since LOK calls back on its own thread
+  base::Lock event_lock_;
+  std::vector<scoped_refptr<DocumentEventQueue>> event_queues_
+      GUARDED_BY(event_lock_);
+  std::unordered_map<DocumentEventId,
+                     std::vector<scoped_refptr<DocumentEventQueue>>>
+      event_routes_ GUARDED_BY(event_lock_);
   std::unordered_multimap<size_t, DocumentEventId>
-      document_id_to_document_event_ids_;
+      document_id_to_document_event_ids_ GUARDED_BY(event_lock_);
   const scoped_refptr<DestroyedObserverList> destroyed_observers_;
 
+  base::Lock view_lock_;
+  // the thread holding view_lock_, kInvalidThreadId if none
+  std::atomic<base::PlatformThreadId> view_owner_ = base::kInvalidThreadId;
+  // the rest are only touched by the thread holding view_lock_
+  int view_lock_depth_ = 0;
+  lok::Document* current_view_document_ = nullptr;
+  int current_view_ = -1;
+
   base::WeakPtrFactory<OfficeInstance> weak_factory_{this};
 };
 
@@ -340,6 +340,43 @@ TEST_F(OfficeInstanceTest, DoesNotObserveAfterRemovalByEventId) {
   OfficeInstance::Get()->RemoveDocumentObservers(doc_id);
 }
 
+TEST_F(OfficeInstanceTest, ObservesAgainAfterEveryRouteIsRemoved) {
+  WaitLoad();
+
+  static constexpr size_t doc_id = 1;
+  static constexpr size_t event_type_id = 2;
+  static constexpr size_t view_id = 3;
+  static constexpr char payload[] = "this is a payload";
+
+  DocumentEventId id{doc_id, event_type_id, view_id};
+  MockDocumentEventObserver mock_observer;
+  EXPECT_CALL(mock_observer, DocumentCallback(event_type_id, payload));
+
+  // the last route of the sequence is removed, which drops its queue, so the
+  // observer added after must be routed to a new one
+  OfficeInstance::Get()->AddDocumentObserver(id, &mock_observer);
+  OfficeInstance::Get()->RemoveDocumentObserver(id, &mock_observer);
+  OfficeInstance::Get()->AddDocumentObserver(id, &mock_observer);
+
+  base::WaitableEvent waitable;
+  auto document_context = std::make_unique<DocumentCallbackContext>(
+      doc_id, view_id, OfficeInstance::Get());
+  base::ThreadPool::PostTask(
+      FROM_HERE, {base::MayBlock(), base::TaskPriority::USER_BLOCKING},
+      base::BindOnce(
+          [](base::WaitableEvent* waitable, DocumentCallbackContext* context) {
+            OfficeInstance::HandleDocumentCallback(event_type_id, payload,
+                                                   context);
+            waitable->Signal();
+          },
+          base::Unretained(&waitable), document_context.get()));
+
+  waitable.Wait();
+  base::RunLoop().RunUntilIdle();
+
+  OfficeInstance::Get()->RemoveDocumentObserver(id, &mock_observer);
+}
+
 TEST_F(OfficeInstanceTest, DoesNotObserveAfterRemovalByDocumentId) {
   WaitLoad();
 
@@ -499,4 +536,13 @@ TEST_F(OfficeInstanceTest, HandlesDestroyedClient) {
   OfficeInstance::Get()->RemoveDestroyedObserver(&waited);
 }
 
+TEST_F(OfficeInstanceTest, RecordsStartupTimings) {
+  ASSERT_TRUE(WaitLoad());
+
+  StartupTimings timings = OfficeInstance::Get()->GetStartupTimings();
+  EXPECT_TRUE(timings.complete);
+  EXPECT_FALSE(timings.lok_init.is_zero());
+  EXPECT_GE(timings.total, timings.queued + timings.lok_init);
+}
+
 }  // namespace electron::office
@@ -5,19 +5,25 @@
 #include "office/office_web_plugin.h"
 
 #include <algorithm>
+#include <cmath>
 #include <string_view>
+#include <tuple>
 
 #include "LibreOfficeKit/LibreOfficeKit.hxx"
 #include "base/auto_reset.h"
 #include "base/bind.h"
+#include "base/callback_helpers.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/weak_ptr.h"
 #include "base/no_destructor.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/task/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
 #include "base/time/time.h"
 #include "base/timer/timer.h"
 #include "cc/paint/paint_canvas.h"
+#include "cc/paint/paint_flags.h"
 #include "content/public/renderer/render_frame.h"
 #include "gin/arguments.h"
 #include "gin/converter.h"
@@ -33,12 +39,17 @@
 #include "office/office_instance.h"
 #include "office/office_keys.h"
 #include "office/paint_manager.h"
+#include "office/print_job.h"
+#include "office/session_recorder.h"
+#include "office/snapshot_store.h"
 #include "shell/common/gin_converters/gfx_converter.h"
 #include "third_party/blink/public/common/input/web_coalesced_input_event.h"
 #include "third_party/blink/public/common/input/web_input_event.h"
 #include "third_party/blink/public/common/input/web_keyboard_event.h"
 #include "third_party/blink/public/platform/web_input_event_result.h"
+#include "third_party/blink/public/platform/web_string.h"
 #include "third_party/blink/public/web/web_plugin_params.h"
+#include "third_party/blink/public/web/web_print_params.h"
 #include "third_party/blink/public/web/web_widget.h"
 #include "ui/base/cursor/cursor.h"
 #include "ui/base/cursor/mojom/cursor_type.mojom-shared.h"
@@ -48,6 +59,7 @@
 #include "ui/gfx/geometry/rect_f.h"
 #include "ui/gfx/geometry/size.h"
 #include "ui/gfx/geometry/skia_conversions.h"
+#include "v8/include/v8-array-buffer.h"
 #include "v8/include/v8-isolate.h"
 #include "v8/include/v8-local-handle.h"
 #include "v8/include/v8-object.h"
@@ -86,7 +98,12 @@ bool OfficeWebPlugin::Initialize(blink::WebPluginContainer* container) {
 
 void OfficeWebPlugin::Destroy() {
   paint_manager_->OnDestroy();
+  office::CancelFlag::Set(snapshot_cancel_flag_);
+  // outlives the document client, which goes away with the V8 context
+  if (!restore_key_.is_zero())
+    office::SnapshotStore::Get()->Put(restore_key_, snapshot_, zoom_);
   if (document_client_.MaybeValid()) {
+    document_client_->RemoveMemoryConsumer(this);
     document_client_->Unmount();
     document_client_->MarkRendererWillRemount(
         std::move(restore_key_),
@@ -139,6 +156,20 @@ v8::Local<v8::Object> OfficeWebPlugin::V8ScriptableObject(
             .SetMethod("debounceUpdates",
                        base::BindRepeating(&OfficeWebPlugin::DebounceUpdates,
                                            base::Unretained(this)))
+            .SetMethod("getInputLatency",
+                       base::BindRepeating(&OfficeWebPlugin::GetInputLatency,
+                                           base::Unretained(this)))
+            .SetMethod("resetInputLatency",
+                       base::BindRepeating(&OfficeWebPlugin::ResetInputLatency,
+                                           base::Unretained(this)))
+            .SetMethod("startRecording",
+                       base::BindRepeating(&OfficeWebPlugin::StartRecording,
+                                           base::Unretained(this)))
+            .SetMethod("stopRecording",
+                       base::BindRepeating(&OfficeWebPlugin::TakeRecording,
+                                           base::Unretained(this)))
+            .SetMethod("setPart", base::BindRepeating(&OfficeWebPlugin::SetPart,
+                                                      base::Unretained(this)))
             .SetProperty(
                 "documentSize",
                 base::BindRepeating(&OfficeWebPlugin::GetDocumentCSSPixelSize,
@@ -169,14 +200,32 @@ bool OfficeWebPlugin::SupportsKeyboardFocus() const {
 void OfficeWebPlugin::UpdateAllLifecyclePhases(
     blink::DocumentUpdateReason reason) {}
 
-void OfficeWebPlugin::UpdateSnapshot(const office::Snapshot snapshot) {
-  if (snapshot.tiles.empty())
+void OfficeWebPlugin::TakeSnapshot(const gfx::Rect& rect) {
+  office::SnapshotTiles tiles = tile_buffer_->CollectSnapshotTiles(rect);
+  if (tiles.tiles.empty())
+    return;
+
+  office::CancelFlag::CancelAndReset(snapshot_cancel_flag_);
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::TaskPriority::USER_VISIBLE},
+      base::BindOnce(&office::FlattenSnapshot, snapshot_cancel_flag_,
+                     std::move(tiles)),
+      base::BindOnce(&OfficeWebPlugin::UpdateSnapshot, GetWeakPtr(),
+                     snapshot_cancel_flag_));
+}
+
+void OfficeWebPlugin::UpdateSnapshot(office::CancelFlagPtr cancel_flag,
+                                     office::Snapshot snapshot) {
+  if (office::CancelFlag::IsCancelled(cancel_flag) || snapshot.IsEmpty())
     return;
   snapshot_ = std::move(snapshot);
 }
 
 void OfficeWebPlugin::Paint(cc::PaintCanvas* canvas, const gfx::Rect& rect) {
   base::AutoReset<bool> auto_reset_in_paint(&in_paint_, true);
+  const base::TimeTicks paint_start = session_recorder_.IsRecording()
+                                          ? base::TimeTicks::Now()
+                                          : base::TimeTicks();
   if (!visible_) {
     return;
   }
@@ -198,14 +247,53 @@ void OfficeWebPlugin::Paint(cc::PaintCanvas* canvas, const gfx::Rect& rect) {
   if (!plugin_rect_.origin().IsOrigin())
     canvas->translate(plugin_rect_.x(), plugin_rect_.y());
 
+  if (slide_image_) {
+    cc::PaintCanvasAutoRestore slide_restore(canvas, true);
+    const float scale = GetDocumentPixelSize().width() /
+                        static_cast<float>(slide_image_.width());
+    canvas->translate(0, -scroll_y_position_);
+    canvas->scale(scale, scale);
+    canvas->drawImage(slide_image_, 0, 0);
+  }
+
   gfx::Rect size(invalidate_rect.width(), invalidate_rect.height());
   std::vector<office::TileRange> missing =
       tile_buffer_->PaintToCanvas(paint_cancel_flag_, canvas, snapshot_, size,
                                   TotalScale(), scale_pending_, scrolling_);
+  PaintPredictedCaret(canvas);
+
+  if (session_recorder_.IsRecording()) {
+    office::SessionEvent paint;
+    paint.kind = office::SessionEvent::Kind::kPaint;
+    paint.duration = base::TimeTicks::Now() - paint_start;
+    paint.complete = missing.empty() && !scale_pending_;
+    session_recorder_.Record(std::move(paint));
+  }
+
+  // the typed text has reached the screen once the tiles LOK invalidated in
+  // response are all painted
+  if (pending_key_invalidated_ && missing.empty()) {
+    key_to_pixel_.Record(base::TimeTicks::Now() - pending_key_time_);
+    ResetPendingKey();
+  }
 
   if (missing.size() == 0 && take_snapshot_ && !scrolling_) {
-    UpdateSnapshot(tile_buffer_->MakeSnapshot(paint_cancel_flag_, size));
+    TakeSnapshot(size);
     take_snapshot_ = false;
+    // first paint of a presentation, or the slides were added or removed
+    if (is_presentation_ && slide_cache_.BytesUsed() == 0)
+      PrerenderSlides();
+  }
+  if (missing.empty() && slide_image_) {
+    slide_image_ = {};
+    PrerenderSlides();
+  }
+  if (missing.empty() && repaint_outward_) {
+    repaint_outward_ = false;
+    int view_height = available_area_.height();
+    paint_manager_->SchedulePaint(
+        document_, scroll_y_position_, view_height, TotalScale(), false,
+        {tile_buffer_->NextScrollTileRange(scroll_y_position_, view_height)});
   }
   if (update_debounce_timer_ && !scrolling_)
     paint_manager_->PausePaint();
@@ -214,7 +302,13 @@ void OfficeWebPlugin::Paint(cc::PaintCanvas* canvas, const gfx::Rect& rect) {
   if (scale_pending_) {
     scale_pending_ = false;
     tile_buffer_->ResetScale(TotalScale());
+    // the snapshot stands in for several zoom steps, so it's only taken again
+    // if the document changed or it no longer covers the view
+    const bool content_changed = take_snapshot_;
     ScheduleAvailableAreaPaint();
+    gfx::Rect view = size;
+    view.Offset(0, scroll_y_position_);
+    take_snapshot_ = content_changed || !snapshot_.Covers(TotalScale(), view);
     first_paint_ = false;
   } else {
     if (!paint_manager_->ScheduleNextPaint(missing) && missing.size() != 0) {
@@ -263,11 +357,100 @@ void OfficeWebPlugin::UpdateFocus(bool focused,
   has_focus_ = focused;
 }
 
+namespace {
+// how long a plugin stays hidden before its tiles are released, short enough
+// to matter with many tabs open, long enough to not repaint on a quick switch
+constexpr base::TimeDelta kHiddenTrimDelay = base::Seconds(30);
+}  // namespace
+
 void OfficeWebPlugin::UpdateVisibility(bool visibility) {
+  if (visible_ == visibility)
+    return;
+
   visible_ = visibility;
+  if (visibility) {
+    OnShown();
+  } else {
+    OnHidden();
+  }
+}
+
+void OfficeWebPlugin::OnHidden() {
+  // nothing is rasterized while hidden, invalidations are collected instead
+  paint_manager_->PausePaint();
+  paint_manager_->ClearTasks();
+  hidden_trim_timer_.Start(
+      FROM_HERE, hidden_trim_delay_for_testing_.value_or(kHiddenTrimDelay),
+      this, &OfficeWebPlugin::TrimHiddenTiles);
+}
+
+void OfficeWebPlugin::SetHiddenTrimDelayForTesting(base::TimeDelta delay) {
+  hidden_trim_delay_for_testing_ = delay;
+}
+
+void OfficeWebPlugin::TrimHiddenTiles() {
+  if (visible_)
+    return;
+
+  // the snapshot holds its own references, so the last frame survives
+  tile_buffer_->TrimMemory();
+  slide_cache_.Clear();
+  hidden_dirty_all_ = false;
+  hidden_dirty_twips_ = gfx::Rect();
+}
+
+void OfficeWebPlugin::AddMemoryStats(office::MemoryStats* stats) {
+  if (tile_buffer_)
+    tile_buffer_->AddMemoryStats(snapshot_, stats);
+  stats->slide_bytes += slide_cache_.BytesUsed();
+}
+
+void OfficeWebPlugin::TrimMemory() {
+  slide_cache_.Clear();
+  if (!tile_buffer_ || tile_buffer_->IsEmpty())
+    return;
+  if (!visible_) {
+    TrimHiddenTiles();
+    return;
+  }
+
+  // only the visible tiles are kept, the rest are painted again on scroll
+  gfx::RectF offset_area(available_area_);
+  offset_area.Offset(0, scroll_y_position_);
+  tile_buffer_->TrimTilesOutside(
+      tile_buffer_->LimitIndex(scroll_y_position_, offset_area.height()));
+}
+
+void OfficeWebPlugin::OnShown() {
+  hidden_trim_timer_.Stop();
+
+  if (tile_buffer_->IsTrimmed()) {
+    tile_buffer_->EnsurePool();
+  } else if (hidden_dirty_all_) {
+    tile_buffer_->InvalidateAllTiles();
+  } else if (!hidden_dirty_twips_.IsEmpty()) {
+    tile_buffer_->InvalidateTilesInTwipRect(hidden_dirty_twips_);
+  }
+  hidden_dirty_all_ = false;
+  hidden_dirty_twips_ = gfx::Rect();
+
+  paint_manager_->ResumePaint(false);
+  if (!document_ || tile_buffer_->IsEmpty())
+    return;
+
+  // the viewport first, then the surrounding area once it is painted
+  repaint_outward_ = true;
+  ScheduleAvailableAreaPaint(false);
 }
 
 namespace {
+// mouse moves are held for up to a frame so that a drag is sent as one move
+constexpr base::TimeDelta kInputFrameInterval = base::Milliseconds(16);
+
+// how long a sent key waits for LOK to invalidate before it's taken to have
+// changed nothing on screen
+constexpr base::TimeDelta kPendingKeyTimeout = base::Seconds(1);
+
 // this is kind of stupid, since there's probably a way to get this directly
 // from blink, but it works
 ui::mojom::CursorType cssCursorToMojom(const std::string& css) {
@@ -335,10 +518,13 @@ blink::WebInputEventResult OfficeWebPlugin::HandleInputEvent(
   if (blink::WebInputEvent::IsGestureEventType(event_type))
     return blink::WebInputEventResult::kNotHandled;
 
-  if (blink::WebInputEvent::IsKeyboardEventType(event_type))
+  if (blink::WebInputEvent::IsKeyboardEventType(event_type)) {
+    if (session_recorder_.IsRecording())
+      RecordInputEvent(event.Event());
     return HandleKeyEvent(
         std::move(static_cast<const blink::WebKeyboardEvent&>(event.Event())),
         cursor);
+  }
 
   switch (event_type) {
     case blink::WebInputEvent::Type::kMouseDown:
@@ -348,6 +534,8 @@ blink::WebInputEventResult OfficeWebPlugin::HandleInputEvent(
     default:
       return blink::WebInputEventResult::kNotHandled;
   }
+  if (session_recorder_.IsRecording())
+    RecordInputEvent(event.Event());
 
   int modifiers = event.Event().GetModifiers();
 
@@ -414,14 +602,19 @@ blink::WebInputEventResult OfficeWebPlugin::HandleKeyEvent(
 
   int lok_key_code = office::DOMKeyCodeToLOKKeyCode(event.dom_code, modifiers);
 
-  document_.Post(base::BindOnce(
-      [](LibreOfficeKitKeyEventType key_event, char16_t text, int lok_key_code,
-         DocumentHolderWithView holder) {
-        holder->postKeyEvent(key_event, text, lok_key_code);
-      },
-      type == blink::WebInputEvent::Type::kKeyUp ? LOK_KEYEVENT_KEYUP
-                                                 : LOK_KEYEVENT_KEYINPUT,
-      event.text[0], lok_key_code));
+  if (type == blink::WebInputEvent::Type::kRawKeyDown) {
+    if (pending_key_time_.is_null())
+      pending_key_time_ = base::TimeTicks::Now();
+    PredictCaret(event);
+  }
+
+  QueuedInput input{QueuedInput::Kind::kKey,
+                    type == blink::WebInputEvent::Type::kKeyUp
+                        ? LOK_KEYEVENT_KEYUP
+                        : LOK_KEYEVENT_KEYINPUT};
+  input.text = event.text[0];
+  input.key_code = lok_key_code;
+  QueueInput(std::move(input));
 
   return blink::WebInputEventResult::kHandledApplication;
 }
@@ -469,21 +662,251 @@ bool OfficeWebPlugin::HandleMouseEvent(blink::WebInputEvent::Type type,
     buttons |= 4;
 
   if (buttons > 0) {
-    document_.Post(base::BindOnce(
-        [](LibreOfficeKitMouseEventType event_type, gfx::Point pos,
-           int clickCount, int buttons, int modifiers,
-           DocumentHolderWithView holder) {
-          holder->postMouseEvent(event_type, pos.x(), pos.y(), clickCount,
-                                 buttons, modifiers);
-        },
-        event_type, std::move(pos), clickCount, buttons,
-        office::EventModifiersToLOKModifiers(modifiers)));
+    QueuedInput input{QueuedInput::Kind::kMouse, event_type};
+    input.position = pos;
+    input.click_count = clickCount;
+    input.buttons = buttons;
+    input.modifiers = office::EventModifiersToLOKModifiers(modifiers);
+    QueueInput(std::move(input));
     return true;
   }
 
   return false;
 }
 
+void OfficeWebPlugin::QueueInput(QueuedInput input) {
+  bool is_move = input.kind == QueuedInput::Kind::kMouse &&
+                 input.type == LOK_MOUSEEVENT_MOUSEMOVE;
+
+  // a drag only needs the latest position of the pointer, so consecutive moves
+  // with the same buttons held are collapsed into one
+  if (is_move && !queued_input_.empty()) {
+    QueuedInput& last = queued_input_.back();
+    if (last.kind == QueuedInput::Kind::kMouse &&
+        last.type == LOK_MOUSEEVENT_MOUSEMOVE &&
+        last.buttons == input.buttons && last.modifiers == input.modifiers) {
+      last = input;
+      return;
+    }
+  }
+  queued_input_.emplace_back(std::move(input));
+
+  // moves wait up to a frame to coalesce, everything else (including the moves
+  // queued before it) is sent on the next task to keep typing responsive
+  if (!is_move && !input_flush_immediate_) {
+    input_flush_immediate_ = true;
+    input_flush_scheduled_ = true;
+    task_runner_->PostTask(
+        FROM_HERE, base::BindOnce(&OfficeWebPlugin::FlushInput, GetWeakPtr()));
+  } else if (!input_flush_scheduled_) {
+    input_flush_scheduled_ = true;
+    task_runner_->PostDelayedTask(
+        FROM_HERE, base::BindOnce(&OfficeWebPlugin::FlushInput, GetWeakPtr()),
+        kInputFrameInterval);
+  }
+}
+
+void OfficeWebPlugin::FlushInput() {
+  input_flush_scheduled_ = false;
+  input_flush_immediate_ = false;
+  if (queued_input_.empty() || !document_)
+    return;
+
+  bool may_edit = false;
+  for (const QueuedInput& input : queued_input_) {
+    if (input.kind == QueuedInput::Kind::kKey) {
+      if (!pending_key_time_.is_null() && !pending_key_flushed_) {
+        pending_key_flushed_ = true;
+        // a key that moves nothing on screen (a modifier, a key at the end of
+        // the document) never invalidates, so it's dropped after a while
+        // instead of adding its wait to the next key that does
+        pending_key_timer_.Start(FROM_HERE, kPendingKeyTimeout, this,
+                                 &OfficeWebPlugin::ExpirePendingKey);
+      }
+      may_edit = true;
+      break;
+    }
+    // a drag ending can move content
+    if (input.type == LOK_MOUSEEVENT_MOUSEBUTTONUP)
+      may_edit = true;
+  }
+  if (may_edit && document_client_.MaybeValid())
+    document_client_->InvalidateSearchCache();
+
+  document_.Post(base::BindOnce(
+      [](std::vector<QueuedInput> inputs, DocumentHolderWithView holder) {
+        // a single view switch for the whole batch
+        DocumentHolderWithView::ViewSession session(holder);
+        for (const QueuedInput& input : inputs) {
+          if (input.kind == QueuedInput::Kind::kKey) {
+            session->postKeyEvent(input.type, input.text, input.key_code);
+          } else {
+            session->postMouseEvent(input.type, input.position.x(),
+                                    input.position.y(), input.click_count,
+                                    input.buttons, input.modifiers);
+          }
+        }
+      },
+      std::move(queued_input_)));
+  queued_input_.clear();
+}
+
+void OfficeWebPlugin::ResetPendingKey() {
+  pending_key_timer_.Stop();
+  pending_key_time_ = base::TimeTicks();
+  pending_key_flushed_ = false;
+  pending_key_invalidated_ = false;
+  pending_key_caret_painted_ = false;
+}
+
+void OfficeWebPlugin::ExpirePendingKey() {
+  if (!pending_key_invalidated_)
+    ResetPendingKey();
+}
+
+void OfficeWebPlugin::PredictCaret(const blink::WebKeyboardEvent& event) {
+  constexpr int kShortcutModifiers = blink::WebInputEvent::kControlKey |
+                                     blink::WebInputEvent::kMetaKey |
+                                     blink::WebInputEvent::kAltKey;
+  char16_t text = event.text[0];
+  bool printable = text >= 0x20 && text != 0x7f &&
+                   !(event.GetModifiers() & kShortcutModifiers);
+
+  // anything other than a printable character could move the cursor somewhere
+  // unpredictable, so the prediction is dropped until LOK reports the cursor,
+  // and nothing is painted while hidden
+  if (!printable || last_cursor_rect_.empty() || !visible_) {
+    if (predicted_chars_ > 0)
+      InvalidatePluginContainer();
+    predicted_chars_ = 0;
+    return;
+  }
+
+  // until a typed character has been measured, a character is assumed to be
+  // half as wide as the cursor is tall, which is close for most text fonts
+  if (caret_advance_ <= 0) {
+    std::string_view cursor_sv(last_cursor_rect_);
+    std::string_view::const_iterator start = cursor_sv.begin();
+    caret_advance_ =
+        office::lok_callback::ParseRect(start, cursor_sv.end()).height() / 2.0f;
+  }
+
+  ++predicted_chars_;
+  InvalidatePluginContainer();
+}
+
+void OfficeWebPlugin::UpdateCaretAdvance(const std::string& payload) {
+  std::string_view last_sv(last_cursor_rect_);
+  std::string_view::const_iterator last_start = last_sv.begin();
+  gfx::Rect last = office::lok_callback::ParseRect(last_start, last_sv.end());
+  std::string_view next_sv(payload);
+  std::string_view::const_iterator next_start = next_sv.begin();
+  gfx::Rect next = office::lok_callback::ParseRect(next_start, next_sv.end());
+
+  // only a move along the same line measures the width of the typed text
+  if (next.y() != last.y() || next.height() != last.height() ||
+      next.x() <= last.x())
+    return;
+  caret_advance_ = static_cast<float>(next.x() - last.x()) / predicted_chars_;
+}
+
+void OfficeWebPlugin::PaintPredictedCaret(cc::PaintCanvas* canvas) {
+  if (predicted_chars_ == 0 || last_cursor_rect_.empty())
+    return;
+
+  std::string_view payload_sv(last_cursor_rect_);
+  std::string_view::const_iterator start = payload_sv.begin();
+  gfx::Rect cursor = office::lok_callback::ParseRect(start, payload_sv.end());
+  if (cursor.height() == 0)
+    return;
+
+  // each character advances the caret by as much as the last typed ones moved
+  // the cursor LOK reported
+  float scale = TotalScale() / office::lok_callback::kTwipPerPx;
+  float x = (cursor.x() + predicted_chars_ * caret_advance_) * scale +
+            available_area_.x();
+  float y = cursor.y() * scale - scroll_y_position_ + available_area_.y();
+  float width = std::max(1.0f, cursor.width() * scale);
+  float height = cursor.height() * scale;
+
+  cc::PaintFlags flags;
+  flags.setColor(SK_ColorBLACK);
+  canvas->drawRect(SkRect::MakeXYWH(x, y, width, height), flags);
+
+  if (!pending_key_caret_painted_ && !pending_key_time_.is_null()) {
+    key_to_caret_.Record(base::TimeTicks::Now() - pending_key_time_);
+    pending_key_caret_painted_ = true;
+  }
+}
+
+void OfficeWebPlugin::LatencyStats::Record(base::TimeDelta latency) {
+  ++count;
+  total += latency;
+  max = std::max(max, latency);
+  last = latency;
+}
+
+v8::Local<v8::Value> OfficeWebPlugin::GetInputLatency(v8::Isolate* isolate) {
+  auto to_dict = [isolate](const LatencyStats& stats) {
+    gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+    dict.Set("count", stats.count);
+    dict.Set("mean", stats.count ? stats.total.InMillisecondsF() / stats.count
+                                 : 0.0);
+    dict.Set("max", stats.max.InMillisecondsF());
+    dict.Set("last", stats.last.InMillisecondsF());
+    return dict;
+  };
+
+  gin::Dictionary result = gin::Dictionary::CreateEmpty(isolate);
+  result.Set("keyToCaret", to_dict(key_to_caret_));
+  result.Set("keyToPixel", to_dict(key_to_pixel_));
+  return gin::ConvertToV8(isolate, result);
+}
+
+void OfficeWebPlugin::ResetInputLatency() {
+  key_to_caret_ = {};
+  key_to_pixel_ = {};
+}
+
+void OfficeWebPlugin::StartRecording() {
+  session_recorder_.Start();
+}
+
+std::string OfficeWebPlugin::StopRecording() {
+  return session_recorder_.Stop();
+}
+
+v8::Local<v8::Value> OfficeWebPlugin::TakeRecording(v8::Isolate* isolate) {
+  std::string trace = StopRecording();
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, trace.size());
+  memcpy(buffer->Data(), trace.data(), trace.size());
+  return buffer;
+}
+
+void OfficeWebPlugin::RecordInputEvent(const blink::WebInputEvent& event) {
+  office::SessionEvent recorded;
+  recorded.type = static_cast<int>(event.GetType());
+  recorded.modifiers = event.GetModifiers();
+  if (blink::WebInputEvent::IsKeyboardEventType(event.GetType())) {
+    const auto& key = static_cast<const blink::WebKeyboardEvent&>(event);
+    recorded.kind = office::SessionEvent::Kind::kKey;
+    recorded.windows_key_code = key.windows_key_code;
+    recorded.dom_code = key.dom_code;
+    recorded.dom_key = key.dom_key;
+    recorded.text = key.text[0];
+  } else {
+    // relative to the plugin, the document offset is applied again on replay
+    gfx::PointF position =
+        input::GetRelativeMousePosition(event, gfx::Vector2dF());
+    recorded.kind = office::SessionEvent::Kind::kMouse;
+    recorded.x = position.x();
+    recorded.y = position.y();
+    recorded.click_count = input::GetClickCount(event);
+  }
+  session_recorder_.Record(std::move(recorded));
+}
+
 void OfficeWebPlugin::DidReceiveResponse(
     const blink::WebURLResponse& response) {}
 
@@ -492,6 +915,49 @@ void OfficeWebPlugin::DidReceiveData(const char* data, size_t data_length) {}
 void OfficeWebPlugin::DidFinishLoading() {}
 void OfficeWebPlugin::DidFailLoading(const blink::WebURLError& error) {}
 
+bool OfficeWebPlugin::SupportsPaginatedPrint() {
+  if (!document_ || !document_client_.MaybeValid())
+    return false;
+  // spreadsheets have no pages until LOK paginates them for printing, which
+  // isn't exposed
+  // Pages are painted like tiles rather than through LOK's print path, from a
+  // view with the edit-only options off, so what LOK draws only on screen
+  // without a view option, like the selection of an object, can still be
+  // printed. See office::PrintJob.
+  return is_presentation_ || !document_client_->Geometry().IsEmpty();
+}
+
+int OfficeWebPlugin::PrintBegin(const blink::WebPrintParams& print_params) {
+  print_job_.reset();
+  if (!SupportsPaginatedPrint())
+    return 0;
+
+  // the page rects are copied, not rendered, so even a long document is cheap
+  // to start
+  std::vector<gfx::Rect> pages_twips;
+  int part_count = 0;
+  if (is_presentation_) {
+    pages_twips.emplace_back(document_client_->DocumentSizeTwips());
+    part_count = document_->getParts();
+  } else {
+    pages_twips = document_client_->Geometry().Rects();
+  }
+
+  print_job_ = std::make_unique<office::PrintJob>(
+      document_, std::move(pages_twips), part_count,
+      print_params.print_content_area, print_params.printer_dpi);
+  return print_job_->PageCount();
+}
+
+void OfficeWebPlugin::PrintPage(int page_number, cc::PaintCanvas* canvas) {
+  if (print_job_)
+    print_job_->PrintPage(page_number, canvas);
+}
+
+void OfficeWebPlugin::PrintEnd() {
+  print_job_.reset();
+}
+
 bool OfficeWebPlugin::CanEditText() const {
   return true;
 }
@@ -508,6 +974,66 @@ bool OfficeWebPlugin::CanRedo() const {
   return document_client_.MaybeValid() && document_client_->CanRedo();
 }
 
+bool OfficeWebPlugin::StartFind(const blink::WebString& search_text,
+                                bool case_sensitive,
+                                int identifier) {
+  std::string text = search_text.Utf8();
+  if (!document_client_.MaybeValid() || text.empty())
+    return false;
+
+  find_identifier_ = identifier;
+  find_text_ = std::move(text);
+  find_case_sensitive_ = case_sensitive;
+  find_count_ = 0;
+  find_index_ = -1;
+  document_client_->FindText(
+      find_text_, true, case_sensitive, false,
+      base::BindOnce(&OfficeWebPlugin::OnFindResults, GetWeakPtr(),
+                     identifier));
+  return true;
+}
+
+void OfficeWebPlugin::OnFindResults(
+    int identifier,
+    std::vector<office::SearchResult> results) {
+  // a newer find replaced this one
+  if (identifier != find_identifier_)
+    return;
+
+  find_count_ = results.size();
+  container::ReportFindMatchCount(container_, identifier, find_count_, true);
+  if (find_count_ > 0) {
+    find_index_ = 0;
+    container::ReportFindSelection(container_, identifier, find_index_ + 1,
+                                   true);
+  }
+}
+
+void OfficeWebPlugin::SelectFindResult(bool forward, int identifier) {
+  if (identifier != find_identifier_ || find_count_ == 0 ||
+      !document_client_.MaybeValid())
+    return;
+
+  // LOK moves the selection to the next match relative to the cursor, which
+  // follows the same order as the find-all results
+  find_index_ = (find_index_ + (forward ? 1 : find_count_ - 1)) % find_count_;
+  document_client_->FindText(find_text_, false, find_case_sensitive_,
+                             !forward, base::DoNothing());
+  container::ReportFindSelection(container_, identifier, find_index_ + 1,
+                                 true);
+}
+
+void OfficeWebPlugin::StopFind() {
+  find_identifier_ = -1;
+  find_text_.clear();
+  find_count_ = 0;
+  find_index_ = -1;
+  if (document_) {
+    document_.Post(base::BindOnce(
+        [](DocumentHolderWithView holder) { holder->resetSelection(); }));
+  }
+}
+
 content::RenderFrame* OfficeWebPlugin::render_frame() const {
   return render_frame_;
 }
@@ -533,6 +1059,8 @@ void OfficeWebPlugin::OnGeometryChanged(double old_zoom,
   if (!document_)
     return;
 
+  if (device_scale_ != old_device_scale)
+    UpdateTileFormat();
   if (viewport_zoom_ != old_zoom || device_scale_ != old_device_scale) {
     tile_buffer_->ResetScale(TotalScale());
   }
@@ -553,21 +1081,41 @@ void OfficeWebPlugin::OnGeometryChanged(double old_zoom,
       available_area_, office::lok_callback::kTwipPerPx);
 }
 
-std::vector<gfx::Rect> OfficeWebPlugin::PageRects() {
-  std::vector<gfx::Rect> result;
+void OfficeWebPlugin::UpdateTileFormat() {
+  if (!document_)
+    return;
 
+  office::TileFormat format = office::ChooseTileFormat(
+      document_->getDocumentType(), document_->getTileMode(), device_scale_);
+  if (!tile_buffer_->SetFormat(format))
+    return;
+  // queued paints are for tiles of the previous size
+  paint_manager_->ClearTasks();
+  take_snapshot_ = true;
+}
+
+std::vector<gfx::Rect> OfficeWebPlugin::PageRects() {
   if (!document_ || !document_client_.MaybeValid())
-    return result;
-  auto page_rects_ = document_client_->PageRects();
+    return {};
 
-  float scale = zoom_ / office::lok_callback::kTwipPerPx;
-  for (auto& rect : page_rects_) {
-    result.emplace_back(gfx::ScaleToCeiledPoint(rect.origin(), scale),
-                        gfx::ScaleToCeiledSize(rect.size(), scale));
+  // pageRects is read on every scroll by some embedders, only rescale when the
+  // geometry or the zoom actually changed
+  const office::PageGeometry& geometry = document_client_->Geometry();
+  if (geometry.Generation() != page_rects_generation_ ||
+      zoom_ != page_rects_zoom_) {
+    float scale = zoom_ / office::lok_callback::kTwipPerPx;
+    page_rects_cached_.clear();
+    page_rects_cached_.reserve(geometry.Size());
+    for (auto& rect : geometry.Rects()) {
+      page_rects_cached_.emplace_back(
+          gfx::ScaleToCeiledPoint(rect.origin(), scale),
+          gfx::ScaleToCeiledSize(rect.size(), scale));
+    }
+    page_rects_generation_ = geometry.Generation();
+    page_rects_zoom_ = zoom_;
   }
-  page_rects_cached_.assign(result.begin(), result.end());
   UpdateIntersectingPages();
-  return result;
+  return page_rects_cached_;
 }
 
 void OfficeWebPlugin::InvalidateAllTiles() {
@@ -632,8 +1180,34 @@ void OfficeWebPlugin::HandleInvalidateTiles(std::string payload) {
     return;
   }
 
+  if (pending_key_flushed_)
+    pending_key_invalidated_ = true;
+
   std::string_view payload_sv(payload);
 
+  // an edit on a slide, full invalidations are from switching
+  if (is_presentation_ && payload_sv.substr(0, 5) != "EMPTY") {
+    std::string_view::const_iterator start = payload_sv.begin();
+    std::vector<int64_t> values =
+        office::lok_callback::ParseCSV(start, payload_sv.end());
+    // x, y, width, height, then the part if LOK names it
+    slide_cache_.Invalidate(values.size() > 4 ? static_cast<int>(values[4])
+                                              : current_part_);
+  }
+
+  if (!visible_) {
+    if (hidden_dirty_all_ || tile_buffer_->IsTrimmed())
+      return;
+    if (payload_sv.substr(0, 5) == "EMPTY") {
+      hidden_dirty_all_ = true;
+    } else {
+      std::string_view::const_iterator start = payload_sv.begin();
+      hidden_dirty_twips_.Union(
+          office::lok_callback::ParseRect(start, payload_sv.end()));
+    }
+    return;
+  }
+
   // TODO: handle non-text document types for parts
   if (payload_sv.substr(0, 5) == "EMPTY") {
     auto num_payload = payload_sv.substr(5);
@@ -714,8 +1288,56 @@ float clipToNearest8PxZoom(int w, float s) {
 }
 }  // namespace
 
+bool OfficeWebPlugin::SetPart(int part) {
+  if (!document_ || !is_presentation_)
+    return false;
+  if (part < 0 || part >= document_->getParts())
+    return false;
+  if (part == current_part_)
+    return true;
+
+  document_->setPart(part);
+  ShowPart(part);
+  return true;
+}
+
+void OfficeWebPlugin::ShowPart(int part) {
+  paint_manager_->ClearTasks();
+  current_part_ = part;
+
+  // the tiles and snapshot are of the previous slide, which shares its tile
+  // indices with this one
+  tile_buffer_->ResetPool();
+  office::CancelFlag::Set(snapshot_cancel_flag_);
+  snapshot_ = {};
+  slide_image_ = slide_cache_.Get(part, TotalScale());
+  if (visible_ && !tile_buffer_->IsEmpty())
+    ScheduleAvailableAreaPaint();
+  PrerenderSlides();
+  InvalidatePluginContainer();
+}
+
+void OfficeWebPlugin::PrerenderSlides() {
+  if (!is_presentation_ || !document_ || !document_client_.MaybeValid())
+    return;
+
+  const gfx::Size slide_twips = document_client_->DocumentSizeTwips();
+  const int parts = document_->getParts();
+  // the current slide first, so switching back to it is instant
+  for (int part : {current_part_, current_part_ + 1, current_part_ - 1}) {
+    if (part >= 0 && part < parts)
+      slide_cache_.Prerender(document_, part, TotalScale(), slide_twips);
+  }
+}
+
 void OfficeWebPlugin::SetZoom(float zoom) {
-  zoom = clipToNearest8PxZoom(256, zoom);
+  if (session_recorder_.IsRecording()) {
+    office::SessionEvent zoom_event;
+    zoom_event.kind = office::SessionEvent::Kind::kZoom;
+    zoom_event.value = zoom;
+    session_recorder_.Record(std::move(zoom_event));
+  }
+  zoom = clipToNearest8PxZoom(tile_buffer_->Format().size_px, zoom);
 
   if (abs(zoom_ - zoom) < 0.0001f) {
     return;
@@ -749,30 +1371,28 @@ float OfficeWebPlugin::TwipToCSSPx(float in) {
 }
 
 void OfficeWebPlugin::UpdateIntersectingPages() {
+  if (!document_client_.MaybeValid())
+    return;
+
   float view_height =
       plugin_rect_.height() / device_scale_ / (float)viewport_zoom_;
-  gfx::Rect scroll_rect(gfx::Point(0, scroll_y_position_ / device_scale_),
-                        gfx::Size(800, view_height));
-  int i = 0;
-  first_intersect_ = -1;
-  last_intersect_ = -1;
-
-  for (auto& it : page_rects_cached_) {
-    if (first_intersect_ == -1 && it.Intersects(scroll_rect)) {
-      first_intersect_ = i;
-    }
-    if (first_intersect_ != -1) {
-      if (!it.Intersects(scroll_rect)) {
-        break;
-      } else {
-        last_intersect_ = i;
-      }
-    }
-    i++;
-  }
+  float top = scroll_y_position_ / device_scale_;
+  // the lookup is a binary search over the page rects in twips, so it doesn't
+  // depend on the rescaled page rects being up-to-date
+  float px_to_twip = office::lok_callback::kTwipPerPx / zoom_;
+  std::tie(first_intersect_, last_intersect_) =
+      document_client_->Geometry().IntersectingPages(
+          std::floor(top * px_to_twip),
+          std::ceil((top + view_height) * px_to_twip));
 }
 
 void OfficeWebPlugin::UpdateScroll(int64_t y_position) {
+  if (session_recorder_.IsRecording()) {
+    office::SessionEvent scroll;
+    scroll.kind = office::SessionEvent::Kind::kScroll;
+    scroll.value = y_position;
+    session_recorder_.Record(std::move(scroll));
+  }
   if (!document_ || !document_client_.MaybeValid() || stop_scrolling_)
     return;
   if (!tile_buffer_ || tile_buffer_->IsEmpty()) {
@@ -793,11 +1413,14 @@ void OfficeWebPlugin::UpdateScroll(int64_t y_position) {
   office::TileRange range =
       tile_buffer_->NextScrollTileRange(scroll_y_position_, view_height);
   tile_buffer_->SetYPosition(scaled_y);
-  paint_manager_->ResumePaint(false);
-  // TODO: schedule paint _ahead_ / _prior_ to scroll position
-  paint_manager_->SchedulePaint(document_, scroll_y_position_,
-                                view_height * device_scale_, TotalScale(),
-                                false, {range});
+  // the tiles at the new position are painted once shown, see OnShown
+  if (visible_) {
+    paint_manager_->ResumePaint(false);
+    // TODO: schedule paint _ahead_ / _prior_ to scroll position
+    paint_manager_->SchedulePaint(document_, scroll_y_position_,
+                                  view_height * device_scale_, TotalScale(),
+                                  false, {range});
+  }
   UpdateIntersectingPages();
   scrolling_ = true;
   take_snapshot_ = true;
@@ -819,7 +1442,7 @@ std::string OfficeWebPlugin::RenderDocument(
 
     float zoom;
     if (options_dict.Get("zoom", &zoom)) {
-      zoom_ = clipToNearest8PxZoom(256, zoom);
+      zoom_ = clipToNearest8PxZoom(tile_buffer_->Format().size_px, zoom);
     }
 
     bool disable_input;
@@ -838,6 +1461,10 @@ std::string OfficeWebPlugin::RenderDocument(
   if (registered_observers_ && document_) {
     document_.RemoveDocumentObservers(this);
   }
+  if (document_client_.MaybeValid() &&
+      document_client_.get() != client.get()) {
+    document_client_->RemoveMemoryConsumer(this);
+  }
   if (needs_reset && document_client_.MaybeValid()) {
     document_client_->Unmount();
   }
@@ -845,40 +1472,67 @@ std::string OfficeWebPlugin::RenderDocument(
 
   document_ = client->GetDocument();
   document_client_ = client->GetWeakPtr();
+  client->AddMemoryConsumer(this);
 
   if (!document_) {
     LOG(ERROR) << "document not held in client";
     return {};
   }
 
+  is_presentation_ =
+      document_->getDocumentType() == LOK_DOCTYPE_PRESENTATION;
+  if (needs_reset)
+    slide_cache_.Clear();
+  if (is_presentation_)
+    current_part_ = document_->getPart();
+
   if (needs_reset) {
     first_paint_ = true;
     tile_buffer_->InvalidateAllTiles();
   }
 
+  bool restored_snapshot_only = false;
   if (needs_restore) {
     auto transferable = client->GetRestoredRenderer(maybe_restore_key.value());
-    if (transferable.tile_buffer && !transferable.tile_buffer->IsEmpty()) {
-      tile_buffer_ = std::move(transferable.tile_buffer);
-    }
-    snapshot_ = std::move(transferable.snapshot);
+    float stored_zoom = 0;
     if (transferable.paint_manager) {
+      if (transferable.tile_buffer && !transferable.tile_buffer->IsEmpty()) {
+        tile_buffer_ = std::move(transferable.tile_buffer);
+        // trimmed by the document while waiting to remount
+        tile_buffer_->EnsurePool();
+      }
+      snapshot_ = std::move(transferable.snapshot);
       paint_manager_ = std::make_unique<office::PaintManager>(
           this, std::move(transferable.paint_manager));
-    }
-    first_paint_ = false;
-    page_rects_cached_ = std::move(transferable.page_rects);
-    first_intersect_ = transferable.first_intersect;
-    last_intersect_ = transferable.last_intersect;
-    last_cursor_rect_ = std::move(transferable.last_cursor_rect);
-    if (transferable.zoom > 0) {
-      zoom_ = transferable.zoom;
+      first_paint_ = false;
+      page_rects_cached_ = std::move(transferable.page_rects);
+      first_intersect_ = transferable.first_intersect;
+      last_intersect_ = transferable.last_intersect;
+      last_cursor_rect_ = std::move(transferable.last_cursor_rect);
+      if (transferable.zoom > 0) {
+        zoom_ = transferable.zoom;
+      }
+      office::SnapshotStore::Get()->Discard(maybe_restore_key.value());
+    } else if (office::SnapshotStore::Get()->Take(maybe_restore_key.value(),
+                                                  &snapshot_, &stored_zoom)) {
+      // the renderer state was lost with its V8 context, but the pixels are
+      // shown until the tiles are painted again
+      restored_snapshot_only = true;
+      if (stored_zoom > 0) {
+        zoom_ = stored_zoom;
+      }
     }
   }
 
+  UpdateTileFormat();
   client->Mount(isolate);
   if (needs_restore) {
     scroll_y_position_ = snapshot_.scroll_y_position;
+    if (restored_snapshot_only) {
+      auto size = document_client_->DocumentSizeTwips();
+      tile_buffer_->SetYPosition(scroll_y_position_);
+      tile_buffer_->Resize(size.width(), size.height(), TotalScale());
+    }
   } else {
     auto size = document_client_->DocumentSizeTwips();
     scroll_y_position_ = 0;
@@ -907,6 +1561,8 @@ std::string OfficeWebPlugin::RenderDocument(
   document_.AddDocumentObserver(LOK_CALLBACK_DOCUMENT_SIZE_CHANGED, this);
   document_.AddDocumentObserver(LOK_CALLBACK_INVALIDATE_TILES, this);
   document_.AddDocumentObserver(LOK_CALLBACK_INVALIDATE_VISIBLE_CURSOR, this);
+  document_.AddDocumentObserver(LOK_CALLBACK_INVALIDATE_SHEET_GEOMETRY, this);
+  document_.AddDocumentObserver(LOK_CALLBACK_SET_PART, this);
   registered_observers_ = true;
 
   if (needs_reset) {
@@ -993,13 +1649,21 @@ void OfficeWebPlugin::TryResumePaint() {
 }
 
 void OfficeWebPlugin::DebouncedResumePaint() {
-  if (!paint_manager_)
+  // resumed once shown, see OnShown
+  if (!paint_manager_ || !visible_)
     return;
 
   paint_manager_->ResumePaint();
 }
 
 void OfficeWebPlugin::DocumentCallback(int type, std::string payload) {
+  if (session_recorder_.IsRecording()) {
+    office::SessionEvent callback;
+    callback.kind = office::SessionEvent::Kind::kCallback;
+    callback.type = type;
+    callback.payload = payload;
+    session_recorder_.Record(std::move(callback));
+  }
   switch (type) {
     case LOK_CALLBACK_DOCUMENT_SIZE_CHANGED: {
       if (!document_)
@@ -1007,16 +1671,48 @@ void OfficeWebPlugin::DocumentCallback(int type, std::string payload) {
       long width, height;
       document_->getDocumentSize(&width, &height);
       tile_buffer_->Resize(width, height);
+      // slides were added or removed, which shifts the parts
+      if (is_presentation_)
+        slide_cache_.Clear();
       break;
     }
     case LOK_CALLBACK_INVALIDATE_TILES: {
       HandleInvalidateTiles(payload);
       break;
     }
+    case LOK_CALLBACK_INVALIDATE_SHEET_GEOMETRY: {
+      // rows or columns of a sheet were resized, hidden or grouped, which
+      // changes the size of the sheet without a full invalidation
+      if (!document_)
+        return;
+      long width, height;
+      document_->getDocumentSize(&width, &height);
+      tile_buffer_->Resize(width, height);
+      // only rows revealed by the change remain to be painted
+      if (visible_ && !tile_buffer_->IsEmpty())
+        ScheduleAvailableAreaPaint(false);
+      break;
+    }
+    case LOK_CALLBACK_SET_PART: {
+      // the view was switched by LOK, such as after inserting a slide
+      int part;
+      if (!document_ || !is_presentation_ ||
+          !base::StringToInt(payload, &part) || part == current_part_)
+        return;
+      ShowPart(part);
+      break;
+    }
     case LOK_CALLBACK_INVALIDATE_VISIBLE_CURSOR: {
       if (!payload.empty()) {
+        if (predicted_chars_ > 0 && !last_cursor_rect_.empty())
+          UpdateCaretAdvance(payload);
         last_cursor_rect_ = std::move(payload);
       }
+      // LOK caught up with the typed characters
+      if (predicted_chars_ > 0) {
+        predicted_chars_ = 0;
+        InvalidatePluginContainer();
+      }
       break;
     }
   }
@@ -21,8 +21,13 @@
 #include "office/document_event_observer.h"
 #include "office/document_holder.h"
 #include "office/lok_tilebuffer.h"
+#include "office/memory_stats.h"
 #include "office/office_client.h"
 #include "office/paint_manager.h"
+#include "office/print_job.h"
+#include "office/session_recorder.h"
+#include "office/slide_cache.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 #include "third_party/blink/public/common/input/web_keyboard_event.h"
 #include "third_party/blink/public/platform/web_input_event_result.h"
 #include "third_party/blink/public/web/web_plugin.h"
@@ -62,7 +67,8 @@ blink::WebPlugin* CreateInternalPlugin(blink::WebPluginParams params,
 class OfficeWebPlugin : public blink::WebPlugin,
                         public office::PaintManager::Client,
                         public office::DocumentEventObserver,
-                        public office::DestroyedObserver {
+                        public office::DestroyedObserver,
+                        public office::MemoryConsumer {
  public:
   OfficeWebPlugin(blink::WebPluginParams /*params*/,
                   content::RenderFrame* render_frame);
@@ -99,13 +105,17 @@ class OfficeWebPlugin : public blink::WebPlugin,
   void DidFinishLoading() override;
   void DidFailLoading(const blink::WebURLError& error) override;
 
-  // TODO: See if we need to support printing through Chromium?
-  // bool SupportsPaginatedPrint() override;
+  // printed page by page, see office::PrintJob
+  bool SupportsPaginatedPrint() override;
   // bool GetPrintPresetOptionsFromDocument(
   //     blink::WebPrintPresetOptions* print_preset_options) override;
-  // int PrintBegin(const blink::WebPrintParams& print_params) override;
-  // void PrintPage(int page_number, cc::PaintCanvas* canvas) override;
-  // void PrintEnd() override;
+  int PrintBegin(const blink::WebPrintParams& print_params) override;
+  void PrintPage(int page_number, cc::PaintCanvas* canvas) override;
+  void PrintEnd() override;
+
+  // records a trace of the session, see office::SessionRecorder
+  void StartRecording();
+  std::string StopRecording();
 
   // TODO: Support copy/paste
   // bool HasSelection() const override;
@@ -130,12 +140,11 @@ class OfficeWebPlugin : public blink::WebPlugin,
   // blink::WebURL LinkAtPosition(const gfx::Point& /*position*/) const
   // override;
 
-  // TODO: Check if we need this
-  // bool StartFind(const blink::WebString& search_text,
-  //                bool case_sensitive,
-  //                int identifier) override;
-  // void SelectFindResult(bool forward, int identifier) override;
-  // void StopFind() override;
+  bool StartFind(const blink::WebString& search_text,
+                 bool case_sensitive,
+                 int identifier) override;
+  void SelectFindResult(bool forward, int identifier) override;
+  void StopFind() override;
   // bool CanRotateView() override;
   // void RotateView(blink::WebPlugin::RotationType type) override;
 
@@ -168,7 +177,10 @@ class OfficeWebPlugin : public blink::WebPlugin,
   void TriggerFullRerender();
   void ScheduleAvailableAreaPaint(bool invalidate = true);
   base::WeakPtr<OfficeWebPlugin> GetWeakPtr();
-  void UpdateSnapshot(const office::Snapshot snapshot);
+  // Flattens the tiles around `rect` into a snapshot on a worker
+  void TakeSnapshot(const gfx::Rect& rect);
+  void UpdateSnapshot(office::CancelFlagPtr cancel_flag,
+                      office::Snapshot snapshot);
 
   // DocumentEventObserver
   void DocumentCallback(int type, std::string payload) override;
@@ -176,6 +188,13 @@ class OfficeWebPlugin : public blink::WebPlugin,
   // DestroyedObserver
   void OnDestroyed() override;
 
+  // MemoryConsumer
+  void AddMemoryStats(office::MemoryStats* stats) override;
+  void TrimMemory() override;
+
+  // replaces kHiddenTrimDelay for the next time the plugin is hidden
+  void SetHiddenTrimDelayForTesting(base::TimeDelta delay);
+
  private:
   // call `Destroy()` instead.
   ~OfficeWebPlugin() override;
@@ -187,6 +206,33 @@ class OfficeWebPlugin : public blink::WebPlugin,
                         int clickCount,
                         ui::Cursor* cursor);
 
+  // Input Pipeline {
+  // an input event waiting to be posted to LOK
+  struct QueuedInput {
+    enum class Kind { kKey, kMouse };
+    Kind kind;
+    // LibreOfficeKitKeyEventType or LibreOfficeKitMouseEventType
+    int type;
+    char16_t text = 0;
+    int key_code = 0;
+    gfx::Point position;
+    int click_count = 0;
+    int buttons = 0;
+    int modifiers = 0;
+  };
+  // queues the input, coalescing consecutive mouse moves
+  void QueueInput(QueuedInput input);
+  // posts every queued input to LOK in a single task
+  void FlushInput();
+  // advances the predicted caret for a printable character or drops it
+  void PredictCaret(const blink::WebKeyboardEvent& event);
+  void PaintPredictedCaret(cc::PaintCanvas* canvas);
+  // measures caret_advance_ from the cursor LOK reported after typing
+  void UpdateCaretAdvance(const std::string& payload);
+  void ResetPendingKey();
+  void ExpirePendingKey();
+  // }
+
   // Updates the available area
   void OnGeometryChanged(double old_zoom, float old_device_scale);
 
@@ -208,6 +254,8 @@ class OfficeWebPlugin : public blink::WebPlugin,
   void InvalidateAllTiles();
   float GetZoom();
   float TwipToCSSPx(float in);
+  // switches the slide of a presentation, false if there is no such slide
+  bool SetPart(int part);
 
   // updates the first and last intersecting page number within view
   void UpdateIntersectingPages();
@@ -218,6 +266,12 @@ class OfficeWebPlugin : public blink::WebPlugin,
                              gin::Arguments* args);
   // debounces the renders at the specified interval
   void DebounceUpdates(int interval);
+  // latency from a key press to the caret and tiles updating on screen
+  v8::Local<v8::Value> GetInputLatency(v8::Isolate* isolate);
+  void ResetInputLatency();
+  // the trace as an ArrayBuffer
+  v8::Local<v8::Value> TakeRecording(v8::Isolate* isolate);
+  void RecordInputEvent(const blink::WebInputEvent& event);
 
   // }
 
@@ -227,9 +281,25 @@ class OfficeWebPlugin : public blink::WebPlugin,
   void HandleCursorInvalidated(std::string payload);
   // }
 
+  void OnFindResults(int identifier,
+                     std::vector<office::SearchResult> results);
+
   void DebouncedResumePaint();
   void TryResumePaint();
 
+  // picks the tile size and color type for the document and device scale
+  void UpdateTileFormat();
+
+  void OnHidden();
+  void OnShown();
+  void TrimHiddenTiles();
+
+  // renders the current slide and its neighbours in the background
+  void PrerenderSlides();
+  // shows `part` once the view is on it, the cached slide until its tiles
+  // are painted
+  void ShowPart(int part);
+
   // owns this class
   blink::WebPluginContainer* container_;
   void InvalidateWeakContainer();
@@ -271,6 +341,43 @@ class OfficeWebPlugin : public blink::WebPlugin,
   bool has_focus_;
   std::string last_cursor_rect_;
   base::TimeTicks last_css_cursor_time_ = base::TimeTicks();
+  // printable characters typed since LOK last moved the cursor
+  int predicted_chars_ = 0;
+  // how far, in twips, a typed character last moved the reported cursor,
+  // estimated from the cursor height until the first one is measured
+  float caret_advance_ = 0.0f;
+  // }
+
+  // Find State {
+  // the find-in-page request being served, -1 if none
+  int find_identifier_ = -1;
+  std::string find_text_;
+  bool find_case_sensitive_ = false;
+  int find_count_ = 0;
+  int find_index_ = -1;
+  // }
+
+  // Input State {
+  std::vector<QueuedInput> queued_input_;
+  bool input_flush_scheduled_ = false;
+  bool input_flush_immediate_ = false;
+  // the oldest key press that isn't on screen yet
+  base::TimeTicks pending_key_time_;
+  bool pending_key_flushed_ = false;
+  bool pending_key_invalidated_ = false;
+  bool pending_key_caret_painted_ = false;
+  base::OneShotTimer pending_key_timer_;
+  struct LatencyStats {
+    void Record(base::TimeDelta latency);
+
+    int count = 0;
+    base::TimeDelta total;
+    base::TimeDelta max;
+    base::TimeDelta last;
+  };
+  LatencyStats key_to_caret_;
+  LatencyStats key_to_pixel_;
+  office::SessionRecorder session_recorder_;
   // }
 
   // owned by
@@ -285,13 +392,40 @@ class OfficeWebPlugin : public blink::WebPlugin,
   std::unique_ptr<office::PaintManager> paint_manager_;
   bool take_snapshot_ = true;
   office::Snapshot snapshot_;
+  // set when a newer snapshot or a part switch supersedes the one being
+  // flattened
+  office::CancelFlagPtr snapshot_cancel_flag_;
   bool scrolling_ = false;
   std::vector<gfx::Rect> page_rects_cached_;
+  // the geometry generation and zoom that page_rects_cached_ was scaled for
+  uint64_t page_rects_generation_ = 0;
+  float page_rects_zoom_ = 0.0f;
   int first_intersect_ = -1;
   int last_intersect_ = -1;
   base::Token restore_key_;
 
+  // Presentation State {
+  bool is_presentation_ = false;
+  int current_part_ = 0;
+  office::SlideCache slide_cache_;
+  // the cached surface of a slide that was switched to, shown until its tiles
+  // are painted
+  cc::PaintImage slide_image_;
+  // }
+
+  // between PrintBegin and PrintEnd
+  std::unique_ptr<office::PrintJob> print_job_;
+
   bool visible_ = true;
+  // Hidden State {
+  base::OneShotTimer hidden_trim_timer_;
+  absl::optional<base::TimeDelta> hidden_trim_delay_for_testing_;
+  // invalidations received while hidden, in twips, applied when shown
+  gfx::Rect hidden_dirty_twips_;
+  bool hidden_dirty_all_ = false;
+  // when shown, the area around the viewport is repainted after the viewport
+  bool repaint_outward_ = false;
+  // }
   bool disable_input_ = false;
   bool doomed_ = false;
   bool registered_observers_ = false;
@@ -0,0 +1,86 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/page_geometry.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "office/lok_callback.h"
+
+namespace electron::office {
+
+PageGeometry::PageGeometry() = default;
+PageGeometry::~PageGeometry() = default;
+PageGeometry::PageGeometry(const PageGeometry&) = default;
+PageGeometry& PageGeometry::operator=(const PageGeometry&) = default;
+PageGeometry::PageGeometry(PageGeometry&&) noexcept = default;
+PageGeometry& PageGeometry::operator=(PageGeometry&&) noexcept = default;
+
+size_t PageGeometry::Update(std::string_view page_rects) {
+  if (page_rects == raw_)
+    return rects_.size();
+
+  // everything before the first differing character is unchanged, so only the
+  // page containing it and the pages after it need to be parsed again
+  auto mismatch = std::mismatch(raw_.begin(), raw_.end(), page_rects.begin(),
+                                page_rects.end());
+  const size_t changed_offset = mismatch.first - raw_.begin();
+  auto offset_it =
+      std::upper_bound(offsets_.begin(), offsets_.end(), changed_offset);
+  const size_t first_changed =
+      offset_it == offsets_.begin() ? 0 : offset_it - offsets_.begin() - 1;
+
+  const size_t resume_offset =
+      first_changed < offsets_.size() ? offsets_[first_changed] : 0;
+  rects_.resize(first_changed);
+  offsets_.resize(first_changed);
+  max_bottom_.resize(first_changed);
+  raw_.assign(page_rects.data(), page_rects.size());
+
+  std::string_view raw_view(raw_);
+  std::string_view::const_iterator target = raw_view.begin() + resume_offset;
+  std::string_view::const_iterator end = raw_view.end();
+  while (target < end) {
+    // skip the separators here, bounded by the end, so that a trailing ; isn't
+    // mistaken for another page. Only the separators, a - belongs to the
+    // coordinate after it.
+    while (target < end &&
+           (*target == ',' || *target == ';' || std::isspace(*target))) {
+      ++target;
+    }
+    if (target == end)
+      break;
+
+    offsets_.push_back(target - raw_view.begin());
+    const gfx::Rect& rect =
+        rects_.emplace_back(lok_callback::ParseRect(target, end));
+    max_bottom_.push_back(max_bottom_.empty()
+                              ? rect.bottom()
+                              : std::max(max_bottom_.back(), rect.bottom()));
+  }
+
+  ++generation_;
+  return first_changed;
+}
+
+std::pair<int, int> PageGeometry::IntersectingPages(int top, int bottom) const {
+  // first page whose bottom (or any bottom before it) extends below the top
+  auto first = std::upper_bound(max_bottom_.begin(), max_bottom_.end(), top);
+  if (first == max_bottom_.end())
+    return {-1, -1};
+
+  // last page starting above the bottom, pages are ordered by their top
+  auto last = std::lower_bound(
+      rects_.begin(), rects_.end(), bottom,
+      [](const gfx::Rect& rect, int y) { return rect.y() < y; });
+  int first_index = first - max_bottom_.begin();
+  int last_index = (last - rects_.begin()) - 1;
+  if (last_index < first_index)
+    return {-1, -1};
+
+  return {first_index, last_index};
+}
+
+}  // namespace electron::office
@@ -0,0 +1,58 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ui/gfx/geometry/rect.h"
+
+namespace electron::office {
+
+// Page rectangles in twips, as reported by getPartPageRectangles.
+//
+// Updates only re-parse the pages after the first change in the payload, and
+// the pages intersecting a vertical range are found with a binary search
+// instead of a scan, which matters for documents with thousands of pages.
+class PageGeometry {
+ public:
+  PageGeometry();
+  ~PageGeometry();
+
+  PageGeometry(const PageGeometry&);
+  PageGeometry& operator=(const PageGeometry&);
+  PageGeometry(PageGeometry&&) noexcept;
+  PageGeometry& operator=(PageGeometry&&) noexcept;
+
+  // Replaces the geometry with the ;-separated list of rects in `page_rects`,
+  // returns the index of the first page that changed, or Size() if none did
+  size_t Update(std::string_view page_rects);
+
+  const std::vector<gfx::Rect>& Rects() const { return rects_; }
+  size_t Size() const { return rects_.size(); }
+  bool IsEmpty() const { return rects_.empty(); }
+
+  // The first and last page intersecting [top, bottom) in twips, or {-1, -1}
+  // if no page intersects. O(log n).
+  std::pair<int, int> IntersectingPages(int top, int bottom) const;
+
+  // Incremented on every change, for caches derived from the rects
+  uint64_t Generation() const { return generation_; }
+
+ private:
+  std::string raw_;
+  std::vector<gfx::Rect> rects_;
+  // offset in raw_ where the text for each page starts
+  std::vector<size_t> offsets_;
+  // running maximum of the page bottoms, which is sorted even when pages sit
+  // side-by-side
+  std::vector<int> max_bottom_;
+  uint64_t generation_ = 0;
+};
+
+}  // namespace electron::office
@@ -0,0 +1,95 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/page_geometry.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(PageGeometryTest, ParsesPages) {
+  PageGeometry geometry;
+  EXPECT_TRUE(geometry.IsEmpty());
+
+  EXPECT_EQ(geometry.Update("0, 0, 100, 200; 0, 300, 100, 200;"), size_t(0));
+  ASSERT_EQ(geometry.Size(), size_t(2));
+  EXPECT_EQ(geometry.Rects()[0], gfx::Rect(0, 0, 100, 200));
+  EXPECT_EQ(geometry.Rects()[1], gfx::Rect(0, 300, 100, 200));
+}
+
+TEST(PageGeometryTest, UpdatesFromFirstChange) {
+  PageGeometry geometry;
+  geometry.Update("0, 0, 100, 200; 0, 300, 100, 200; 0, 600, 100, 200");
+  uint64_t generation = geometry.Generation();
+
+  // unchanged
+  EXPECT_EQ(
+      geometry.Update("0, 0, 100, 200; 0, 300, 100, 200; 0, 600, 100, 200"),
+      size_t(3));
+  EXPECT_EQ(geometry.Generation(), generation);
+
+  // the second page grows, pushing the third down
+  EXPECT_EQ(
+      geometry.Update("0, 0, 100, 200; 0, 300, 100, 250; 0, 650, 100, 200"),
+      size_t(1));
+  EXPECT_GT(geometry.Generation(), generation);
+  ASSERT_EQ(geometry.Size(), size_t(3));
+  EXPECT_EQ(geometry.Rects()[1], gfx::Rect(0, 300, 100, 250));
+  EXPECT_EQ(geometry.Rects()[2], gfx::Rect(0, 650, 100, 200));
+
+  // a digit is appended to the last number of the last page
+  EXPECT_EQ(
+      geometry.Update("0, 0, 100, 200; 0, 300, 100, 250; 0, 650, 100, 2000"),
+      size_t(2));
+  EXPECT_EQ(geometry.Rects()[2], gfx::Rect(0, 650, 100, 2000));
+
+  // pages are removed
+  EXPECT_EQ(geometry.Update("0, 0, 100, 200"), size_t(0));
+  EXPECT_EQ(geometry.Size(), size_t(1));
+}
+
+TEST(PageGeometryTest, AppendsPages) {
+  PageGeometry geometry;
+  geometry.Update("0, 0, 100, 200;");
+  EXPECT_EQ(geometry.Update("0, 0, 100, 200; 0, 300, 100, 200;"), size_t(0));
+  EXPECT_EQ(geometry.Size(), size_t(2));
+  EXPECT_EQ(geometry.Rects()[1], gfx::Rect(0, 300, 100, 200));
+}
+
+TEST(PageGeometryTest, ParsesNegativeCoordinates) {
+  PageGeometry geometry;
+  geometry.Update("0, -300, 100, 200; -500, 0, 100, 200");
+  ASSERT_EQ(geometry.Size(), size_t(2));
+  EXPECT_EQ(geometry.Rects()[0], gfx::Rect(0, -300, 100, 200));
+  EXPECT_EQ(geometry.Rects()[1], gfx::Rect(-500, 0, 100, 200));
+}
+
+TEST(PageGeometryTest, IntersectingPages) {
+  PageGeometry geometry;
+  std::string payload;
+  for (int i = 0; i < 1000; ++i) {
+    payload += "0, " + std::to_string(i * 300) + ", 100, 200; ";
+  }
+  geometry.Update(payload);
+  ASSERT_EQ(geometry.Size(), size_t(1000));
+
+  EXPECT_EQ(geometry.IntersectingPages(0, 100), std::make_pair(0, 0));
+  // the gap between two pages
+  EXPECT_EQ(geometry.IntersectingPages(210, 290), std::make_pair(-1, -1));
+  EXPECT_EQ(geometry.IntersectingPages(150, 650), std::make_pair(0, 2));
+  EXPECT_EQ(geometry.IntersectingPages(299700, 400000),
+            std::make_pair(999, 999));
+  EXPECT_EQ(geometry.IntersectingPages(400000, 500000),
+            std::make_pair(-1, -1));
+}
+
+TEST(PageGeometryTest, IntersectingSideBySidePages) {
+  PageGeometry geometry;
+  // a tall page next to a short one
+  geometry.Update("0, 0, 100, 1000; 200, 0, 100, 200; 0, 1100, 100, 200");
+
+  EXPECT_EQ(geometry.IntersectingPages(150, 600), std::make_pair(0, 1));
+  EXPECT_EQ(geometry.IntersectingPages(1150, 1200), std::make_pair(2, 2));
+}
+
+}  // namespace electron::office
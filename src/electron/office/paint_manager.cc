@@ -6,8 +6,7 @@
 
 #include <memory>
 
-#include "base/barrier_closure.h"
-#include "base/task/bind_post_task.h"
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/time/time.h"
 #include "office/cancellation_flag.h"
@@ -17,6 +16,51 @@
 
 namespace electron::office {
 
+namespace {
+// blink doesn't expose BeginFrame to plugins, so this stands in for vsync
+constexpr base::TimeDelta kFrameInterval = base::Milliseconds(16);
+}  // namespace
+
+PaintManager::FramePacer::FramePacer(
+    scoped_refptr<base::TaskRunner> task_runner,
+    Client* client,
+    CancelFlagPtr cancel_invalidate)
+    : task_runner_(std::move(task_runner)),
+      client_(client),
+      cancel_invalidate_(std::move(cancel_invalidate)) {}
+
+PaintManager::FramePacer::~FramePacer() = default;
+
+void PaintManager::FramePacer::TileCompleted(
+    const CancelFlagPtr& task_cancel_flag) {
+  if (CancelFlag::IsCancelled(task_cancel_flag) ||
+      CancelFlag::IsCancelled(cancel_invalidate_))
+    return;
+
+  // a pending flush covers this tile too
+  if (flush_scheduled_.exchange(true))
+    return;
+
+  const int64_t now_us =
+      (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds();
+  const base::TimeDelta since_flush =
+      base::Microseconds(now_us - last_flush_us_.load());
+  const base::TimeDelta delay = since_flush >= kFrameInterval
+                                    ? base::TimeDelta()
+                                    : kFrameInterval - since_flush;
+  task_runner_->PostDelayedTask(
+      FROM_HERE, base::BindOnce(&FramePacer::Flush, base::WrapRefCounted(this)),
+      delay);
+}
+
+void PaintManager::FramePacer::Flush() {
+  last_flush_us_ =
+      (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds();
+  flush_scheduled_ = false;
+  if (!CancelFlag::IsCancelled(cancel_invalidate_))
+    client_->InvalidatePluginContainer();
+}
+
 PaintManager::Task::Task(DocumentHolderWithView document,
                          int y_pos,
                          int view_height,
@@ -45,7 +89,10 @@ PaintManager::PaintManager(Client* client)
       client_(client),
       current_task_(nullptr),
       next_task_(nullptr),
-      cancel_invalidate_(CancelFlag::Create()) {}
+      cancel_invalidate_(CancelFlag::Create()),
+      frame_pacer_(base::MakeRefCounted<FramePacer>(task_runner_,
+                                                    client_,
+                                                    cancel_invalidate_)) {}
 
 PaintManager::PaintManager(Client* client, std::unique_ptr<PaintManager> other)
     : task_runner_(base::ThreadPool::CreateTaskRunner(
@@ -53,7 +100,10 @@ PaintManager::PaintManager(Client* client, std::unique_ptr<PaintManager> other)
       client_(client),
       current_task_(std::move(other->current_task_)),
       next_task_(std::move(other->next_task_)),
-      cancel_invalidate_(CancelFlag::Create()) {}
+      cancel_invalidate_(CancelFlag::Create()),
+      frame_pacer_(base::MakeRefCounted<FramePacer>(task_runner_,
+                                                    client_,
+                                                    cancel_invalidate_)) {}
 
 PaintManager::PaintManager() = default;
 PaintManager::~PaintManager() {
@@ -210,15 +260,10 @@ void PaintManager::PostCurrentTask() {
     tile_buffer->SetActiveContext(hash);
   }
   auto simplified_ranges = SimplifyRanges(current_task_->tile_ranges_);
-  auto tile_count = TileCount(simplified_ranges);
-  base::RepeatingClosure completed = base::BarrierClosure(
-      tile_count,
-      base::BindPostTask(task_runner_,
-      base::BindOnce([](CancelFlagPtr task_cancel_flag, CancelFlagPtr manager_cancel_flag, Client* client) {
-        if (!CancelFlag::IsCancelled(manager_cancel_flag) && !CancelFlag::IsCancelled(task_cancel_flag)) {
-          client->InvalidatePluginContainer();
-        }
-      }, current_task_->skip_invalidation_flag_, cancel_invalidate_, base::Unretained(client_))));
+  // painted tiles are shown as they complete rather than after the whole task
+  base::RepeatingClosure completed =
+      base::BindRepeating(&FramePacer::TileCompleted, frame_pacer_,
+                          current_task_->skip_invalidation_flag_);
   for (auto& it : simplified_ranges) {
     task_runner_->PostTask(
         FROM_HERE,
@@ -241,6 +286,9 @@ void PaintManager::PaintTileRange(scoped_refptr<office::TileBuffer> tile_buffer,
 
   for (unsigned int tile_index = it.index_start; tile_index <= it.index_end;
        ++tile_index) {
+    // the task was replaced while this range was queued
+    if (CancelFlag::IsCancelled(cancel_flag))
+      break;
     if (!PaintTile(tile_buffer, cancel_flag, document, tile_index, context_hash,
                    completed))
       break;
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/task/task_runner.h"
@@ -92,6 +94,34 @@ class PaintManager {
                                     office::TileBuffer& tile_buffer);
   };
 
+  // Invalidates the client as tiles complete, at most once per frame, so long
+  // repaints show up progressively and short ones don't invalidate faster
+  // than they can be displayed. Tiles are completed on the thread pool.
+  class FramePacer : public base::RefCountedThreadSafe<FramePacer> {
+   public:
+    FramePacer(scoped_refptr<base::TaskRunner> task_runner,
+               Client* client,
+               CancelFlagPtr cancel_invalidate);
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // tiles from a task that was replaced or cleared don't invalidate
+    void TileCompleted(const CancelFlagPtr& task_cancel_flag);
+
+   private:
+    friend class base::RefCountedThreadSafe<FramePacer>;
+    ~FramePacer();
+
+    void Flush();
+
+    const scoped_refptr<base::TaskRunner> task_runner_;
+    Client* const client_;
+    const CancelFlagPtr cancel_invalidate_;
+    std::atomic<bool> flush_scheduled_{false};
+    std::atomic<int64_t> last_flush_us_{0};
+  };
+
   void PostCurrentTask();
   static bool PaintTile(scoped_refptr<office::TileBuffer> tile_buffer,
                         CancelFlagPtr cancel_flag,
@@ -114,6 +144,7 @@ class PaintManager {
   std::unique_ptr<Task> next_task_ = nullptr;
   base::TimeTicks last_paint_time_ = {};
   CancelFlagPtr cancel_invalidate_;
+  scoped_refptr<FramePacer> frame_pacer_;
 };
 
 }  // namespace electron::office
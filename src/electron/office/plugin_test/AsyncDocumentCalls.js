@@ -0,0 +1,53 @@
+async function testAsyncDocumentCalls() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  libreoffice.resetBlockingStats();
+
+  const html = `<!DOCTYPE html>
+<html>
+<body><h1 class="western">Header 1</h1>
+<p>Text</p>
+<h1 class="western">Header 1 #2</h1>
+</body>
+</html>`;
+  assert(await x.pasteAsync('text/html', html));
+  assert((await x.gotoOutlineAsync(1))?.destRect != null);
+  assert((await x.gotoOutlineAsync(5)) == null);
+
+  // smallest valid png
+  const testPng = new Uint8Array([
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x06, 0x00, 0x00, 0x00, 0x1f, 0x15, 0xc4, 0x89, 0x00, 0x00, 0x00,
+    0x0a, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0x00, 0x01, 0x00, 0x00,
+    0x05, 0x00, 0x01, 0x0d, 0x0a, 0x2d, 0xb4, 0x00, 0x00, 0x00, 0x00, 0x49,
+    0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+  ]);
+  assert(
+    await x.setClipboardAsync([{ mimeType: 'image/png', buffer: testPng.buffer }])
+  );
+
+  const pngContent = await x.getClipboardAsync(['image/png']);
+  assert(pngContent.length === 1);
+  assert(pngContent[0].mimeType === 'image/png');
+  const bufArray = new Uint8Array(pngContent[0].buffer);
+  assert(bufArray.every((b, idx) => b == testPng[idx]));
+
+  await x.setTextSelectionAsync(0, 0, 0);
+
+  // none of the above should have blocked the renderer thread
+  const stats = libreoffice.getBlockingStats();
+  assert(stats.paste === undefined);
+  assert(stats.getClipboard === undefined);
+  assert(stats.setClipboard === undefined);
+
+  x.getClipboard(['image/png']);
+  assert(libreoffice.getBlockingStats().getClipboard.count === 1);
+}
+
+testAsyncDocumentCalls();
@@ -0,0 +1,49 @@
+async function testAutosave() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  assert(!x.startAutosave(''));
+  assert(!x.startAutosave(tempFilePath('.journal'), { idle: 0 }));
+
+  // there is nothing to read before autosave starts
+  const path = tempFilePath('.journal');
+  assert((await libreoffice.readAutosave(path)) === undefined);
+
+  // the long interval and idle delay leave only the initial save
+  assert(x.startAutosave(path, { interval: 60000, idle: 60000 }));
+  await new Promise((resolve) => setTimeout(resolve, 500));
+  await idle();
+  const initial = await libreoffice.readAutosave(path);
+  assert(initial != null);
+  assert(initial.snapshot.byteLength > 0);
+  x.stopAutosave();
+
+  // typed text is saved after a pause in editing
+  assert(x.startAutosave(path, { interval: 60000, idle: 100 }));
+  await new Promise((resolve) => setTimeout(resolve, 500));
+  await idle();
+  sendKeyEvent(KeyEventType.Press, 'a');
+  await new Promise((resolve) => setTimeout(resolve, 500));
+  await idle();
+
+  const journal = await libreoffice.readAutosave(path);
+  assert(journal != null);
+  assert(journal.snapshot.byteLength > 0);
+
+  // the snapshot is a complete document
+  const restored = await libreoffice.loadDocumentFromArrayBuffer(
+    journal.snapshot
+  );
+  assert(restored != null);
+  let paragraphs = [];
+  await restored.extractText((batch) => paragraphs.push(...batch));
+  assert(paragraphs.some((p) => p.text.includes('a')));
+
+  x.stopAutosave();
+}
+
+testAutosave();
@@ -0,0 +1,38 @@
+async function testBinaryEvents() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  const batches = [];
+  let regularEvents = 0;
+  x.on('invalidate_tiles', (batch) => batches.push(batch), { binary: true });
+  x.on('invalidate_tiles', () => ++regularEvents);
+
+  updateFocus(true);
+  sendKeyEvent(KeyEventType.Press, 'a');
+  sendKeyEvent(KeyEventType.Press, 'b');
+  await idle();
+  await idle();
+
+  assert(regularEvents > 0);
+  assert(batches.length > 0);
+  // batched, so there can't be more batches than events
+  assert(batches.length <= regularEvents);
+
+  let events = 0;
+  for (const batch of batches) {
+    assert(batch.payload instanceof Int32Array);
+    assert(batch.offsets instanceof Int32Array);
+    assert(batch.offsets.length > 0);
+    events += batch.offsets.length;
+    for (const { index, payload } of batch.json ?? []) {
+      assert(index >= 0 && index < batch.offsets.length);
+      assert(typeof payload === 'object');
+    }
+  }
+  assert(events === regularEvents);
+}
+
+testBinaryEvents();
@@ -60,6 +60,15 @@ async function testClipboard() {
     content[1].mimeType === 'text/html' && content[1].text.includes(testString)
   );
 
+  // lazy items are only encoded when read
+  const lazyContent = x.getClipboard(['text/plain', 'text/html'], {
+    lazy: true,
+  });
+  assert(lazyContent.length === 2);
+  assert(lazyContent[1].mimeType === 'text/html');
+  assert(lazyContent[0].text === testString);
+  assert(lazyContent[1].text.includes(testString));
+
   // clear the document
   sendKeyEvent(KeyEventType.Press, 'mod+a');
   sendKeyEvent(KeyEventType.Press, 'backspace');
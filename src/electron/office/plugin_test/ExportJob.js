@@ -0,0 +1,34 @@
+async function testExportJob() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  let caught = false;
+  try {
+    x.exportAs(tempFileURL('.pdf'), { pageRange: '3-1' });
+  } catch {
+    caught = true;
+  }
+  assert(caught);
+
+  // completes with the progress at every page
+  const pdfURL = tempFileURL('.pdf');
+  const job = x.exportAs(pdfURL, { pageRange: '1' });
+  assert(job.progress.total === 1);
+  assert(await job.done);
+  assert(fileURLExists(pdfURL));
+  assert(job.progress.pages === 1);
+  assert(job.progress.percent === 100);
+
+  // cancelling leaves no output behind
+  const cancelledURL = tempFileURL('.docx');
+  const cancelled = x.exportAs(cancelledURL);
+  cancelled.cancel();
+  assert(!(await cancelled.done));
+  assert(!fileURLExists(cancelledURL));
+}
+
+testExportJob();
@@ -0,0 +1,68 @@
+async function testExtractText() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  const html = `<!DOCTYPE html>
+<html>
+<body><p>first paragraph</p>
+<p>second paragraph</p>
+<p>first paragraph</p>
+</body>
+</html>`;
+  assert(await x.pasteAsync('text/html', html));
+
+  let paragraphs = [];
+  const collect = (batch) => paragraphs.push(...batch);
+  const full = await x.extractText(collect);
+  assert(full.full);
+  assert(paragraphs.length === full.inserted);
+  const texts = paragraphs.map((p) => p.text);
+  assert(texts.includes('second paragraph'));
+  assert(paragraphs[0].hash === paragraphs[2].hash);
+  assert(paragraphs.every((p) => p.page === -1));
+
+  // nothing changed
+  paragraphs = [];
+  const unchanged = await x.extractText(collect, { since: full.revision });
+  assert(!unchanged.full);
+  assert(unchanged.revision === full.revision);
+  assert(unchanged.inserted === 0 && paragraphs.length === 0);
+
+  sendKeyEvent(KeyEventType.Press, 'mod+end');
+  sendKeyEvent(KeyEventType.Press, 'z');
+  await idle();
+  paragraphs = [];
+  const changed = await x.extractText(collect, { since: full.revision });
+  assert(!changed.full);
+  assert(changed.revision > full.revision);
+  assert(changed.removed === 1 && changed.inserted === 1);
+  assert(paragraphs.length === 1 && paragraphs[0].text.endsWith('z'));
+
+  // the repeated paragraph is located at its own position
+  paragraphs = [];
+  await x.extractText(collect, { withPositions: true });
+  const located = paragraphs.filter((p) => p.text === 'first paragraph');
+  assert(located.length === 2);
+  assert(located.every((p) => p.page === 0 && p.rects.length > 0));
+  assert(located[0].rects[0][1] < located[1].rects[0][1]);
+
+  // reading the text doesn't change the selection
+  sendKeyEvent(KeyEventType.Press, 'mod+home');
+  sendKeyEvent(KeyEventType.Press, 'shift+end');
+  await idle();
+  const xViewCursor = x
+    .as('text.XTextDocument')
+    .getCurrentController()
+    .as('text.XTextViewCursorSupplier')
+    .getViewCursor();
+  assert(xViewCursor.getString() === 'first paragraph');
+  await x.extractText(() => {}, { withPositions: true });
+  await idle();
+  assert(xViewCursor.getString() === 'first paragraph');
+}
+
+testExtractText();
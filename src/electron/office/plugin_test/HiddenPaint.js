@@ -0,0 +1,32 @@
+async function testHiddenPaint() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+  await painted();
+
+  // edits and scrolls while hidden are painted once shown
+  setHiddenTrimDelay(100);
+  updateVisibility(false);
+  const hiddenInvalidations = invalidations();
+  sendKeyEvent(KeyEventType.Press, 'a');
+  sendKeyEvent(KeyEventType.Press, 'b');
+  getEmbed().updateScroll(10);
+  await idle();
+  assert(x.getMemoryStats().tilePool > 0);
+
+  // the pool is released once hidden for the trim delay
+  await new Promise((resolve) => setTimeout(resolve, 300));
+  await idle();
+  assert(invalidations() === hiddenInvalidations);
+  assert(x.getMemoryStats().tilePool === 0);
+
+  updateVisibility(true);
+  await painted();
+  assert(canUndo());
+  assert(x.getMemoryStats().tilePool > 0);
+}
+
+testHiddenPaint();
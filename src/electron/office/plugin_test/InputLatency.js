@@ -0,0 +1,34 @@
+async function testInputLatency() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+  await x.initializeForRendering();
+  const embed = getEmbed();
+  embed.renderDocument(x);
+  await ready(x);
+
+  embed.resetInputLatency();
+  let latency = embed.getInputLatency();
+  assert(latency.keyToPixel.count === 0);
+  assert(latency.keyToCaret.count === 0);
+
+  updateFocus(true);
+  sendKeyEvent(KeyEventType.Press, 'a');
+  sendKeyEvent(KeyEventType.Press, 'b');
+  sendKeyEvent(KeyEventType.Press, 'c');
+  await idle();
+  await painted();
+
+  // the key presses were batched and still arrive in order
+  const xText = x.as('text.XTextDocument').getText();
+  assert(xText.getString() === 'abc');
+
+  latency = embed.getInputLatency();
+  // the predicted caret is only painted while LOK hasn't reported the cursor
+  // for the typed characters yet
+  assert(latency.keyToCaret.count >= 1);
+  assert(latency.keyToPixel.count >= 1);
+  assert(latency.keyToPixel.max >= latency.keyToPixel.last);
+  assert(latency.keyToPixel.mean > 0);
+}
+
+testInputLatency();
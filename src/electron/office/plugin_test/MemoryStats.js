@@ -0,0 +1,42 @@
+async function testMemoryStats() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+  await painted();
+
+  const stats = x.getMemoryStats();
+  assert(stats.tilePool > 0);
+  assert(stats.tiles > 0);
+  assert(
+    stats.total ===
+      stats.tilePool +
+        stats.tiles +
+        stats.snapshots +
+        stats.slides +
+        stats.pendingBuffers
+  );
+
+  // a save is only counted until it is handed to JS
+  const save = x.saveToMemory();
+  assert((await save).byteLength > 0);
+  assert(x.getMemoryStats().pendingBuffers === 0);
+
+  const process = libreoffice.getMemoryStats();
+  assert(process.total >= stats.total);
+  assert(process.heap > 0);
+
+  // hidden plugins release their pool when the document is over its limit
+  updateVisibility(false);
+  x.setMemoryLimit(1);
+  assert(x.getMemoryStats().tilePool === 0);
+  x.setMemoryLimit(0);
+
+  updateVisibility(true);
+  await painted();
+  assert(x.getMemoryStats().tilePool > 0);
+}
+
+testMemoryStats();
@@ -11,6 +11,20 @@ async function testNewView() {
   newView.paste('text/plain;charset=utf-8', testString);
 
   assert(x.as('text.XTextDocument').getText().getString() === testString);
+
+  // creating and pasting in the new view switched views
+  const switches = x.getViewSwitches();
+  assert(switches.total >= 1);
+
+  // alternating between the views switches on every call
+  for (let i = 0; i < 10; ++i) {
+    x.resetSelection();
+    newView.resetSelection();
+  }
+  const alternating = x.getViewSwitches();
+  assert(alternating.total - switches.total >= 20);
+  assert(alternating.perSecond > 0);
+  assert(newView.getViewSwitches().total >= alternating.total);
 }
 
 testNewView()
@@ -0,0 +1,19 @@
+async function testPrint() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  // an empty document is a single page
+  assert(getEmbed().pageRects.length === 1);
+  assert(printPages(300) === 1);
+
+  // a second page prints as a second page
+  x.postUnoCommand('.uno:InsertPagebreak');
+  await idle();
+  assert(printPages(600) === getEmbed().pageRects.length);
+}
+
+testPrint();
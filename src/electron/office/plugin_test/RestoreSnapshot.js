@@ -0,0 +1,35 @@
+async function testRestoreSnapshot() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  const restoreKey = getEmbed().renderDocument(x);
+  await ready(x);
+
+  sendKeyEvent(KeyEventType.Press, 'a');
+  await idle();
+  await painted();
+  // a complete paint takes the snapshot, which is flattened on a worker
+  assert(paintPixel(100, 100) !== 0);
+  await idle();
+
+  // a client that never held the renderer state, like one loaded after a
+  // reload, still restores the pixels of the last snapshot for the key
+  remountEmbed();
+  await idle();
+  const y = await loadEmptyDoc();
+  assert(y != null);
+  await y.initializeForRendering();
+  const nextRestoreKey = getEmbed().renderDocument(y, { restoreKey });
+  assert(nextRestoreKey !== restoreKey);
+  // no tile of the new client is rasterized yet, so anything painted is the
+  // restored snapshot
+  assert(paintPixel(100, 100) !== 0);
+  await painted();
+
+  sendKeyEvent(KeyEventType.Press, 'b');
+  await idle();
+  await painted();
+}
+
+testRestoreSnapshot();
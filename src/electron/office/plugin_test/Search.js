@@ -0,0 +1,68 @@
+async function testSearch() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  const html = `<!DOCTYPE html>
+<html>
+<body><p>needle one</p>
+<p>haystack</p>
+<p>Needle two</p>
+</body>
+</html>`;
+  assert(await x.pasteAsync('text/html', html));
+
+  assert((await x.search('')).length === 0);
+  assert((await x.search('missing')).length === 0);
+
+  const results = await x.search('needle');
+  assert(results.length === 2);
+  assert(results.every((r) => r.rects.length > 0 && r.page === 0));
+
+  const caseSensitive = await x.search('needle', { caseSensitive: true });
+  assert(caseSensitive.length === 1);
+
+  // served from the cache, so the rects are identical
+  const cached = await x.search('needle');
+  assert(cached.length === 2);
+  assert(cached[0].rects[0][1] === results[0].rects[0][1]);
+
+  const next = await x.search('needle', { all: false });
+  assert(next.length === 1);
+
+  // typing at the end of the document invalidates the cache
+  x.resetSelection();
+  sendKeyEvent(KeyEventType.Press, 'mod+end');
+  for (const c of ' needle') sendKeyEvent(KeyEventType.Press, c);
+  await idle();
+  assert((await x.search('needle')).length === 3);
+
+  // a find-all runs in a view of its own, leaving the selection alone
+  sendKeyEvent(KeyEventType.Press, 'mod+home');
+  sendKeyEvent(KeyEventType.Press, 'shift+end');
+  await idle();
+  const xController = x.as('text.XTextDocument').getCurrentController();
+  const xViewCursor = xController
+    .as('text.XTextViewCursorSupplier')
+    .getViewCursor();
+  const selected = xViewCursor.getString();
+  assert(selected === 'needle one');
+  assert((await x.search('haystack')).length === 1);
+  await idle();
+  assert(xViewCursor.getString() === selected);
+
+  // a search posted by the caller doesn't take the result of a pending one
+  const pending = x.search('two', { caseSensitive: true });
+  x.postUnoCommand('.uno:ExecuteSearch', {
+    'SearchItem.SearchString': { type: 'string', value: 'haystack' },
+    'SearchItem.Command': { type: 'long', value: 1 },
+  });
+  const two = await pending;
+  assert(two.length === 1);
+  assert(two[0].rects[0][1] !== results[0].rects[0][1]);
+}
+
+testSearch();
@@ -0,0 +1,39 @@
+async function testSessionReplay() {
+  const x = await loadEmptyDoc();
+  assert(x != null);
+  await x.initializeForRendering();
+  const embed = getEmbed();
+  embed.renderDocument(x);
+  await ready(x);
+
+  embed.startRecording();
+  updateFocus(true);
+  sendKeyEvent(KeyEventType.Press, 'a');
+  sendKeyEvent(KeyEventType.Press, 'b');
+  await idle();
+  await painted();
+  embed.updateScroll(100);
+  await painted();
+  const trace = embed.stopRecording();
+  assert(trace.byteLength > 0);
+
+  // a second recording replaces the first
+  embed.startRecording();
+  assert(embed.stopRecording().byteLength < trace.byteLength);
+
+  const report = await replaySession(trace);
+  assert(report != null);
+  // two key downs and a scroll
+  assert(report.input.count >= 1);
+  assert(report.input.p50 <= report.input.max);
+  assert(report.paint.count >= 1);
+  assert(report.callbacks >= 1);
+
+  // the replay typed into the same document again
+  const xText = x.as('text.XTextDocument').getText();
+  assert(xText.getString() === 'abab');
+
+  assert((await replaySession(new ArrayBuffer(4))) === undefined);
+}
+
+testSessionReplay();
@@ -0,0 +1,65 @@
+async function testSlideCache() {
+  const x = await libreoffice.loadDocument('private:factory/simpress');
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+  await painted();
+
+  x.postUnoCommand('.uno:InsertPage');
+  await idle();
+
+  assert(!getEmbed().setPart(-1));
+  assert(!getEmbed().setPart(99));
+
+  // the neighbour was prerendered, then back to the cached first slide
+  assert(getEmbed().setPart(1));
+  await painted();
+  assert(getEmbed().setPart(0));
+  await painted();
+}
+
+async function slidesCached(x, bytes) {
+  for (let i = 0; i < 100 && x.getMemoryStats().slides < bytes; ++i)
+    await new Promise((resolve) => setTimeout(resolve, 20));
+  return x.getMemoryStats().slides >= bytes;
+}
+
+async function testSlideCacheAfterSwitch() {
+  const x = await libreoffice.loadDocument('private:factory/simpress');
+  assert(x != null);
+
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+  await painted();
+  assert(await slidesCached(x, 1));
+  const slideBytes = x.getMemoryStats().slides;
+
+  x.postUnoCommand('.uno:InsertPage');
+  await idle();
+  assert(getEmbed().setPart(1));
+  await painted();
+  assert(await slidesCached(x, 2 * slideBytes));
+
+  // none of the first slide's tiles are painted yet, only its cached image
+  // can be shown right after the switch
+  assert(getEmbed().setPart(0));
+  assert(paintPixel(10, 10) !== 0);
+  await painted();
+}
+
+async function testSlideCacheText() {
+  const x = await loadEmptyDoc();
+  await x.initializeForRendering();
+  getEmbed().renderDocument(x);
+  await ready(x);
+
+  // text documents don't have slides
+  assert(!getEmbed().setPart(0));
+}
+
+testSlideCache()
+  .then(testSlideCacheAfterSwitch)
+  .then(testSlideCacheText);
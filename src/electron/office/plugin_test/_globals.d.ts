@@ -20,6 +20,7 @@ declare enum MouseButton {
 // the majority of these mimic the interactions of OfficeWebPlugin with Chromium
 declare function resizeEmbed(width: number, height: number): void;
 declare function updateFocus(focused: boolean, fromScript?: boolean): void;
+declare function updateVisibility(visible: boolean): void;
 /** resolves when an invalidation event is emitted */
 declare function invalidate(doc: LibreOffice.DocumentClient): Promise<void>;
 /** resolves when the ready event is emitted after rendering */
@@ -46,9 +47,51 @@ declare function idle(): Promise<void>;
   @param extension - the extension for the temporary file name, ex: '.docx', '.pdf'
 */
 declare function tempFileURL(extension: string): string;
+/**
+  returns a file system path to be used for a temporary file
+  @param extension - the extension for the temporary file name, ex: '.journal'
+*/
+declare function tempFilePath(extension: string): string;
 /** returns true if a file exists, false otherwise */
 declare function fileURLExists(): boolean;
+/**
+  prints every page of the rendered document the way Chromium would
+  @param dpi - the printer resolution
+  @returns the number of pages printed
+*/
+declare function printPages(dpi: number): number;
 /** resolves when the plugin paints */
 declare function painted(): Promise<void>;
+/** the number of times the plugin invalidated its container */
+declare function invalidations(): number;
+/** how long the plugin waits, once hidden, before releasing its tiles */
+declare function setHiddenTrimDelay(ms: number): void;
+/**
+  paints the embed right away
+  @returns the ARGB color of the pixel at x, y, 0 where nothing was painted
+*/
+declare function paintPixel(x: number, y: number): number;
 /** destroyes the current embed and replaces it with a new one */
 declare function remountEmbed(): void;
+
+declare type ReplayDistribution = {
+  count: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  max: number;
+};
+/**
+  replays the input of a trace from embed.stopRecording at its recorded timing
+  while recording again
+  @returns the input and paint latency of the replay in ms, undefined if the
+  trace can't be decoded
+*/
+declare function replaySession(trace: ArrayBuffer): Promise<
+  | {
+      input: ReplayDistribution;
+      paint: ReplayDistribution;
+      callbacks: number;
+    }
+  | undefined
+>;
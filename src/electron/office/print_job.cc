@@ -0,0 +1,138 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/print_job.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "LibreOfficeKit/LibreOfficeKit.hxx"
+#include "cc/paint/paint_canvas.h"
+#include "cc/paint/paint_flags.h"
+#include "office/blocking_watchdog.h"
+#include "office/document_image.h"
+#include "third_party/skia/include/core/SkColor.h"
+#include "ui/gfx/geometry/skia_conversions.h"
+
+namespace electron::office {
+
+namespace {
+constexpr float kTwipPerPoint = 20.0f;
+constexpr float kPointsPerInch = 72.0f;
+
+// drawn while editing but not part of the document: spelling underlines,
+// field shading, text boundaries, formatting marks and the comment margin
+constexpr const char* kEditOnlyViewOptions[] = {
+    "SpellOnline", "Marks", "ViewBounds", "ControlCodes", "ShowAnnotations"};
+}  // namespace
+
+PrintJob::PrintJob(DocumentHolderWithView document,
+                   std::vector<gfx::Rect> pages_twips,
+                   int part_count,
+                   const gfx::Rect& content_area,
+                   int printer_dpi)
+    : document_(std::move(document)),
+      pages_twips_(std::move(pages_twips)),
+      part_count_(part_count),
+      content_area_(content_area),
+      printer_dpi_(printer_dpi) {}
+
+PrintJob::~PrintJob() {
+  if (!print_view_)
+    return;
+  const int view_id = print_view_.ViewId();
+  {
+    // deregisters the view's callback while the view still exists
+    DocumentHolderWithView print_view = std::move(print_view_);
+  }
+  document_->destroyView(view_id);
+}
+
+const DocumentHolderWithView& PrintJob::PrintView() {
+  if (print_view_)
+    return print_view_;
+
+  // the options belong to the view, so the document's view is left as is
+  print_view_ = document_.NewView();
+  DocumentHolderWithView::ViewSession session(print_view_);
+  for (const char* option : kEditOnlyViewOptions) {
+    const std::string command = std::string(".uno:") + option;
+    // each option is set by a boolean argument of its own name
+    const std::string args = std::string("{\"") + option +
+                             "\":{\"type\":\"boolean\",\"value\":false}}";
+    session->postUnoCommand(command.c_str(), args.c_str(), false);
+  }
+  return print_view_;
+}
+
+int PrintJob::PageCount() const {
+  if (part_count_ > 0)
+    return pages_twips_.empty() ? 0 : part_count_;
+  return pages_twips_.size();
+}
+
+// static
+PrintJob::Layout PrintJob::FitPage(const gfx::Size& page_twips,
+                                   const gfx::Rect& content_area,
+                                   int printer_dpi) {
+  Layout layout;
+  if (page_twips.IsEmpty() || content_area.IsEmpty())
+    return layout;
+
+  gfx::SizeF page_pt(page_twips.width() / kTwipPerPoint,
+                     page_twips.height() / kTwipPerPoint);
+  const float fit =
+      std::min({1.0f, content_area.width() / page_pt.width(),
+                content_area.height() / page_pt.height()});
+  page_pt.Scale(fit);
+  layout.dest = gfx::RectF(gfx::PointF(content_area.origin()), page_pt);
+
+  const float dpi = std::clamp(printer_dpi, 1, kMaxDpi);
+  float width_px = page_pt.width() / kPointsPerInch * dpi;
+  float height_px = page_pt.height() / kPointsPerInch * dpi;
+  const float max_side = std::max(width_px, height_px);
+  if (max_side > kMaxSidePx) {
+    width_px *= kMaxSidePx / max_side;
+    height_px *= kMaxSidePx / max_side;
+  }
+  layout.size_px = gfx::Size(std::max(1.0f, std::round(width_px)),
+                             std::max(1.0f, std::round(height_px)));
+  return layout;
+}
+
+void PrintJob::PrintPage(int page, cc::PaintCanvas* canvas) {
+  if (!document_ || page < 0 || page >= PageCount())
+    return;
+
+  const gfx::Size page_twips = part_count_ > 0
+                                   ? pages_twips_.front().size()
+                                   : pages_twips_[page].size();
+  const Layout layout = FitPage(page_twips, content_area_, printer_dpi_);
+  if (layout.size_px.IsEmpty())
+    return;
+
+  // a slide is the whole of its part, a page is a rect of the document
+  const bool is_slide = part_count_ > 0;
+  cc::PaintImage image;
+  {
+    // the print dialog is modal, so blocking here only delays the job
+    BlockingWatchdog::Scope watchdog("printPage");
+    // paper is white, not transparent
+    image = RenderDocumentImage(
+        PrintView(), is_slide ? page : -1,
+        is_slide ? gfx::Rect(page_twips) : pages_twips_[page], layout.size_px,
+        SK_ColorWHITE);
+  }
+  if (!image)
+    return;
+
+  cc::PaintFlags flags;
+  canvas->drawImageRect(image, SkRect::MakeWH(image.width(), image.height()),
+                        gfx::RectFToSkRect(layout.dest),
+                        SkSamplingOptions(SkFilterMode::kLinear), &flags,
+                        SkCanvas::kStrict_SrcRectConstraint);
+}
+
+}  // namespace electron::office
@@ -0,0 +1,81 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+
+#include "cc/paint/paint_image.h"
+#include "office/document_holder.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/rect_f.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace cc {
+class PaintCanvas;
+}  // namespace cc
+
+namespace electron::office {
+
+// Prints a document page by page at the printer's resolution.
+//
+// Every page is rendered from LOK when it's printed, so rendering a page
+// doesn't wait on the rest of the document, and no intermediate PDF is ever
+// produced. A page's image lives as long as the canvas it's printed to keeps
+// it.
+//
+// Pages are painted like tiles, so they're rendered from a view of their own
+// with what's only drawn for editing turned off, see kEditOnlyViewOptions.
+class PrintJob {
+ public:
+  // Where a page lands in the print content area and the size it's rendered
+  // at
+  struct Layout {
+    // in the units of the content area, points
+    gfx::RectF dest;
+    gfx::Size size_px;
+  };
+
+  // Pages of a text document are the rects of `pages_twips` in the document,
+  // the pages of a presentation (`parts`) are its slides, each of the size
+  // of the only rect in `pages_twips`
+  PrintJob(DocumentHolderWithView document,
+           std::vector<gfx::Rect> pages_twips,
+           int part_count,
+           const gfx::Rect& content_area,
+           int printer_dpi);
+  ~PrintJob();
+
+  PrintJob(const PrintJob&) = delete;
+  PrintJob& operator=(const PrintJob&) = delete;
+
+  int PageCount() const;
+
+  // Renders `page` into `canvas`, does nothing for a page out of range
+  void PrintPage(int page, cc::PaintCanvas* canvas);
+
+  // Fits a page into the content area at its actual size, scaled down if it
+  // doesn't fit, rendered at `printer_dpi` but no more than kMaxDpi
+  static Layout FitPage(const gfx::Size& page_twips,
+                        const gfx::Rect& content_area,
+                        int printer_dpi);
+
+  // beyond this LOK takes longer to render than the printer takes to print
+  static constexpr int kMaxDpi = 300;
+  // the largest side of a rendered page, in pixels
+  static constexpr int kMaxSidePx = 8192;
+
+ private:
+  // creates the view pages are rendered from on the first page
+  const DocumentHolderWithView& PrintView();
+
+  DocumentHolderWithView document_;
+  DocumentHolderWithView print_view_;
+  const std::vector<gfx::Rect> pages_twips_;
+  const int part_count_;
+  const gfx::Rect content_area_;
+  const int printer_dpi_;
+};
+
+}  // namespace electron::office
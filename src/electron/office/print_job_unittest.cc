@@ -0,0 +1,51 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/print_job.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+namespace {
+// US Letter, 8.5in x 11in
+const gfx::Size kLetterTwips(12240, 15840);
+}  // namespace
+
+TEST(PrintJobTest, FitsPageAtActualSize) {
+  auto layout = PrintJob::FitPage(kLetterTwips, gfx::Rect(0, 0, 612, 792), 300);
+  EXPECT_EQ(layout.dest, gfx::RectF(0, 0, 612, 792));
+  EXPECT_EQ(layout.size_px, gfx::Size(2550, 3300));
+
+  // smaller pages aren't scaled up
+  layout = PrintJob::FitPage(gfx::Size(1440, 1440), gfx::Rect(10, 20, 612, 792),
+                             72);
+  EXPECT_EQ(layout.dest, gfx::RectF(10, 20, 72, 72));
+  EXPECT_EQ(layout.size_px, gfx::Size(72, 72));
+}
+
+TEST(PrintJobTest, ScalesPageDownToContentArea) {
+  auto layout =
+      PrintJob::FitPage(kLetterTwips, gfx::Rect(36, 36, 540, 720), 600);
+  EXPECT_FLOAT_EQ(layout.dest.x(), 36);
+  EXPECT_FLOAT_EQ(layout.dest.width(), 540);
+  EXPECT_LT(layout.dest.height(), 720);
+  // the resolution is capped at kMaxDpi
+  EXPECT_EQ(layout.size_px.width(), 540 * PrintJob::kMaxDpi / 72);
+}
+
+TEST(PrintJobTest, CapsRenderedSize) {
+  // a 100in square poster
+  auto layout = PrintJob::FitPage(gfx::Size(144000, 144000),
+                                  gfx::Rect(0, 0, 7200, 7200), 300);
+  EXPECT_EQ(layout.size_px,
+            gfx::Size(PrintJob::kMaxSidePx, PrintJob::kMaxSidePx));
+
+  EXPECT_TRUE(
+      PrintJob::FitPage(gfx::Size(), gfx::Rect(0, 0, 612, 792), 300)
+          .size_px.IsEmpty());
+  EXPECT_TRUE(
+      PrintJob::FitPage(kLetterTwips, gfx::Rect(), 300).size_px.IsEmpty());
+}
+
+}  // namespace electron::office
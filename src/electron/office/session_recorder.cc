@@ -0,0 +1,294 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/session_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "third_party/blink/public/common/input/web_input_event.h"
+
+namespace electron::office {
+
+namespace {
+constexpr char kMagic[] = {'L', 'O', 'K', 'T'};
+constexpr uint8_t kVersion = 1;
+
+void WriteVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// zigzag, so small negative values stay small
+void WriteSigned(int64_t value, std::string* out) {
+  WriteVarint((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63),
+              out);
+}
+
+void WriteFloat(float value, std::string* out) {
+  char bytes[sizeof(float)];
+  std::memcpy(bytes, &value, sizeof(float));
+  out->append(bytes, sizeof(float));
+}
+
+void WriteDouble(double value, std::string* out) {
+  char bytes[sizeof(double)];
+  std::memcpy(bytes, &value, sizeof(double));
+  out->append(bytes, sizeof(double));
+}
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool Done() const { return offset_ == data_.size(); }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (offset_ >= data_.size())
+        return false;
+      uint8_t byte = static_cast<uint8_t>(data_[offset_++]);
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSigned(int64_t* value) {
+    uint64_t raw;
+    if (!ReadVarint(&raw))
+      return false;
+    *value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+  }
+
+  bool ReadInt(int* value) {
+    int64_t raw;
+    if (!ReadSigned(&raw))
+      return false;
+    *value = static_cast<int>(raw);
+    return true;
+  }
+
+  template <typename T>
+  bool ReadRaw(T* value) {
+    if (data_.size() - offset_ < sizeof(T))
+      return false;
+    std::memcpy(value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint64_t size;
+    if (!ReadVarint(&size) || data_.size() - offset_ < size)
+      return false;
+    value->assign(data_.substr(offset_, size));
+    offset_ += size;
+    return true;
+  }
+
+ private:
+  std::string_view data_;
+  size_t offset_ = 0;
+};
+
+SessionReport::Distribution Summarize(std::vector<base::TimeDelta> samples) {
+  SessionReport::Distribution result;
+  result.count = samples.size();
+  if (samples.empty())
+    return result;
+
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+    return samples[std::max<size_t>(rank, 1) - 1];
+  };
+  result.p50 = percentile(0.5);
+  result.p90 = percentile(0.9);
+  result.p99 = percentile(0.99);
+  result.max = samples.back();
+  return result;
+}
+
+bool IsInput(const SessionEvent& event) {
+  switch (event.kind) {
+    case SessionEvent::Kind::kKey:
+      return event.type ==
+             static_cast<int>(blink::WebInputEvent::Type::kRawKeyDown);
+    case SessionEvent::Kind::kMouse:
+      return event.type ==
+             static_cast<int>(blink::WebInputEvent::Type::kMouseDown);
+    case SessionEvent::Kind::kScroll:
+    case SessionEvent::Kind::kZoom:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+SessionEvent::SessionEvent() = default;
+SessionEvent::~SessionEvent() = default;
+SessionEvent::SessionEvent(const SessionEvent&) = default;
+SessionEvent& SessionEvent::operator=(const SessionEvent&) = default;
+SessionEvent::SessionEvent(SessionEvent&&) = default;
+SessionEvent& SessionEvent::operator=(SessionEvent&&) = default;
+
+SessionRecorder::SessionRecorder() = default;
+SessionRecorder::~SessionRecorder() = default;
+
+void SessionRecorder::Start(base::TimeTicks now) {
+  trace_.assign(kMagic, sizeof(kMagic));
+  trace_.push_back(static_cast<char>(kVersion));
+  start_ = now;
+  last_time_ = base::TimeDelta();
+  recording_ = true;
+}
+
+std::string SessionRecorder::Stop() {
+  recording_ = false;
+  return std::move(trace_);
+}
+
+void SessionRecorder::Record(SessionEvent event, base::TimeTicks now) {
+  if (!recording_ || trace_.size() > kMaxBytes)
+    return;
+
+  // TimeTicks are monotonic, but the events of a test can share a tick
+  const base::TimeDelta time = std::max(now - start_, last_time_);
+  trace_.push_back(static_cast<char>(event.kind));
+  WriteVarint((time - last_time_).InMicroseconds(), &trace_);
+  last_time_ = time;
+
+  switch (event.kind) {
+    case SessionEvent::Kind::kKey:
+      WriteSigned(event.type, &trace_);
+      WriteSigned(event.modifiers, &trace_);
+      WriteSigned(event.windows_key_code, &trace_);
+      WriteSigned(event.dom_code, &trace_);
+      WriteSigned(event.dom_key, &trace_);
+      WriteVarint(event.text, &trace_);
+      break;
+    case SessionEvent::Kind::kMouse:
+      WriteSigned(event.type, &trace_);
+      WriteSigned(event.modifiers, &trace_);
+      WriteFloat(event.x, &trace_);
+      WriteFloat(event.y, &trace_);
+      WriteSigned(event.click_count, &trace_);
+      break;
+    case SessionEvent::Kind::kScroll:
+    case SessionEvent::Kind::kZoom:
+      WriteDouble(event.value, &trace_);
+      break;
+    case SessionEvent::Kind::kCallback:
+      WriteSigned(event.type, &trace_);
+      WriteVarint(std::min(event.payload.size(), kMaxPayloadBytes), &trace_);
+      trace_.append(event.payload, 0, kMaxPayloadBytes);
+      break;
+    case SessionEvent::Kind::kPaint:
+      WriteVarint(event.duration.InMicroseconds(), &trace_);
+      trace_.push_back(event.complete ? 1 : 0);
+      break;
+  }
+}
+
+// static
+bool SessionRecorder::Decode(std::string_view trace,
+                             std::vector<SessionEvent>* events) {
+  if (trace.size() < sizeof(kMagic) + 1 ||
+      trace.substr(0, sizeof(kMagic)) !=
+          std::string_view(kMagic, sizeof(kMagic)) ||
+      static_cast<uint8_t>(trace[sizeof(kMagic)]) != kVersion)
+    return false;
+
+  Reader reader(trace.substr(sizeof(kMagic) + 1));
+  base::TimeDelta time;
+  events->clear();
+  while (!reader.Done()) {
+    SessionEvent event;
+    uint8_t kind;
+    uint64_t delta;
+    if (!reader.ReadRaw(&kind) || !reader.ReadVarint(&delta))
+      return false;
+    time += base::Microseconds(delta);
+    event.kind = static_cast<SessionEvent::Kind>(kind);
+    event.time = time;
+
+    bool ok = false;
+    switch (event.kind) {
+      case SessionEvent::Kind::kKey: {
+        uint64_t text;
+        ok = reader.ReadInt(&event.type) && reader.ReadInt(&event.modifiers) &&
+             reader.ReadInt(&event.windows_key_code) &&
+             reader.ReadInt(&event.dom_code) &&
+             reader.ReadInt(&event.dom_key) && reader.ReadVarint(&text);
+        event.text = static_cast<char16_t>(text);
+        break;
+      }
+      case SessionEvent::Kind::kMouse:
+        ok = reader.ReadInt(&event.type) && reader.ReadInt(&event.modifiers) &&
+             reader.ReadRaw(&event.x) && reader.ReadRaw(&event.y) &&
+             reader.ReadInt(&event.click_count);
+        break;
+      case SessionEvent::Kind::kScroll:
+      case SessionEvent::Kind::kZoom:
+        ok = reader.ReadRaw(&event.value);
+        break;
+      case SessionEvent::Kind::kCallback:
+        ok = reader.ReadInt(&event.type) && reader.ReadString(&event.payload);
+        break;
+      case SessionEvent::Kind::kPaint: {
+        uint64_t duration;
+        uint8_t complete;
+        ok = reader.ReadVarint(&duration) && reader.ReadRaw(&complete);
+        event.duration = base::Microseconds(duration);
+        event.complete = complete != 0;
+        break;
+      }
+    }
+    if (!ok)
+      return false;
+    events->emplace_back(std::move(event));
+  }
+  return true;
+}
+
+// static
+SessionReport SessionReport::Analyze(const std::vector<SessionEvent>& events) {
+  SessionReport report;
+  std::vector<base::TimeDelta> input;
+  std::vector<base::TimeDelta> paint;
+  // inputs not yet on screen
+  std::vector<base::TimeDelta> pending;
+
+  for (const SessionEvent& event : events) {
+    if (IsInput(event)) {
+      pending.push_back(event.time);
+    } else if (event.kind == SessionEvent::Kind::kCallback) {
+      ++report.callbacks;
+    } else if (event.kind == SessionEvent::Kind::kPaint) {
+      paint.push_back(event.duration);
+      if (!event.complete)
+        continue;
+      // a paint is recorded when it ends
+      for (base::TimeDelta time : pending)
+        input.push_back(event.time - time);
+      pending.clear();
+    }
+  }
+
+  report.input = Summarize(std::move(input));
+  report.paint = Summarize(std::move(paint));
+  return report;
+}
+
+}  // namespace electron::office
@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/time/time.h"
+
+namespace electron::office {
+
+// One event of a recorded session
+struct SessionEvent {
+  enum class Kind : uint8_t {
+    kKey = 1,
+    kMouse = 2,
+    kScroll = 3,
+    kZoom = 4,
+    kCallback = 5,
+    kPaint = 6,
+  };
+
+  SessionEvent();
+  ~SessionEvent();
+  SessionEvent(const SessionEvent&);
+  SessionEvent& operator=(const SessionEvent&);
+  SessionEvent(SessionEvent&&);
+  SessionEvent& operator=(SessionEvent&&);
+
+  Kind kind = Kind::kKey;
+  // since the recording started
+  base::TimeDelta time;
+  // the blink event type of an input, or the LOK callback type
+  int type = 0;
+  int modifiers = 0;
+  // of a key
+  int windows_key_code = 0;
+  int dom_code = 0;
+  int dom_key = 0;
+  char16_t text = 0;
+  // of the mouse, in pixels relative to the plugin
+  float x = 0;
+  float y = 0;
+  int click_count = 0;
+  // the scroll position or the zoom
+  double value = 0;
+  // the LOK callback payload, truncated to kMaxPayloadBytes
+  std::string payload;
+  // of a paint, and whether every visible tile was painted
+  base::TimeDelta duration;
+  bool complete = false;
+};
+
+// Records the input, scroll, zoom, LOK callbacks and paints of a plugin into
+// a compact binary trace, so a session that stalled can be replayed against
+// the same document.
+//
+// Events are encoded as they're recorded: a kind byte, the time since the
+// previous event in microseconds and the fields of the kind, all as varints.
+class SessionRecorder {
+ public:
+  // callback payloads only matter for their type when replaying, so large
+  // ones (like a full outline) are cut short
+  static constexpr size_t kMaxPayloadBytes = 1024;
+  // events beyond this are dropped, a trace is meant to capture a stall and
+  // not a whole day of editing
+  static constexpr size_t kMaxBytes = 64 * 1024 * 1024;
+
+  SessionRecorder();
+  ~SessionRecorder();
+
+  SessionRecorder(const SessionRecorder&) = delete;
+  SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+  // Discards any trace and records from `now`
+  void Start(base::TimeTicks now = base::TimeTicks::Now());
+  // Returns the trace and stops recording
+  std::string Stop();
+  bool IsRecording() const { return recording_; }
+
+  // `event.time` is replaced by the time since Start
+  void Record(SessionEvent event, base::TimeTicks now = base::TimeTicks::Now());
+
+  // Decodes a trace, false if it isn't one or was cut short
+  static bool Decode(std::string_view trace, std::vector<SessionEvent>* events);
+
+ private:
+  bool recording_ = false;
+  base::TimeTicks start_;
+  base::TimeDelta last_time_;
+  std::string trace_;
+};
+
+// Latency distributions of a recorded session
+struct SessionReport {
+  struct Distribution {
+    size_t count = 0;
+    base::TimeDelta p50;
+    base::TimeDelta p90;
+    base::TimeDelta p99;
+    base::TimeDelta max;
+  };
+
+  // from a key down, mouse down, scroll or zoom to the end of the next paint
+  // that left nothing missing
+  Distribution input;
+  // the time spent in each paint
+  Distribution paint;
+  size_t callbacks = 0;
+
+  static SessionReport Analyze(const std::vector<SessionEvent>& events);
+};
+
+}  // namespace electron::office
@@ -0,0 +1,109 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/session_recorder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/blink/public/common/input/web_input_event.h"
+
+namespace electron::office {
+
+namespace {
+SessionEvent KeyDown(char16_t text) {
+  SessionEvent event;
+  event.kind = SessionEvent::Kind::kKey;
+  event.type = static_cast<int>(blink::WebInputEvent::Type::kRawKeyDown);
+  event.windows_key_code = text;
+  event.text = text;
+  return event;
+}
+
+SessionEvent Paint(int ms, bool complete) {
+  SessionEvent event;
+  event.kind = SessionEvent::Kind::kPaint;
+  event.duration = base::Milliseconds(ms);
+  event.complete = complete;
+  return event;
+}
+}  // namespace
+
+TEST(SessionRecorderTest, RoundTrips) {
+  const base::TimeTicks start = base::TimeTicks::Now();
+  SessionRecorder recorder;
+  EXPECT_FALSE(recorder.IsRecording());
+  // not recording
+  recorder.Record(KeyDown('x'), start);
+
+  recorder.Start(start);
+  recorder.Record(KeyDown('a'), start + base::Milliseconds(5));
+
+  SessionEvent mouse;
+  mouse.kind = SessionEvent::Kind::kMouse;
+  mouse.type = static_cast<int>(blink::WebInputEvent::Type::kMouseDown);
+  mouse.modifiers = -1;
+  mouse.x = 10.5f;
+  mouse.y = 20.25f;
+  mouse.click_count = 2;
+  recorder.Record(mouse, start + base::Milliseconds(7));
+
+  SessionEvent scroll;
+  scroll.kind = SessionEvent::Kind::kScroll;
+  scroll.value = 1234;
+  recorder.Record(scroll, start + base::Milliseconds(9));
+
+  SessionEvent callback;
+  callback.kind = SessionEvent::Kind::kCallback;
+  callback.type = 3;
+  callback.payload = std::string(SessionRecorder::kMaxPayloadBytes * 2, 'p');
+  recorder.Record(callback, start + base::Milliseconds(9));
+
+  recorder.Record(Paint(3, true), start + base::Milliseconds(12));
+  std::string trace = recorder.Stop();
+  EXPECT_FALSE(recorder.IsRecording());
+
+  std::vector<SessionEvent> events;
+  ASSERT_TRUE(SessionRecorder::Decode(trace, &events));
+  ASSERT_EQ(events.size(), size_t(5));
+  EXPECT_EQ(events[0].time, base::Milliseconds(5));
+  EXPECT_EQ(events[0].text, u'a');
+  EXPECT_EQ(events[1].modifiers, -1);
+  EXPECT_EQ(events[1].x, 10.5f);
+  EXPECT_EQ(events[1].y, 20.25f);
+  EXPECT_EQ(events[1].click_count, 2);
+  EXPECT_EQ(events[2].value, 1234);
+  EXPECT_EQ(events[3].time, base::Milliseconds(9));
+  EXPECT_EQ(events[3].payload.size(), SessionRecorder::kMaxPayloadBytes);
+  EXPECT_EQ(events[4].duration, base::Milliseconds(3));
+  EXPECT_TRUE(events[4].complete);
+
+  // cut short
+  EXPECT_FALSE(SessionRecorder::Decode(trace.substr(0, trace.size() - 1),
+                                       &events));
+  EXPECT_FALSE(SessionRecorder::Decode("not a trace", &events));
+}
+
+TEST(SessionRecorderTest, AnalyzesLatency) {
+  std::vector<SessionEvent> events;
+  auto add = [&events](SessionEvent event, int ms) {
+    event.time = base::Milliseconds(ms);
+    events.push_back(std::move(event));
+  };
+  add(KeyDown('a'), 0);
+  add(KeyDown('b'), 10);
+  // missing tiles, the keys aren't on screen yet
+  add(Paint(4, false), 20);
+  add(Paint(6, true), 30);
+  add(KeyDown('c'), 40);
+  add(Paint(2, true), 45);
+
+  SessionReport report = SessionReport::Analyze(events);
+  EXPECT_EQ(report.input.count, size_t(3));
+  EXPECT_EQ(report.input.p50, base::Milliseconds(20));
+  EXPECT_EQ(report.input.max, base::Milliseconds(30));
+  EXPECT_EQ(report.paint.count, size_t(3));
+  EXPECT_EQ(report.paint.p50, base::Milliseconds(4));
+  EXPECT_EQ(report.paint.p99, base::Milliseconds(6));
+  EXPECT_EQ(report.callbacks, size_t(0));
+}
+
+}  // namespace electron::office
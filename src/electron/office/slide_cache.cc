@@ -0,0 +1,119 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/slide_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/bind.h"
+#include "base/task/thread_pool.h"
+#include "office/document_image.h"
+#include "office/lok_callback.h"
+#include "office/tile_format.h"
+#include "third_party/skia/include/core/SkColor.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace electron::office {
+
+namespace {
+size_t ImageBytes(const cc::PaintImage& image) {
+  return static_cast<size_t>(image.width()) * image.height() *
+         TileFormat::kBytesPerPx;
+}
+}  // namespace
+
+SlideCache::SlideCache() = default;
+SlideCache::~SlideCache() = default;
+
+cc::PaintImage SlideCache::Get(int part, float scale) {
+  auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) {
+    return e.part == part && e.scale == scale;
+  });
+  if (it == entries_.end())
+    return {};
+
+  entries_.splice(entries_.begin(), entries_, it);
+  return it->image;
+}
+
+void SlideCache::Prerender(DocumentHolderWithView document,
+                           int part,
+                           float scale,
+                           const gfx::Size& slide_twips) {
+  if (!document || part < 0 || slide_twips.IsEmpty() || pending_.count(part))
+    return;
+  if (Get(part, scale))
+    return;
+
+  float width = lok_callback::TwipToPixel(slide_twips.width(), scale);
+  float height = lok_callback::TwipToPixel(slide_twips.height(), scale);
+  // huge zooms are shown at a lower resolution until the tiles catch up
+  const float fit = std::min(
+      1.0f, static_cast<float>(kMaxSidePx) / std::max(width, height));
+  gfx::Size size_px(std::ceil(width * fit), std::ceil(height * fit));
+  if (size_px.IsEmpty())
+    return;
+
+  const uint64_t render_id = next_render_id_++;
+  pending_[part] = render_id;
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::TaskPriority::BEST_EFFORT, base::MayBlock()},
+      base::BindOnce(
+          [](DocumentHolderWithView document, int part,
+             const gfx::Size& size_px, const gfx::Size& slide_twips) {
+            return RenderDocumentImage(document, part, gfx::Rect(slide_twips),
+                                       size_px, SK_ColorTRANSPARENT);
+          },
+          std::move(document), part, size_px, slide_twips),
+      base::BindOnce(&SlideCache::OnRendered, weak_factory_.GetWeakPtr(),
+                     part, scale, render_id));
+}
+
+void SlideCache::OnRendered(int part,
+                            float scale,
+                            uint64_t render_id,
+                            cc::PaintImage image) {
+  auto it = pending_.find(part);
+  if (it == pending_.end() || it->second != render_id)
+    return;
+  pending_.erase(it);
+  if (!image || ImageBytes(image) > kMaxBytes)
+    return;
+
+  // only the latest scale of a slide is kept
+  ErasePart(part);
+  entries_.push_front({part, scale, std::move(image)});
+  bytes_used_ += ImageBytes(entries_.front().image);
+  while (bytes_used_ > kMaxBytes)
+    Erase(std::prev(entries_.end()));
+}
+
+void SlideCache::Invalidate(int part) {
+  ErasePart(part);
+  // a render in flight may predate the change
+  pending_.erase(part);
+}
+
+void SlideCache::ErasePart(int part) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto next = std::next(it);
+    if (it->part == part)
+      Erase(it);
+    it = next;
+  }
+}
+
+void SlideCache::Clear() {
+  entries_.clear();
+  pending_.clear();
+  bytes_used_ = 0;
+}
+
+void SlideCache::Erase(std::list<Entry>::iterator it) {
+  bytes_used_ -= ImageBytes(it->image);
+  entries_.erase(it);
+}
+
+}  // namespace electron::office
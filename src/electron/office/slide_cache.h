@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <list>
+#include <map>
+
+#include "base/memory/weak_ptr.h"
+#include "cc/paint/paint_image.h"
+#include "office/document_holder.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace electron::office {
+
+// Whole-slide surfaces for presentations, so switching to a slide that was
+// seen or prerendered paints immediately instead of waiting on its tiles.
+//
+// Surfaces are rendered with paintPartTile, which doesn't switch the part
+// shown in the view, and memory is bounded by evicting the least recently
+// used slide beyond kMaxBytes.
+class SlideCache {
+ public:
+  SlideCache();
+  ~SlideCache();
+
+  SlideCache(const SlideCache&) = delete;
+  SlideCache& operator=(const SlideCache&) = delete;
+
+  // The surface of `part` rendered at `scale`, or an empty image if there
+  // isn't one. A hit becomes the most recently used.
+  cc::PaintImage Get(int part, float scale);
+
+  // Renders `part` at `scale` in the background unless it's cached or already
+  // being rendered. `slide_twips` is the size of a slide.
+  void Prerender(DocumentHolderWithView document,
+                 int part,
+                 float scale,
+                 const gfx::Size& slide_twips);
+
+  // Drops the surface of `part` and any render of it in flight, after an
+  // edit for instance. Other parts are left alone.
+  void Invalidate(int part);
+  void Clear();
+
+  size_t BytesUsed() const { return bytes_used_; }
+
+  // a few slides on a 4K display
+  static constexpr size_t kMaxBytes = 64 * 1024 * 1024;
+  // the largest side of a surface, in pixels
+  static constexpr int kMaxSidePx = 4096;
+
+ private:
+  struct Entry {
+    int part;
+    float scale;
+    cc::PaintImage image;
+  };
+
+  void OnRendered(int part,
+                  float scale,
+                  uint64_t render_id,
+                  cc::PaintImage image);
+  void ErasePart(int part);
+  void Erase(std::list<Entry>::iterator it);
+
+  // most recently used first
+  std::list<Entry> entries_;
+  size_t bytes_used_ = 0;
+  // parts being rendered, to the render that is current, so a render that
+  // was invalidated in flight is dropped
+  std::map<int, uint64_t> pending_;
+  uint64_t next_render_id_ = 0;
+
+  base::WeakPtrFactory<SlideCache> weak_factory_{this};
+};
+
+}  // namespace electron::office
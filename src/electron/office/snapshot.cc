@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cc/paint/paint_image_builder.h"
+#include "office/tile_format.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkColor.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkPaint.h"
+#include "third_party/skia/include/core/SkSamplingOptions.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+namespace electron::office {
+
+Snapshot::Snapshot() = default;
+Snapshot::Snapshot(cc::PaintImage image_,
+                   float scale_,
+                   const gfx::Rect& rect_,
+                   const gfx::Size& document_size_,
+                   unsigned int scroll_y_position_)
+    : image(std::move(image_)),
+      scale(scale_),
+      rect(rect_),
+      document_size(document_size_),
+      scroll_y_position(scroll_y_position_) {}
+Snapshot::~Snapshot() = default;
+Snapshot::Snapshot(const Snapshot& other) = default;
+Snapshot& Snapshot::operator=(const Snapshot& other) = default;
+Snapshot::Snapshot(Snapshot&& other) noexcept = default;
+Snapshot& Snapshot::operator=(Snapshot&& other) noexcept = default;
+
+size_t Snapshot::Bytes() const {
+  if (IsEmpty())
+    return 0;
+  return static_cast<size_t>(image.width()) * image.height() *
+         TileFormat::kBytesPerPx;
+}
+
+bool Snapshot::Covers(float target_scale, const gfx::Rect& view) const {
+  if (scale <= 0 || target_scale <= 0 || rect.IsEmpty())
+    return false;
+
+  const float rescale = target_scale / scale;
+  if (rescale > kMaxRescale || rescale < 1 / kMaxRescale)
+    return false;
+
+  // the view at the snapshot's scale, only the part within the document
+  // needs to be covered
+  gfx::Rect scaled = gfx::ScaleToEnclosingRect(view, 1 / rescale);
+  scaled.Intersect(gfx::Rect(document_size));
+  return rect.Contains(scaled);
+}
+
+SnapshotTiles::SnapshotTiles() = default;
+SnapshotTiles::~SnapshotTiles() = default;
+SnapshotTiles::SnapshotTiles(SnapshotTiles&& other) noexcept = default;
+SnapshotTiles& SnapshotTiles::operator=(SnapshotTiles&& other) noexcept =
+    default;
+
+gfx::Rect SnapshotRect(const gfx::Rect& view, const gfx::Size& document_size) {
+  const int margin_x = std::ceil(view.width() * Snapshot::kMargin);
+  const int margin_y = std::ceil(view.height() * Snapshot::kMargin);
+  gfx::Rect result(view.x() - margin_x, view.y() - margin_y,
+                   view.width() + 2 * margin_x, view.height() + 2 * margin_y);
+  result.Intersect(gfx::Rect(document_size));
+  return result;
+}
+
+Snapshot FlattenSnapshot(CancelFlagPtr cancel_flag, SnapshotTiles source) {
+  if (source.tiles.empty() || source.rect.IsEmpty())
+    return {};
+
+  // a large margin on a large view is shown at a lower resolution
+  const float downsample = std::min(
+      Snapshot::kDownsample,
+      static_cast<float>(Snapshot::kMaxSidePx) /
+          std::max(source.rect.width(), source.rect.height()));
+  const SkImageInfo image_info = SkImageInfo::Make(
+      std::ceil(source.rect.width() * downsample),
+      std::ceil(source.rect.height() * downsample), source.color_type,
+      kPremul_SkAlphaType);
+  sk_sp<SkSurface> surface = SkSurface::MakeRaster(image_info);
+  if (!surface)
+    return {};
+
+  // tiles missing from the margin are left transparent
+  SkCanvas* canvas = surface->getCanvas();
+  canvas->clear(SK_ColorTRANSPARENT);
+  canvas->scale(downsample, downsample);
+  canvas->translate(-source.rect.x(), -source.rect.y());
+  SkPaint paint;
+  paint.setBlendMode(SkBlendMode::kSrc);
+  for (const SnapshotTiles::Tile& tile : source.tiles) {
+    if (CancelFlag::IsCancelled(cancel_flag))
+      return {};
+    sk_sp<SkImage> image = tile.image ? tile.image.GetSwSkImage() : nullptr;
+    if (!image)
+      continue;
+    canvas->drawImage(image, tile.origin.x(), tile.origin.y(),
+                      SkSamplingOptions(SkFilterMode::kLinear), &paint);
+  }
+
+  return Snapshot(cc::PaintImageBuilder::WithDefault()
+                      .set_id(cc::PaintImage::GetNextId())
+                      .set_image(surface->makeImageSnapshot(),
+                                 cc::PaintImage::GetNextContentId())
+                      .TakePaintImage(),
+                  source.scale, source.rect, source.document_size,
+                  source.scroll_y_position);
+}
+
+}  // namespace electron::office
@@ -0,0 +1,94 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+
+#include "cc/paint/paint_image.h"
+#include "office/cancellation_flag.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
+#include "ui/gfx/geometry/point.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace electron::office {
+
+// The painted tiles around the view flattened into a single downsampled
+// image, shown scaled in place of the tiles missing after a zoom or scroll.
+//
+// A snapshot covers a margin beyond the view, so zooming out shows the
+// document around it instead of blank regions, and stands in for several zoom
+// steps before a new one is taken.
+struct Snapshot {
+  Snapshot();
+  Snapshot(cc::PaintImage image_,
+           float scale_,
+           const gfx::Rect& rect_,
+           const gfx::Size& document_size_,
+           unsigned int scroll_y_position_);
+  ~Snapshot();
+  Snapshot(const Snapshot& other);
+  Snapshot& operator=(const Snapshot& other);
+  Snapshot(Snapshot&& other) noexcept;
+  Snapshot& operator=(Snapshot&& other) noexcept;
+
+  bool IsEmpty() const { return !image; }
+  size_t Bytes() const;
+
+  // Whether the snapshot can stand in for `view`, the visible area in px at
+  // the total scale `scale`, without taking a new one
+  bool Covers(float scale, const gfx::Rect& view) const;
+
+  cc::PaintImage image;
+  // the total scale the tiles were painted at
+  float scale = 0.0f;
+  // the area of the document the image is drawn into, in px at `scale`
+  gfx::Rect rect;
+  // the size of the document in px at `scale`
+  gfx::Size document_size;
+  unsigned int scroll_y_position = 0;
+
+  // the image is at most half the resolution of the tiles
+  static constexpr float kDownsample = 0.5f;
+  // the fraction of the view added on every side, enough to zoom out to
+  // 1 / (1 + 2 * kMargin) of the scale without a blank region
+  static constexpr float kMargin = 0.5f;
+  // how far the scale can move from the snapshot's before it's taken again
+  static constexpr float kMaxRescale = 2.0f;
+  // the largest side of the image, in pixels
+  static constexpr int kMaxSidePx = 4096;
+};
+
+// What a snapshot is flattened from, collected from the tile buffer on the
+// main thread so only references to the tiles cross to the worker
+struct SnapshotTiles {
+  struct Tile {
+    // in px at `scale`
+    gfx::Point origin;
+    cc::PaintImage image;
+  };
+
+  SnapshotTiles();
+  ~SnapshotTiles();
+  SnapshotTiles(SnapshotTiles&& other) noexcept;
+  SnapshotTiles& operator=(SnapshotTiles&& other) noexcept;
+
+  std::vector<Tile> tiles;
+  float scale = 0.0f;
+  gfx::Rect rect;
+  gfx::Size document_size;
+  unsigned int scroll_y_position = 0;
+  SkColorType color_type = kBGRA_8888_SkColorType;
+};
+
+// The area of the document a snapshot of `view` covers, the view grown by
+// Snapshot::kMargin on every side and clipped to the document
+gfx::Rect SnapshotRect(const gfx::Rect& view, const gfx::Size& document_size);
+
+// Draws the tiles into a single downsampled image, returning an empty
+// snapshot if cancelled. Runs on a worker.
+Snapshot FlattenSnapshot(CancelFlagPtr cancel_flag, SnapshotTiles source);
+
+}  // namespace electron::office
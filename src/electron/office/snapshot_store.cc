@@ -0,0 +1,120 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/snapshot_store.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+
+namespace electron::office {
+
+SnapshotStore::Entry::Entry() = default;
+SnapshotStore::Entry::~Entry() = default;
+SnapshotStore::Entry::Entry(Entry&&) = default;
+SnapshotStore::Entry& SnapshotStore::Entry::operator=(Entry&&) = default;
+
+SnapshotStore::SnapshotStore() = default;
+SnapshotStore::~SnapshotStore() = default;
+
+// static
+SnapshotStore* SnapshotStore::Get() {
+  static base::NoDestructor<SnapshotStore> instance;
+  return instance.get();
+}
+
+void SnapshotStore::Put(const base::Token& key,
+                        const Snapshot& snapshot,
+                        float zoom) {
+  const size_t size = snapshot.Bytes();
+  if (size == 0 || size > kMaxBytes) {
+    Discard(key);
+    return;
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.snapshot = snapshot;
+  entry.zoom = zoom;
+  entry.stored = base::TimeTicks::Now();
+
+  base::AutoLock lock(lock_);
+  auto existing = std::find_if(entries_.begin(), entries_.end(),
+                               [&](const Entry& e) { return e.key == key; });
+  if (existing != entries_.end())
+    EraseLocked(existing);
+
+  entries_.emplace_back(std::move(entry));
+  bytes_used_ += size;
+  while (bytes_used_ > kMaxBytes)
+    EraseLocked(entries_.begin());
+
+  if (!expiry_scheduled_ && base::SequencedTaskRunnerHandle::IsSet()) {
+    expiry_scheduled_ = true;
+    // the store is never destroyed
+    base::SequencedTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&SnapshotStore::Expire, base::Unretained(this)),
+        kMaxAge);
+  }
+}
+
+bool SnapshotStore::Take(const base::Token& key,
+                         Snapshot* snapshot,
+                         float* zoom) {
+  base::AutoLock lock(lock_);
+  ExpireLocked(base::TimeTicks::Now());
+  auto it = std::find_if(entries_.begin(), entries_.end(),
+                         [&](const Entry& e) { return e.key == key; });
+  if (it == entries_.end())
+    return false;
+
+  *snapshot = std::move(it->snapshot);
+  *zoom = it->zoom;
+  bytes_used_ -= snapshot->Bytes();
+  entries_.erase(it);
+  return true;
+}
+
+void SnapshotStore::Discard(const base::Token& key) {
+  base::AutoLock lock(lock_);
+  auto it = std::find_if(entries_.begin(), entries_.end(),
+                         [&](const Entry& e) { return e.key == key; });
+  if (it != entries_.end())
+    EraseLocked(it);
+}
+
+size_t SnapshotStore::BytesUsed() {
+  base::AutoLock lock(lock_);
+  ExpireLocked(base::TimeTicks::Now());
+  return bytes_used_;
+}
+
+void SnapshotStore::Expire() {
+  base::AutoLock lock(lock_);
+  expiry_scheduled_ = false;
+  const base::TimeTicks now = base::TimeTicks::Now();
+  ExpireLocked(now);
+  if (entries_.empty() || !base::SequencedTaskRunnerHandle::IsSet())
+    return;
+
+  // until the newer entries expire
+  expiry_scheduled_ = true;
+  base::SequencedTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, base::BindOnce(&SnapshotStore::Expire, base::Unretained(this)),
+      entries_.front().stored + kMaxAge - now);
+}
+
+void SnapshotStore::ExpireLocked(base::TimeTicks now) {
+  while (!entries_.empty() && now - entries_.front().stored >= kMaxAge)
+    EraseLocked(entries_.begin());
+}
+
+void SnapshotStore::EraseLocked(std::list<Entry>::iterator it) {
+  bytes_used_ -= it->snapshot.Bytes();
+  entries_.erase(it);
+}
+
+}  // namespace electron::office
@@ -0,0 +1,81 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <list>
+
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "base/token.h"
+#include "office/snapshot.h"
+
+namespace electron::office {
+
+// Keeps the snapshot of every plugin destroyed with a restore key for a short
+// while.
+//
+// The RendererTransferable held by a DocumentClient is lost with the V8
+// context (on reload, for instance), so a plugin restored after that has
+// nothing to paint until its tiles are rasterized again. The snapshot kept
+// here is shown instead. The image is immutable, so storing it only takes a
+// reference, and it is only ever restored within this process.
+class SnapshotStore {
+ public:
+  static SnapshotStore* Get();
+
+  SnapshotStore(const SnapshotStore&) = delete;
+  SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+  // Keeps `snapshot`, replacing anything stored for `key` and evicting the
+  // oldest snapshots beyond kMaxBytes
+  void Put(const base::Token& key, const Snapshot& snapshot, float zoom);
+
+  // Removes the snapshot for `key`, returning false if there isn't one
+  bool Take(const base::Token& key, Snapshot* snapshot, float* zoom);
+
+  // Drops the snapshot for `key`, if any
+  void Discard(const base::Token& key);
+
+  size_t BytesUsed();
+
+  // enough for the snapshots of a few 4K viewports, which are downsampled
+  static constexpr size_t kMaxBytes = 32 * 1024 * 1024;
+  // a restore follows the unmount within a reload, anything older than this
+  // is unlikely to be restored
+  static constexpr base::TimeDelta kMaxAge = base::Minutes(1);
+
+ private:
+  friend class base::NoDestructor<SnapshotStore>;
+
+  struct Entry {
+    Entry();
+    ~Entry();
+    Entry(Entry&&);
+    Entry& operator=(Entry&&);
+
+    base::Token key;
+    Snapshot snapshot;
+    float zoom = 1.0f;
+    base::TimeTicks stored;
+  };
+
+  SnapshotStore();
+  ~SnapshotStore();
+
+  void Expire();
+  void ExpireLocked(base::TimeTicks now) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void EraseLocked(std::list<Entry>::iterator it)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  base::Lock lock_;
+  // oldest first
+  std::list<Entry> entries_ GUARDED_BY(lock_);
+  size_t bytes_used_ GUARDED_BY(lock_) = 0;
+  bool expiry_scheduled_ GUARDED_BY(lock_) = false;
+};
+
+}  // namespace electron::office
@@ -0,0 +1,44 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/snapshot.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(SnapshotTest, RectHasMarginWithinDocument) {
+  const gfx::Size document(1000, 5000);
+
+  // half the view on every side
+  EXPECT_EQ(SnapshotRect(gfx::Rect(200, 1000, 400, 600), document),
+            gfx::Rect(0, 700, 800, 1200));
+  // clipped at the top and sides of the document
+  EXPECT_EQ(SnapshotRect(gfx::Rect(0, 0, 1000, 600), document),
+            gfx::Rect(0, 0, 1000, 900));
+  // and at the bottom
+  EXPECT_EQ(SnapshotRect(gfx::Rect(0, 4400, 1000, 600), document),
+            gfx::Rect(0, 4100, 1000, 900));
+}
+
+TEST(SnapshotTest, CoversNearbyZoomSteps) {
+  const gfx::Size document(1000, 5000);
+  const gfx::Rect view(0, 1000, 1000, 600);
+  Snapshot snapshot({}, 1.0f, SnapshotRect(view, document), document, 1000);
+
+  EXPECT_TRUE(snapshot.Covers(1.0f, view));
+  // zoomed in, the view covers less of the document
+  EXPECT_TRUE(snapshot.Covers(1.5f, gfx::Rect(0, 1500, 1000, 600)));
+  // zoomed out within the margin
+  EXPECT_TRUE(snapshot.Covers(0.8f, gfx::Rect(0, 800, 1000, 600)));
+  // beyond the margin
+  EXPECT_FALSE(snapshot.Covers(0.5f, gfx::Rect(0, 500, 1000, 600)));
+  // scrolled away
+  EXPECT_FALSE(snapshot.Covers(1.0f, gfx::Rect(0, 3000, 1000, 600)));
+  // too blurry once the scale doubles
+  EXPECT_FALSE(snapshot.Covers(2.5f, gfx::Rect(0, 2500, 1000, 600)));
+
+  EXPECT_FALSE(Snapshot().Covers(1.0f, view));
+}
+
+}  // namespace electron::office
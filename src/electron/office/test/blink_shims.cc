@@ -11,11 +11,17 @@
 namespace blink {
 class WebString {
  public:
+  enum class UTF8ConversionMode {
+    kLenient,
+    kStrict,
+    kStrictReplacingErrorsWithFFFD
+  };
   WebString();
   ~WebString();
   WebString(WebString const&);
   WebString(WebString&&);
   std::string Ascii() const;
+  std::string Utf8(UTF8ConversionMode mode) const;
   static WebString FromUTF8(const char* data, size_t length);
 };
 }  // namespace blink
@@ -28,6 +34,9 @@ WebString::WebString(WebString&&) = default;
 std::string WebString::Ascii() const {
   return "";
 }
+std::string WebString::Utf8(UTF8ConversionMode mode) const {
+  return "";
+}
 WebString WebString::FromUTF8(const char* data, size_t length) {
   return {};
 }
@@ -15,5 +15,8 @@ public:
 	float device_scale_factor_ = 1.0f;
 	std::string css_cursor_ = "default";
 	base::OnceClosure invalidated;
+	int invalidations = 0;
+	int find_match_count_ = -1;
+	int find_selection_ = -1;
 };
 }
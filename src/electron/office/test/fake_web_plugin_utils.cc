@@ -23,10 +23,25 @@ std::string CSSCursor(blink::WebPluginContainer* container) {
 }
 
 void Invalidate(blink::WebPluginContainer* container) {
+  ++container->invalidations;
   if (container->invalidated) {
     std::move(container->invalidated).Run();
   }
 }
+
+void ReportFindMatchCount(blink::WebPluginContainer* container,
+                          int identifier,
+                          int total,
+                          bool final_update) {
+  container->find_match_count_ = total;
+}
+
+void ReportFindSelection(blink::WebPluginContainer* container,
+                         int identifier,
+                         int index,
+                         bool final_update) {
+  container->find_selection_ = index;
+}
 }  // namespace container
 
 namespace input {
@@ -5,6 +5,7 @@
 #include "office_test.h"
 
 #include <memory>
+#include <tuple>
 #include "base/at_exit.h"
 #include "base/bind.h"
 #include "base/check.h"
@@ -12,8 +13,12 @@
 #include "base/guid.h"
 #include "base/notreached.h"
 #include "base/run_loop.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "cc/paint/paint_recorder.h"
+#include "cc/paint/skia_paint_canvas.h"
 #include "gin/arguments.h"
 #include "gin/converter.h"
+#include "gin/dictionary.h"
 #include "gin/object_template_builder.h"
 #include "gin/public/isolate_holder.h"
 #include "gin/try_catch.h"
@@ -23,8 +28,12 @@
 #include "office/office_instance.h"
 #include "office/office_web_plugin.h"
 #include "office/promise.h"
+#include "office/session_recorder.h"
 #include "office/test/fake_render_frame.h"
 #include "office/test/simulated_input.h"
+#include "third_party/blink/public/web/web_print_params.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "v8/include/v8-array-buffer.h"
 #include "v8/include/v8-exception.h"
 #include "v8/include/v8-primitive.h"
 #include "v8/include/v8-value.h"
@@ -42,6 +51,23 @@ class WebCoalescedInputEvent {
 
 namespace electron::office {
 
+namespace {
+// lets the paints of the last replayed event land before the recording stops
+constexpr base::TimeDelta kReplaySettleDelay = base::Milliseconds(500);
+
+v8::Local<v8::Value> DistributionToV8(
+    v8::Isolate* isolate,
+    const SessionReport::Distribution& distribution) {
+  gin::Dictionary dict = gin::Dictionary::CreateEmpty(isolate);
+  dict.Set("count", distribution.count);
+  dict.Set("p50", distribution.p50.InMillisecondsF());
+  dict.Set("p90", distribution.p90.InMillisecondsF());
+  dict.Set("p99", distribution.p99.InMillisecondsF());
+  dict.Set("max", distribution.max.InMillisecondsF());
+  return gin::ConvertToV8(isolate, dict);
+}
+}  // namespace
+
 OfficeTest::OfficeTest() = default;
 OfficeTest::~OfficeTest() = default;
 void OfficeTest::SetUp() {
@@ -385,6 +411,11 @@ v8::Local<v8::ObjectTemplate> PluginTest::GetGlobalTemplate(
                        focused, scripted ? blink::mojom::FocusType::kScript
                                          : blink::mojom::FocusType::kMouse);
                  })
+      .SetMethod("updateVisibility",
+                 [](bool visible) {
+                   DCHECK(self_);
+                   self_->plugin_->UpdateVisibility(visible);
+                 })
       .SetMethod("canUndo",
                  []() {
                    DCHECK(self_);
@@ -410,6 +441,20 @@ v8::Local<v8::ObjectTemplate> PluginTest::GetGlobalTemplate(
             GURL file_url = net::FilePathToFileURL(path);
             return gin::StringToV8(isolate, file_url.spec());
           })
+      .SetMethod(
+          "tempFilePath",
+          [](v8::Isolate* isolate,
+             std::string extension) -> v8::Local<v8::Value> {
+            DCHECK(self_);
+            base::FilePath path;
+            if (!base::GetTempDir(&path)) {
+              NOTREACHED();
+            }
+            path = path.AppendASCII(
+                base::GUID::GenerateRandomV4().AsLowercaseString() + extension);
+            self_->temp_files_to_clean_.emplace_back(path);
+            return gin::StringToV8(isolate, path.AsUTF8Unsafe());
+          })
 
       .SetMethod("fileURLExists",
                  [](std::string url) {
@@ -417,6 +462,23 @@ v8::Local<v8::ObjectTemplate> PluginTest::GetGlobalTemplate(
                    return net::FileURLToFilePath(GURL(url), &path) &&
                           base::PathExists(path);
                  })
+      .SetMethod("printPages",
+                 [](int dpi) {
+                   DCHECK(self_);
+                   blink::WebPrintParams params;
+                   // US Letter with half inch margins, in points
+                   params.print_content_area = gfx::Rect(36, 36, 540, 720);
+                   params.printer_dpi = dpi;
+                   int pages = self_->plugin_->PrintBegin(params);
+                   for (int page = 0; page < pages; ++page) {
+                     cc::PaintRecorder recorder;
+                     self_->plugin_->PrintPage(
+                         page, recorder.beginRecording(612, 792));
+                     recorder.finishRecordingAsPicture();
+                   }
+                   self_->plugin_->PrintEnd();
+                   return pages;
+                 })
       .SetMethod("painted",
                  [](v8::Isolate* isolate) {
                    DCHECK(self_);
@@ -437,6 +499,155 @@ v8::Local<v8::ObjectTemplate> PluginTest::GetGlobalTemplate(
 
                    return resolver->GetPromise();
                  })
+      .SetMethod("invalidations",
+                 []() {
+                   DCHECK(self_);
+                   return self_->plugin_->Container()->invalidations;
+                 })
+      .SetMethod("setHiddenTrimDelay",
+                 [](int ms) {
+                   DCHECK(self_);
+                   self_->plugin_->SetHiddenTrimDelayForTesting(
+                       base::Milliseconds(ms));
+                 })
+      .SetMethod("paintPixel",
+                 [](int x, int y) -> uint32_t {
+                   DCHECK(self_);
+                   SkBitmap bitmap;
+                   bitmap.allocN32Pixels(self_->rect_.width(),
+                                         self_->rect_.height());
+                   bitmap.eraseColor(SK_ColorTRANSPARENT);
+                   cc::SkiaPaintCanvas canvas(bitmap);
+                   self_->plugin_->Paint(&canvas, self_->rect_);
+                   return bitmap.getColor(x, y);
+                 })
+      .SetMethod(
+          "replaySession",
+          [](v8::Isolate* isolate,
+             v8::Local<v8::Value> trace) -> v8::Local<v8::Value> {
+            DCHECK(self_);
+            std::vector<SessionEvent> events;
+            if (!trace->IsArrayBuffer() ||
+                !SessionRecorder::Decode(
+                    std::string_view(
+                        static_cast<const char*>(
+                            trace.As<v8::ArrayBuffer>()->Data()),
+                        trace.As<v8::ArrayBuffer>()->ByteLength()),
+                    &events)) {
+              return v8::Undefined(isolate);
+            }
+
+            v8::Local<v8::Promise::Resolver> resolver =
+                v8::Promise::Resolver::New(isolate->GetCurrentContext())
+                    .ToLocalChecked();
+            auto task_runner = base::ThreadTaskRunnerHandle::Get();
+            self_->plugin_->StartRecording();
+
+            // LOK callbacks and paints are reproduced by LOK and the plugin,
+            // only the input that caused them is sent again
+            base::TimeDelta last;
+            for (const SessionEvent& event : events) {
+              last = event.time;
+              switch (event.kind) {
+                case SessionEvent::Kind::kKey:
+                  task_runner->PostDelayedTask(
+                      FROM_HERE, base::BindOnce([](SessionEvent event) {
+                        auto key = std::make_unique<blink::WebKeyboardEvent>();
+                        key->windows_key_code = event.windows_key_code;
+                        key->dom_code = event.dom_code;
+                        key->dom_key = event.dom_key;
+                        std::fill_n(key->text,
+                                    blink::WebKeyboardEvent::kTextLengthCap, 0);
+                        std::fill_n(key->unmodified_text,
+                                    blink::WebKeyboardEvent::kTextLengthCap, 0);
+                        key->text[0] = event.text;
+                        key->unmodified_text[0] = event.text;
+                        key->SetModifiers(event.modifiers);
+                        key->SetType(static_cast<blink::WebInputEvent::Type>(
+                            event.type));
+                        ui::Cursor cursor;
+                        self_->plugin_->HandleInputEvent(
+                            blink::WebCoalescedInputEvent(std::move(key)),
+                            &cursor);
+                      }, event),
+                      event.time);
+                  break;
+                case SessionEvent::Kind::kMouse:
+                  task_runner->PostDelayedTask(
+                      FROM_HERE, base::BindOnce([](SessionEvent event) {
+                        ui::Cursor cursor;
+                        self_->plugin_->HandleInputEvent(
+                            blink::WebCoalescedInputEvent(
+                                simulated_input::CreateMouseEvent(
+                                    event.type, event.modifiers, event.x,
+                                    event.y, "")),
+                            &cursor);
+                      }, event),
+                      event.time);
+                  break;
+                case SessionEvent::Kind::kScroll:
+                case SessionEvent::Kind::kZoom:
+                  // through the embed, the way the page scrolls and zooms
+                  task_runner->PostDelayedTask(
+                      FROM_HERE, base::BindOnce([](SessionEvent event) {
+                        gin::Runner::Scope scope(self_->runner_.get());
+                        v8::Isolate* isolate =
+                            self_->runner_->GetContextHolder()->isolate();
+                        v8::Local<v8::Context> context =
+                            isolate->GetCurrentContext();
+                        v8::Local<v8::Object> embed =
+                            self_->plugin_->V8ScriptableObject(isolate)
+                                .As<v8::Object>();
+                        const char* name =
+                            event.kind == SessionEvent::Kind::kScroll
+                                ? "updateScroll"
+                                : "setZoom";
+                        v8::Local<v8::Value> method;
+                        if (!embed->Get(context, gin::StringToV8(isolate, name))
+                                 .ToLocal(&method) ||
+                            !method->IsFunction())
+                          return;
+                        v8::Local<v8::Value> argv[] = {
+                            gin::ConvertToV8(isolate, event.value)};
+                        std::ignore = method.As<v8::Function>()->Call(
+                            context, embed, std::size(argv), argv);
+                      }, event),
+                      event.time);
+                  break;
+                case SessionEvent::Kind::kCallback:
+                case SessionEvent::Kind::kPaint:
+                  break;
+              }
+            }
+
+            task_runner->PostDelayedTask(
+                FROM_HERE,
+                base::BindOnce(
+                    [](v8::Global<v8::Promise::Resolver> resolver,
+                       v8::Isolate* isolate) {
+                      gin::Runner::Scope scope(self_->runner_.get());
+                      std::vector<SessionEvent> replayed;
+                      SessionRecorder::Decode(self_->plugin_->StopRecording(),
+                                              &replayed);
+                      SessionReport report = SessionReport::Analyze(replayed);
+                      gin::Dictionary result =
+                          gin::Dictionary::CreateEmpty(isolate);
+                      result.Set("input",
+                                 DistributionToV8(isolate, report.input));
+                      result.Set("paint",
+                                 DistributionToV8(isolate, report.paint));
+                      result.Set("callbacks", report.callbacks);
+                      resolver.Get(isolate)
+                          ->Resolve(isolate->GetCurrentContext(),
+                                    gin::ConvertToV8(isolate, result))
+                          .Check();
+                    },
+                    v8::Global<v8::Promise::Resolver>(isolate, resolver),
+                    isolate),
+                last + kReplaySettleDelay);
+
+            return resolver->GetPromise();
+          })
       .SetMethod("remountEmbed",
                  []() {
                    DCHECK(self_);
@@ -0,0 +1,104 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/text_index.h"
+
+#include <algorithm>
+
+#include "base/hash/hash.h"
+#include "base/strings/string_util.h"
+
+namespace electron::office {
+
+namespace {
+constexpr std::string_view kUtf8Bom = "\xEF\xBB\xBF";
+
+std::vector<uint32_t> Hashes(const std::vector<TextParagraph>& paragraphs) {
+  std::vector<uint32_t> hashes;
+  hashes.reserve(paragraphs.size());
+  for (const TextParagraph& paragraph : paragraphs)
+    hashes.push_back(paragraph.hash);
+  return hashes;
+}
+}  // namespace
+
+TextParagraph::TextParagraph() = default;
+TextParagraph::~TextParagraph() = default;
+TextParagraph::TextParagraph(const TextParagraph&) = default;
+TextParagraph& TextParagraph::operator=(const TextParagraph&) = default;
+TextParagraph::TextParagraph(TextParagraph&&) = default;
+TextParagraph& TextParagraph::operator=(TextParagraph&&) = default;
+
+TextIndex::TextIndex() = default;
+TextIndex::~TextIndex() = default;
+
+// static
+std::vector<TextParagraph> TextIndex::Split(std::string_view text) {
+  std::vector<TextParagraph> result;
+  size_t start = base::StartsWith(text, kUtf8Bom) ? kUtf8Bom.size() : 0;
+  // empty text is an empty document, not a single empty paragraph
+  if (start == text.size())
+    return result;
+
+  while (true) {
+    size_t end = text.find_first_of("\r\n", start);
+    TextParagraph& paragraph = result.emplace_back();
+    paragraph.index = result.size() - 1;
+    paragraph.offset = start;
+    paragraph.text.assign(text.substr(start, end - start));
+    paragraph.hash = base::PersistentHash(paragraph.text);
+    if (end == std::string_view::npos)
+      break;
+
+    // \r\n on Windows, \n elsewhere
+    start = end + 1;
+    if (text[end] == '\r' && start < text.size() && text[start] == '\n')
+      ++start;
+    // the text ends with a line break
+    if (start == text.size())
+      break;
+  }
+
+  return result;
+}
+
+TextIndex::Diff TextIndex::Compare(
+    const std::vector<TextParagraph>& paragraphs,
+    uint64_t since) const {
+  Diff diff;
+  const std::vector<uint32_t> hashes = Hashes(paragraphs);
+
+  const size_t common = std::min(hashes.size(), hashes_.size());
+  size_t prefix = 0;
+  while (prefix < common && hashes[prefix] == hashes_[prefix])
+    ++prefix;
+  size_t suffix = 0;
+  while (suffix < common - prefix &&
+         hashes[hashes.size() - suffix - 1] ==
+             hashes_[hashes_.size() - suffix - 1])
+    ++suffix;
+
+  if (since == 0 || since != revision_) {
+    diff.full = true;
+    diff.removed = hashes_.size();
+    diff.inserted = hashes.size();
+  } else {
+    diff.start = prefix;
+    diff.removed = hashes_.size() - prefix - suffix;
+    diff.inserted = hashes.size() - prefix - suffix;
+  }
+  return diff;
+}
+
+TextIndex::Diff TextIndex::Update(const std::vector<TextParagraph>& paragraphs,
+                                  uint64_t since) {
+  Diff diff = Compare(paragraphs, since);
+  std::vector<uint32_t> hashes = Hashes(paragraphs);
+  if (revision_ == 0 || hashes != hashes_)
+    ++revision_;
+  hashes_ = std::move(hashes);
+  return diff;
+}
+
+}  // namespace electron::office
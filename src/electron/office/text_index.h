@@ -0,0 +1,81 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ui/gfx/geometry/rect.h"
+
+namespace electron::office {
+
+// A paragraph from the plain text of a document
+struct TextParagraph {
+  TextParagraph();
+  ~TextParagraph();
+  TextParagraph(const TextParagraph&);
+  TextParagraph& operator=(const TextParagraph&);
+  TextParagraph(TextParagraph&&);
+  TextParagraph& operator=(TextParagraph&&);
+
+  int index = 0;
+  uint32_t hash = 0;
+  std::string text;
+  // byte offset of the paragraph in the text
+  size_t offset = 0;
+  // only known when positions are requested, -1 otherwise
+  int page = -1;
+  // in twips
+  std::vector<gfx::Rect> rects;
+};
+
+// The paragraph hashes of the last extraction, used to report only the
+// paragraphs that changed since a revision.
+//
+// LOK has no paragraph-level change tracking, so changes are found by
+// trimming the common prefix and suffix of the hashes, which is exact for a
+// single contiguous edit and conservative for several.
+class TextIndex {
+ public:
+  struct Diff {
+    // the first changed paragraph
+    size_t start = 0;
+    // the number of paragraphs from the previous revision replaced at start
+    size_t removed = 0;
+    // the number of paragraphs that replaced them
+    size_t inserted = 0;
+    // the diff covers every paragraph because `since` was not the latest
+    bool full = false;
+  };
+
+  TextIndex();
+  ~TextIndex();
+
+  TextIndex(const TextIndex&) = delete;
+  TextIndex& operator=(const TextIndex&) = delete;
+
+  // Splits plain text into paragraphs, one per line
+  static std::vector<TextParagraph> Split(std::string_view text);
+
+  // Returns what changed in `paragraphs` relative to the revision `since`,
+  // without replacing the indexed paragraphs
+  Diff Compare(const std::vector<TextParagraph>& paragraphs,
+               uint64_t since) const;
+
+  // Replaces the indexed paragraphs, returning what changed relative to the
+  // revision `since`
+  Diff Update(const std::vector<TextParagraph>& paragraphs, uint64_t since);
+
+  // Incremented whenever an update changes the paragraphs, 0 before the first
+  uint64_t Revision() const { return revision_; }
+
+ private:
+  std::vector<uint32_t> hashes_;
+  uint64_t revision_ = 0;
+};
+
+}  // namespace electron::office
@@ -0,0 +1,88 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/text_index.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(TextIndexTest, SplitsParagraphs) {
+  EXPECT_TRUE(TextIndex::Split("").empty());
+  EXPECT_TRUE(TextIndex::Split("\xEF\xBB\xBF").empty());
+
+  auto paragraphs = TextIndex::Split("\xEF\xBB\xBF" "one\r\n\r\ntwo\nthree\n");
+  ASSERT_EQ(paragraphs.size(), size_t(4));
+  EXPECT_EQ(paragraphs[0].text, "one");
+  EXPECT_EQ(paragraphs[0].offset, size_t(3));
+  EXPECT_EQ(paragraphs[1].text, "");
+  EXPECT_EQ(paragraphs[2].text, "two");
+  EXPECT_EQ(paragraphs[2].index, 2);
+  EXPECT_EQ(paragraphs[3].text, "three");
+  EXPECT_EQ(paragraphs[3].offset, size_t(14));
+  EXPECT_NE(paragraphs[0].hash, paragraphs[2].hash);
+}
+
+TEST(TextIndexTest, DiffsAgainstLatestRevision) {
+  TextIndex index;
+  EXPECT_EQ(index.Revision(), uint64_t(0));
+
+  auto diff = index.Update(TextIndex::Split("a\nb\nc\nd"), 0);
+  EXPECT_TRUE(diff.full);
+  EXPECT_EQ(diff.inserted, size_t(4));
+  const uint64_t first = index.Revision();
+  EXPECT_EQ(first, uint64_t(1));
+
+  // unchanged
+  diff = index.Update(TextIndex::Split("a\nb\nc\nd"), first);
+  EXPECT_FALSE(diff.full);
+  EXPECT_EQ(diff.removed, size_t(0));
+  EXPECT_EQ(diff.inserted, size_t(0));
+  EXPECT_EQ(index.Revision(), first);
+
+  // b is replaced by two paragraphs
+  diff = index.Update(TextIndex::Split("a\nx\ny\nc\nd"), first);
+  EXPECT_FALSE(diff.full);
+  EXPECT_EQ(diff.start, size_t(1));
+  EXPECT_EQ(diff.removed, size_t(1));
+  EXPECT_EQ(diff.inserted, size_t(2));
+  EXPECT_EQ(index.Revision(), first + 1);
+
+  // a stale revision gets everything
+  diff = index.Update(TextIndex::Split("a\nx\nc\nd"), first);
+  EXPECT_TRUE(diff.full);
+  EXPECT_EQ(diff.removed, size_t(5));
+  EXPECT_EQ(diff.inserted, size_t(4));
+}
+
+TEST(TextIndexTest, ComparesWithoutUpdating) {
+  TextIndex index;
+  index.Update(TextIndex::Split("a\nb\nc"), 0);
+  const uint64_t first = index.Revision();
+
+  auto diff = index.Compare(TextIndex::Split("a\nx\nc"), first);
+  EXPECT_FALSE(diff.full);
+  EXPECT_EQ(diff.start, size_t(1));
+  EXPECT_EQ(diff.removed, size_t(1));
+  EXPECT_EQ(diff.inserted, size_t(1));
+  EXPECT_EQ(index.Revision(), first);
+
+  // the change is still reported against the same revision
+  diff = index.Update(TextIndex::Split("a\nx\nc"), first);
+  EXPECT_EQ(diff.start, size_t(1));
+  EXPECT_EQ(diff.inserted, size_t(1));
+  EXPECT_EQ(index.Revision(), first + 1);
+}
+
+TEST(TextIndexTest, DiffsRepeatedParagraphs) {
+  TextIndex index;
+  index.Update(TextIndex::Split("a\na\na"), 0);
+
+  // the common suffix can't overlap the common prefix
+  auto diff = index.Update(TextIndex::Split("a\na\na\na"), index.Revision());
+  EXPECT_EQ(diff.start, size_t(3));
+  EXPECT_EQ(diff.removed, size_t(0));
+  EXPECT_EQ(diff.inserted, size_t(1));
+}
+
+}  // namespace electron::office
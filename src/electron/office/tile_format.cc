@@ -0,0 +1,51 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/tile_format.h"
+
+#include "LibreOfficeKit/LibreOfficeKitEnums.h"
+
+namespace electron::office {
+
+namespace {
+// a device scale considered HiDPI, 4K displays are usually scaled 2x
+constexpr float kHighDeviceScale = 2.0f;
+}  // namespace
+
+SkImageInfo TileFormat::ImageInfo() const {
+  return SkImageInfo::Make(size_px, size_px, color_type, kPremul_SkAlphaType);
+}
+
+bool TileFormat::operator==(const TileFormat& other) const {
+  return size_px == other.size_px && color_type == other.color_type;
+}
+
+bool TileFormat::operator!=(const TileFormat& other) const {
+  return !(*this == other);
+}
+
+SkColorType TileColorType(int tile_mode) {
+  return tile_mode == LOK_TILEMODE_RGBA ? kRGBA_8888_SkColorType
+                                        : kBGRA_8888_SkColorType;
+}
+
+TileFormat ChooseTileFormat(int document_type,
+                            int tile_mode,
+                            float device_scale) {
+  TileFormat format;
+  format.color_type = TileColorType(tile_mode);
+
+  const bool high_dpi = device_scale >= kHighDeviceScale;
+  if (document_type == LOK_DOCTYPE_SPREADSHEET) {
+    // on HiDPI a 256px tile covers the same cells as a 128px tile at 1x
+    format.size_px =
+        high_dpi ? TileFormat::kDefaultSizePx : TileFormat::kMinSizePx;
+  } else {
+    format.size_px =
+        high_dpi ? TileFormat::kMaxSizePx : TileFormat::kDefaultSizePx;
+  }
+  return format;
+}
+
+}  // namespace electron::office
@@ -0,0 +1,43 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+
+#include "third_party/skia/include/core/SkImageInfo.h"
+
+namespace electron::office {
+
+// How the tiles of a TileBuffer are rasterized
+struct TileFormat {
+  static constexpr int kDefaultSizePx = 256;
+  // the smallest tile sets the number of tiles the pool can hold
+  static constexpr int kMinSizePx = 128;
+  static constexpr int kMaxSizePx = 512;
+  // both color types LOK paints are 32-bit
+  static constexpr size_t kBytesPerPx = 4;
+
+  int size_px = kDefaultSizePx;
+  SkColorType color_type = kBGRA_8888_SkColorType;
+
+  size_t Bytes() const { return size_px * size_px * kBytesPerPx; }
+  SkImageInfo ImageInfo() const;
+
+  bool operator==(const TileFormat& other) const;
+  bool operator!=(const TileFormat& other) const;
+};
+
+// The color type of what LOK paints in `tile_mode`, a LibreOfficeKitTileMode
+SkColorType TileColorType(int tile_mode);
+
+// Larger tiles on HiDPI displays, where the overhead of each paintTile call
+// dominates, and smaller tiles for spreadsheets, where edits invalidate
+// single cells and a large tile repaints mostly unchanged pixels.
+// `document_type` is a LibreOfficeKitDocumentType.
+TileFormat ChooseTileFormat(int document_type,
+                            int tile_mode,
+                            float device_scale);
+
+}  // namespace electron::office
@@ -0,0 +1,40 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/tile_format.h"
+#include "LibreOfficeKit/LibreOfficeKitEnums.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace electron::office {
+
+TEST(TileFormatTest, ChoosesSizeByDocumentAndDevice) {
+  EXPECT_EQ(ChooseTileFormat(LOK_DOCTYPE_TEXT, LOK_TILEMODE_BGRA, 1).size_px,
+            256);
+  EXPECT_EQ(ChooseTileFormat(LOK_DOCTYPE_TEXT, LOK_TILEMODE_BGRA, 2).size_px,
+            512);
+  EXPECT_EQ(
+      ChooseTileFormat(LOK_DOCTYPE_PRESENTATION, LOK_TILEMODE_BGRA, 2.5)
+          .size_px,
+      512);
+  EXPECT_EQ(
+      ChooseTileFormat(LOK_DOCTYPE_SPREADSHEET, LOK_TILEMODE_BGRA, 1).size_px,
+      128);
+  EXPECT_EQ(
+      ChooseTileFormat(LOK_DOCTYPE_SPREADSHEET, LOK_TILEMODE_BGRA, 2).size_px,
+      256);
+}
+
+TEST(TileFormatTest, FollowsTileMode) {
+  EXPECT_EQ(TileColorType(LOK_TILEMODE_BGRA), kBGRA_8888_SkColorType);
+  EXPECT_EQ(TileColorType(LOK_TILEMODE_RGBA), kRGBA_8888_SkColorType);
+
+  TileFormat format =
+      ChooseTileFormat(LOK_DOCTYPE_TEXT, LOK_TILEMODE_RGBA, 1);
+  EXPECT_EQ(format.color_type, kRGBA_8888_SkColorType);
+  EXPECT_EQ(format.Bytes(), size_t(256 * 256 * 4));
+  EXPECT_EQ(format.ImageInfo().width(), 256);
+  EXPECT_NE(format, TileFormat());
+}
+
+}  // namespace electron::office
@@ -0,0 +1,326 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#include "office/uno_bulk.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/ranges/algorithm.h"
+#include "gin/converter.h"
+#include "v8/include/v8-exception.h"
+#include "v8/include/v8-function.h"
+#include "v8/include/v8-isolate.h"
+#include "v8/include/v8-object.h"
+#include "v8/include/v8-primitive.h"
+#include "v8/include/v8-typed-array.h"
+
+namespace electron::office::uno_bulk {
+
+namespace {
+
+// A method of UNO interface wrappers, resolved once per prototype. The
+// method a prototype has doesn't depend on the UNO type of the wrapper.
+class MethodCache {
+ public:
+  explicit MethodCache(v8::Local<v8::Value> name) : name_(name) {}
+
+  // `object`'s method, or an empty handle if it has none
+  v8::Local<v8::Function> Get(v8::Local<v8::Context> context,
+                              v8::Local<v8::Object> object) {
+    v8::Local<v8::Value> prototype = object->GetPrototype();
+    for (const auto& [cached_prototype, method] : methods_) {
+      if (cached_prototype->StrictEquals(prototype))
+        return method;
+    }
+
+    v8::Local<v8::Value> value;
+    v8::Local<v8::Function> method;
+    if (object->Get(context, name_).ToLocal(&value) && value->IsFunction())
+      method = value.As<v8::Function>();
+    methods_.emplace_back(prototype, method);
+    return method;
+  }
+
+ private:
+  v8::Local<v8::Value> name_;
+  std::vector<std::pair<v8::Local<v8::Value>, v8::Local<v8::Function>>>
+      methods_;
+};
+
+// Reads the properties of one object after another into columns.
+//
+// Wrappers of different UNO types can share a prototype, so an object is
+// always queried for its interfaces. What is learned per prototype, which
+// stands in for the type, only orders the attempts: after XMultiPropertySet
+// failed for a prototype, like it does for a property the type doesn't
+// have, XPropertySet is tried first for the next objects with it. A wrong
+// guess costs a call, never a value.
+class BulkReader {
+ public:
+  BulkReader(v8::Local<v8::Context> context,
+             const std::vector<v8::Local<v8::Value>>& names,
+             const std::vector<uint32_t>& sorted_order,
+             std::vector<std::vector<v8::Local<v8::Value>>>* columns)
+      : context_(context),
+        isolate_(context->GetIsolate()),
+        names_(names),
+        sorted_order_(sorted_order),
+        columns_(columns),
+        multi_property_set_(
+            gin::StringToV8(isolate_, "beans.XMultiPropertySet")),
+        property_set_(gin::StringToV8(isolate_, "beans.XPropertySet")),
+        as_(gin::StringToSymbol(isolate_, "as")),
+        get_property_values_(
+            gin::StringToSymbol(isolate_, "getPropertyValues")),
+        get_property_value_(gin::StringToSymbol(isolate_, "getPropertyValue")) {
+    std::vector<v8::Local<v8::Value>> sorted_names;
+    sorted_names.reserve(names.size());
+    for (uint32_t n : sorted_order)
+      sorted_names.push_back(names[n]);
+    // converted to a UNO sequence by the bridge on every call, but built once
+    sorted_names_ =
+        v8::Array::New(isolate_, sorted_names.data(), sorted_names.size());
+  }
+
+  // reads the properties of `object` into row `row`
+  void Read(v8::Local<v8::Object> object, uint32_t row) {
+    v8::TryCatch try_catch(isolate_);
+    v8::Local<v8::Value> prototype = object->GetPrototype();
+    const bool skip_multiple = base::ranges::any_of(
+        multiple_failed_, [&](v8::Local<v8::Value> failed) {
+          return failed->StrictEquals(prototype);
+        });
+    if (!skip_multiple) {
+      if (ReadMultiple(object, row))
+        return;
+      multiple_failed_.push_back(prototype);
+      // not a XMultiPropertySet, or a property it doesn't know
+      try_catch.Reset();
+    }
+    if (ReadEach(object, row) || !skip_multiple)
+      return;
+    try_catch.Reset();
+    ReadMultiple(object, row);
+  }
+
+ private:
+  // `object` as the interface `type`, or an empty handle if it doesn't
+  // support it
+  v8::Local<v8::Object> Query(v8::Local<v8::Object> object,
+                              v8::Local<v8::Value> type) {
+    v8::Local<v8::Function> as = as_.Get(context_, object);
+    v8::Local<v8::Value> argv[] = {type};
+    v8::Local<v8::Value> result;
+    if (as.IsEmpty() || !as->Call(context_, object, 1, argv).ToLocal(&result) ||
+        !result->IsObject()) {
+      return {};
+    }
+    return result.As<v8::Object>();
+  }
+
+  // every property in a single call
+  bool ReadMultiple(v8::Local<v8::Object> object, uint32_t row) {
+    v8::Local<v8::Object> multi = Query(object, multi_property_set_);
+    if (multi.IsEmpty())
+      return false;
+    v8::Local<v8::Function> method = get_property_values_.Get(context_, multi);
+    v8::Local<v8::Value> argv[] = {sorted_names_};
+    v8::Local<v8::Value> result;
+    if (method.IsEmpty() ||
+        !method->Call(context_, multi, 1, argv).ToLocal(&result) ||
+        !result->IsArray() ||
+        result.As<v8::Array>()->Length() != names_.size()) {
+      return false;
+    }
+    for (uint32_t n = 0; n < names_.size(); ++n) {
+      v8::Local<v8::Value>& cell = (*columns_)[sorted_order_[n]][row];
+      if (!result.As<v8::Array>()->Get(context_, n).ToLocal(&cell))
+        cell = v8::Undefined(isolate_);
+    }
+    return true;
+  }
+
+  // one call per property
+  bool ReadEach(v8::Local<v8::Object> object, uint32_t row) {
+    v8::Local<v8::Object> single = Query(object, property_set_);
+    if (single.IsEmpty())
+      return false;
+    v8::Local<v8::Function> method = get_property_value_.Get(context_, single);
+    if (method.IsEmpty())
+      return false;
+    for (uint32_t n = 0; n < names_.size(); ++n) {
+      v8::TryCatch try_catch(isolate_);
+      v8::Local<v8::Value> argv[] = {names_[n]};
+      v8::Local<v8::Value>& cell = (*columns_)[n][row];
+      // an unknown property throws, only that property is undefined
+      if (!method->Call(context_, single, 1, argv).ToLocal(&cell))
+        cell = v8::Undefined(isolate_);
+    }
+    return true;
+  }
+
+  v8::Local<v8::Context> context_;
+  v8::Isolate* isolate_;
+  const std::vector<v8::Local<v8::Value>>& names_;
+  const std::vector<uint32_t>& sorted_order_;
+  std::vector<std::vector<v8::Local<v8::Value>>>* columns_;
+  v8::Local<v8::Array> sorted_names_;
+
+  v8::Local<v8::Value> multi_property_set_;
+  v8::Local<v8::Value> property_set_;
+  MethodCache as_;
+  MethodCache get_property_values_;
+  MethodCache get_property_value_;
+  // the prototypes XMultiPropertySet failed for
+  std::vector<v8::Local<v8::Value>> multiple_failed_;
+};
+
+bool IsStruct(v8::Local<v8::Value> value) {
+  return value->IsObject() && !value->IsArray() && !value->IsFunction();
+}
+
+v8::Local<v8::Float64Array> ToFloat64Array(v8::Isolate* isolate,
+                                           const std::vector<double>& values) {
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, values.size() * sizeof(double));
+  if (!values.empty()) {
+    std::memcpy(buffer->GetBackingStore()->Data(), values.data(),
+                values.size() * sizeof(double));
+  }
+  return v8::Float64Array::New(buffer, 0, values.size());
+}
+
+// {fields, values} if every value is a struct with the same numeric fields
+v8::Local<v8::Value> ToStructColumn(
+    v8::Local<v8::Context> context,
+    const std::vector<v8::Local<v8::Value>>& column) {
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::Local<v8::Array> fields;
+  if (column.empty() || !IsStruct(column.front()) ||
+      !column.front().As<v8::Object>()->GetOwnPropertyNames(context).ToLocal(
+          &fields) ||
+      fields->Length() == 0) {
+    return {};
+  }
+
+  const uint32_t stride = fields->Length();
+  std::vector<v8::Local<v8::Value>> field_names;
+  for (uint32_t i = 0; i < stride; ++i) {
+    v8::Local<v8::Value> field;
+    if (!fields->Get(context, i).ToLocal(&field))
+      return {};
+    field_names.push_back(field);
+  }
+
+  std::vector<double> values;
+  values.reserve(column.size() * stride);
+  for (v8::Local<v8::Value> value : column) {
+    v8::Local<v8::Array> value_fields;
+    if (!IsStruct(value) ||
+        !value.As<v8::Object>()->GetOwnPropertyNames(context).ToLocal(
+            &value_fields) ||
+        value_fields->Length() != stride) {
+      return {};
+    }
+    for (v8::Local<v8::Value> field : field_names) {
+      v8::Local<v8::Value> field_value;
+      if (!value.As<v8::Object>()->Get(context, field).ToLocal(&field_value) ||
+          !field_value->IsNumber()) {
+        return {};
+      }
+      values.push_back(field_value.As<v8::Number>()->Value());
+    }
+  }
+
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  if (result
+          ->Set(context, gin::StringToSymbol(isolate, "fields"),
+                v8::Array::New(isolate, field_names.data(), stride))
+          .IsNothing() ||
+      result
+          ->Set(context, gin::StringToSymbol(isolate, "values"),
+                ToFloat64Array(isolate, values))
+          .IsNothing()) {
+    return {};
+  }
+  return result;
+}
+
+v8::Local<v8::Value> ToColumn(v8::Local<v8::Context> context,
+                              std::vector<v8::Local<v8::Value>>& column) {
+  v8::Isolate* isolate = context->GetIsolate();
+  std::vector<double> numbers;
+  numbers.reserve(column.size());
+  for (v8::Local<v8::Value> value : column) {
+    if (!value->IsNumber())
+      break;
+    numbers.push_back(value.As<v8::Number>()->Value());
+  }
+  if (numbers.size() == column.size())
+    return ToFloat64Array(isolate, numbers);
+
+  v8::Local<v8::Value> structs = ToStructColumn(context, column);
+  if (!structs.IsEmpty())
+    return structs;
+
+  return v8::Array::New(isolate, column.data(), column.size());
+}
+
+}  // namespace
+
+v8::MaybeLocal<v8::Object> GetPropertyValues(v8::Local<v8::Context> context,
+                                             v8::Local<v8::Array> objects,
+                                             v8::Local<v8::Array> names) {
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::EscapableHandleScope handle_scope(isolate);
+  v8::TryCatch try_catch(isolate);
+
+  const uint32_t name_count = names->Length();
+  std::vector<v8::Local<v8::Value>> name_values;
+  std::vector<std::string> name_strings;
+  name_values.reserve(name_count);
+  for (uint32_t i = 0; i < name_count; ++i) {
+    v8::Local<v8::Value> name;
+    if (!names->Get(context, i).ToLocal(&name) || !name->IsString())
+      return {};
+    name_values.push_back(name);
+    name_strings.push_back(gin::V8ToString(isolate, name));
+  }
+
+  // getPropertyValues expects the names in ascending order
+  std::vector<uint32_t> sorted_order(name_count);
+  std::iota(sorted_order.begin(), sorted_order.end(), 0);
+  std::sort(sorted_order.begin(), sorted_order.end(),
+            [&](uint32_t a, uint32_t b) {
+              return name_strings[a] < name_strings[b];
+            });
+
+  const uint32_t object_count = objects->Length();
+  std::vector<std::vector<v8::Local<v8::Value>>> columns(
+      name_count, std::vector<v8::Local<v8::Value>>(object_count,
+                                                    v8::Undefined(isolate)));
+
+  BulkReader reader(context, name_values, sorted_order, &columns);
+  for (uint32_t i = 0; i < object_count; ++i) {
+    v8::Local<v8::Value> value;
+    if (!objects->Get(context, i).ToLocal(&value) || !value->IsObject())
+      continue;
+    reader.Read(value.As<v8::Object>(), i);
+  }
+
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  for (uint32_t n = 0; n < name_count; ++n) {
+    if (result->Set(context, name_values[n], ToColumn(context, columns[n]))
+            .IsNothing())
+      return {};
+  }
+  return handle_scope.Escape(result);
+}
+
+}  // namespace electron::office::uno_bulk
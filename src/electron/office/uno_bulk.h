@@ -0,0 +1,33 @@
+// Copyright (c) 2023 Macro.
+// Use of this source code is governed by the MIT license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "v8/include/v8-array-buffer.h"
+#include "v8/include/v8-container.h"
+#include "v8/include/v8-context.h"
+#include "v8/include/v8-local-handle.h"
+
+namespace electron::office::uno_bulk {
+
+// Reads the properties `names` of every UNO object in `objects`, which are
+// wrappers from the UNO bridge, returning one column per name.
+//
+// Every crossing of the bridge converts its arguments and result, so instead
+// of a getPropertyValue per object and property the properties of an object
+// are read with a single XMultiPropertySet.getPropertyValues when the object
+// supports it. The objects can be of different UNO types. The methods of
+// the wrappers are looked up once per prototype, and a prototype whose
+// objects couldn't be read with XMultiPropertySet is read with XPropertySet
+// first.
+//
+// A column of numbers is a Float64Array, a column of structs with the same
+// numeric fields (awt.Point, awt.Size...) is {fields, values} with the fields
+// interleaved in a Float64Array, and anything else is an Array. A property
+// that can't be read is undefined.
+v8::MaybeLocal<v8::Object> GetPropertyValues(v8::Local<v8::Context> context,
+                                             v8::Local<v8::Array> objects,
+                                             v8::Local<v8::Array> names);
+
+}  // namespace electron::office::uno_bulk
@@ -38,6 +38,20 @@ std::string CSSCursor(blink::WebPluginContainer* container) {
 void Invalidate(blink::WebPluginContainer* container) {
   container->Invalidate();
 }
+
+void ReportFindMatchCount(blink::WebPluginContainer* container,
+                          int identifier,
+                          int total,
+                          bool final_update) {
+  container->ReportFindInPageMatchCount(identifier, total, final_update);
+}
+
+void ReportFindSelection(blink::WebPluginContainer* container,
+                         int identifier,
+                         int index,
+                         bool final_update) {
+  container->ReportFindInPageSelection(identifier, index, final_update);
+}
 }  // namespace container
 
 namespace input {
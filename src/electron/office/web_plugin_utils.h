@@ -32,6 +32,14 @@ float DeviceScale(blink::WebPluginContainer* container);
 bool Initialize(blink::WebPluginContainer* container);
 std::string CSSCursor(blink::WebPluginContainer* container);
 void Invalidate(blink::WebPluginContainer* container);
+void ReportFindMatchCount(blink::WebPluginContainer* container,
+                          int identifier,
+                          int total,
+                          bool final_update);
+void ReportFindSelection(blink::WebPluginContainer* container,
+                         int identifier,
+                         int index,
+                         bool final_update);
 }  // namespace container
 
 namespace input {
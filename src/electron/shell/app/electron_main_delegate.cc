@@ -42,6 +42,7 @@
 #include "shell/renderer/electron_renderer_client.h"
 #include "shell/renderer/electron_sandboxed_renderer_client.h"
 #include "shell/utility/electron_content_utility_client.h"
+#include "office/office_instance.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "ui/base/ui_base_switches.h"
 
@@ -391,6 +392,15 @@ void ElectronMainDelegate::PreSandboxStartup() {
   crash_keys::SetPlatformCrashKey();
 #endif
 
+#if BUILDFLAG(ENABLE_OFFICE) && BUILDFLAG(IS_LINUX)
+  // renderers are forked from the zygote, so LOK loaded here is shared by
+  // every renderer that later calls OfficeInstance::Create()
+  if (process_type == ::switches::kZygoteProcess &&
+      command_line->HasSwitch(sandbox::policy::switches::kNoSandbox)) {
+    office::OfficeInstance::PreInitForFork();
+  }
+#endif
+
   if (IsBrowserProcess(command_line)) {
     // Only append arguments for browser process.
 